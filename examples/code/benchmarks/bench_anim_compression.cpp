@@ -0,0 +1,286 @@
+#include "benchmarks.h"
+
+#include "ecs/ecs_resources.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    const u32 k_num_rigs = 100;
+    const u32 k_num_joints = 80;
+    const u32 k_num_keys = 300; // 10 seconds at 30 keys per second
+    const f32 k_key_step = 1.0f / 30.0f;
+    const u32 k_num_updates = 600;
+    const u32 k_elements = 10; // translate xyz, scale xyz, quat
+    const u32 k_packed = 9;    // u16 translate xyz, scale xyz, 3 smallest quat components
+
+    // matches quantize_range in compress_animations.py
+    u16 quantize_range(f32 v, f32 range_min, f32 extent)
+    {
+        if (extent <= 0.0f)
+            return 0;
+
+        return (u16)roundf(std::min(std::max((v - range_min) / extent, 0.0f), 1.0f) * 65535.0f);
+    }
+
+    // matches quantize_quat in compress_animations.py
+    void quantize_quat(const f32* q, u16* out)
+    {
+        u32 largest = 0;
+        for (u32 i = 1; i < 4; ++i)
+            if (fabsf(q[i]) > fabsf(q[largest]))
+                largest = i;
+
+        f32 sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+        u32 p = 0;
+        for (u32 i = 0; i < 4; ++i)
+        {
+            if (i == largest)
+                continue;
+
+            f32 c = std::min(std::max(q[i] * sign * sqrtf(2.0f), -1.0f), 1.0f);
+            out[p++] = (u16)roundf((c * 0.5f + 0.5f) * 32767.0f);
+        }
+
+        out[0] |= (largest & 1) << 15;
+        out[1] |= (largest >> 1) << 15;
+    }
+
+    // sample one channel at time t into out (element layout), as the update_animations sampler does
+    void sample_channel(const anim_channel& channel, const f32* times, const f32* data, const u16* qdata, u32& cursor,
+                        f32 t, f32* out)
+    {
+        cursor = find_anim_key(times, channel.num_frames, cursor, t);
+        u32 next = (cursor + 1) % channel.num_frames;
+
+        const f32* d1;
+        const f32* d2;
+
+        f32 k1[21];
+        f32 k2[21];
+
+        bool compressed = channel.flags & anim_flags::COMPRESSED;
+        if (compressed)
+        {
+            decode_anim_key(channel, &qdata[cursor * channel.packed_count], k1);
+            decode_anim_key(channel, &qdata[next * channel.packed_count], k2);
+
+            d1 = k1;
+            d2 = k2;
+        }
+        else
+        {
+            d1 = &data[cursor * channel.element_count];
+            d2 = &data[next * channel.element_count];
+        }
+
+        f32 it = std::min(std::max((t - times[cursor]) / (times[next] - times[cursor]), 0.0f), 1.0f);
+
+        for (u32 e = 0; e < channel.element_count; ++e)
+        {
+            if (channel.element_offset[e] == A_OUT_QUAT)
+            {
+                quat q1;
+                quat q2;
+
+                memcpy(&q1.v[0], &d1[e], 16);
+                memcpy(&q2.v[0], &d2[e], 16);
+
+                f32 qd = q1.v[0] * q2.v[0] + q1.v[1] * q2.v[1] + q1.v[2] * q2.v[2] + q1.v[3] * q2.v[3];
+                if (compressed && qd < 0.0f)
+                    for (u32 i = 0; i < 4; ++i)
+                        q2.v[i] = -q2.v[i];
+
+                quat ql = slerp(q1, q2, it);
+                memcpy(&out[e], &ql.v[0], 16);
+                e += 3;
+            }
+            else
+            {
+                out[e] = (1 - it) * d1[e] + it * d2[e];
+            }
+        }
+    }
+} // namespace
+
+// samples 100 rigs x 80 joints from a float clip and the same clip quantized the way compress_animations.py writes
+// pma version 2, reporting key memory, decode error and ms per update. key reduction is not applied, both clips have
+// the same keys so the difference is the decode cost against the smaller key footprint.
+void benchmark_anim_compression(ecs_scene* scene, Str& results)
+{
+    u32 num_keys = k_num_joints * k_num_keys;
+
+    f32* times = new f32[num_keys];
+    f32* data = new f32[num_keys * k_elements];
+    u16* qdata = new u16[num_keys * k_packed];
+
+    anim_channel* float_channels = new anim_channel[k_num_joints];
+    anim_channel* packed_channels = new anim_channel[k_num_joints];
+
+    for (u32 j = 0; j < k_num_joints; ++j)
+    {
+        f32* jt = &times[j * k_num_keys];
+        f32* jd = &data[j * k_num_keys * k_elements];
+
+        // smooth per joint curves, rotation about a fixed axis per joint
+        vec3f axis = normalised(vec3f(sinf((f32)j), 1.0f, cosf((f32)j)));
+        for (u32 k = 0; k < k_num_keys; ++k)
+        {
+            f32  phase = (f32)k * 0.05f + (f32)j;
+            f32* d = &jd[k * k_elements];
+
+            jt[k] = (f32)k * k_key_step;
+
+            d[0] = sinf(phase) * 0.5f;
+            d[1] = cosf(phase * 0.7f) * 0.25f + 1.0f;
+            d[2] = sinf(phase * 1.3f) * 0.1f;
+            d[3] = d[4] = d[5] = 1.0f + sinf(phase * 0.2f) * 0.05f;
+
+            f32 half_angle = sinf(phase) * 1.5f;
+            d[6] = axis.x * sinf(half_angle);
+            d[7] = axis.y * sinf(half_angle);
+            d[8] = axis.z * sinf(half_angle);
+            d[9] = cosf(half_angle);
+        }
+
+        anim_channel& fc = float_channels[j];
+        fc.num_frames = k_num_keys;
+        fc.element_count = k_elements;
+        fc.flags = anim_flags::BAKED_QUATERNION;
+        fc.key_offset = j * k_num_keys;
+        fc.data_offset = j * k_num_keys * k_elements;
+
+        for (u32 i = 0; i < 3; ++i)
+        {
+            fc.element_offset[i] = A_OUT_TX + i;
+            fc.element_offset[3 + i] = A_OUT_SX + i;
+        }
+
+        for (u32 i = 0; i < 4; ++i)
+            fc.element_offset[6 + i] = A_OUT_QUAT;
+
+        // ranges as track_range in compress_animations.py
+        anim_channel& pc = packed_channels[j];
+        pc = fc;
+        pc.flags |= anim_flags::COMPRESSED;
+        pc.packed_count = k_packed;
+        pc.data_offset = j * k_num_keys * k_packed;
+
+        f32 range_max[6];
+        for (u32 e = 0; e < 6; ++e)
+        {
+            pc.range_min[e] = FLT_MAX;
+            range_max[e] = -FLT_MAX;
+
+            for (u32 k = 0; k < k_num_keys; ++k)
+            {
+                pc.range_min[e] = std::min(pc.range_min[e], jd[k * k_elements + e]);
+                range_max[e] = std::max(range_max[e], jd[k * k_elements + e]);
+            }
+
+            pc.range_scale[e] = (range_max[e] - pc.range_min[e]) / 65535.0f;
+        }
+
+        u16* jq = &qdata[pc.data_offset];
+        for (u32 k = 0; k < k_num_keys; ++k)
+        {
+            const f32* d = &jd[k * k_elements];
+            u16*       q = &jq[k * k_packed];
+
+            for (u32 e = 0; e < 6; ++e)
+                q[e] = quantize_range(d[e], pc.range_min[e], range_max[e] - pc.range_min[e]);
+
+            quantize_quat(&d[6], &q[6]);
+        }
+    }
+
+    // decode error against the source keys
+    f32 max_t_error = 0.0f;
+    f32 max_q_error = 0.0f;
+    for (u32 j = 0; j < k_num_joints; ++j)
+    {
+        for (u32 k = 0; k < k_num_keys; ++k)
+        {
+            const anim_channel& pc = packed_channels[j];
+            const f32*          d = &data[float_channels[j].data_offset + k * k_elements];
+
+            f32 decoded[k_elements];
+            decode_anim_key(pc, &qdata[pc.data_offset + k * k_packed], decoded);
+
+            for (u32 e = 0; e < 6; ++e)
+                max_t_error = std::max(max_t_error, fabsf(decoded[e] - d[e]));
+
+            // q and -q are the same rotation
+            f32 qd = 0.0f;
+            for (u32 i = 0; i < 4; ++i)
+                qd += decoded[6 + i] * d[6 + i];
+
+            f32 sign = qd < 0.0f ? -1.0f : 1.0f;
+            for (u32 i = 0; i < 4; ++i)
+                max_q_error = std::max(max_q_error, fabsf(decoded[6 + i] * sign - d[6 + i]));
+        }
+    }
+
+    u32* cursors = new u32[k_num_rigs * k_num_joints];
+    f32* out = new f32[k_num_rigs * k_num_joints * k_elements];
+
+    pen::timer* t = pen::timer_create();
+
+    f32                 ms[2] = {0.0f, 0.0f};
+    const anim_channel* channels[2] = {float_channels, packed_channels};
+    f32                 length = (f32)(k_num_keys - 1) * k_key_step;
+
+    for (u32 c = 0; c < 2; ++c)
+    {
+        memset(cursors, 0x0, k_num_rigs * k_num_joints * sizeof(u32));
+
+        for (u32 u = 0; u < k_num_updates; ++u)
+        {
+            pen::timer_start(t);
+
+            for (u32 r = 0; r < k_num_rigs; ++r)
+            {
+                f32 anim_t = fmodf(length * (f32)r / (f32)k_num_rigs + (f32)u / 60.0f, length);
+
+                for (u32 j = 0; j < k_num_joints; ++j)
+                {
+                    const anim_channel& channel = channels[c][j];
+                    u32                 i = r * k_num_joints + j;
+
+                    sample_channel(channel, &times[channel.key_offset], &data[channel.data_offset],
+                                   &qdata[channel.data_offset], cursors[i], anim_t, &out[i * k_elements]);
+                }
+            }
+
+            ms[c] += pen::timer_elapsed_ms(t);
+        }
+    }
+
+    u32 float_bytes = num_keys * k_elements * sizeof(f32);
+    u32 packed_bytes = num_keys * k_packed * sizeof(u16);
+
+    results.appendf("%u rigs x %u joints, %u keys\n", k_num_rigs, k_num_joints, k_num_keys);
+    results.appendf("key data: float %u bytes, compressed %u bytes (%.2f:1)\n", float_bytes, packed_bytes,
+                    (f32)float_bytes / (f32)packed_bytes);
+    results.appendf("max error: translate / scale %f, quat component %f\n", max_t_error, max_q_error);
+    results.appendf("sample: float %.4fms, compressed %.4fms per update\n", ms[0] / (f32)k_num_updates,
+                    ms[1] / (f32)k_num_updates);
+
+    pen::timer_destroy(t);
+
+    delete[] times;
+    delete[] data;
+    delete[] qdata;
+    delete[] float_channels;
+    delete[] packed_channels;
+    delete[] cursors;
+    delete[] out;
+}
@@ -0,0 +1,159 @@
+#include "benchmarks.h"
+
+#include "timer.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    const u32 k_num_rigs = 100;
+    const u32 k_num_joints = 80;
+    const u32 k_num_keys = 3000; // 100 seconds at 30 keys per second
+    const f32 k_key_step = 1.0f / 30.0f;
+    const u32 k_num_updates = 600; // 10 seconds of 60hz updates per scenario
+
+    enum e_key_search
+    {
+        SEARCH_RESCAN,
+        SEARCH_LINEAR,
+        SEARCH_CURSOR,
+        SEARCH_COUNT
+    };
+
+    const c8* k_search_names[] = {"rescan from 0", "linear from cursor", "cursor + binary search"};
+
+    enum e_scenario
+    {
+        SCENARIO_FORWARD,
+        SCENARIO_BACKWARD,
+        SCENARIO_SEEK,
+        SCENARIO_COUNT
+    };
+
+    const c8* k_scenario_names[] = {"forward", "backward", "random seek"};
+
+    // update_animations_baked before the change, every update scanned from frame 0
+    u32 rescan_key(const f32* times, u32 num_frames, f32 t)
+    {
+        u32 k = 0;
+        while (k + 1 < num_frames && times[k + 1] <= t)
+            ++k;
+
+        return k;
+    }
+
+    // update_animations before the change, scan forward from the last key and restart from 0 if time went back
+    u32 linear_key(const f32* times, u32 num_frames, u32 cursor, f32 t)
+    {
+        u32 k = times[cursor] <= t ? cursor : 0;
+        while (k + 1 < num_frames && times[k + 1] <= t)
+            ++k;
+
+        return k;
+    }
+
+    f32 scenario_time(u32 scenario, u32 rig, u32 update, f32 length)
+    {
+        // rigs are offset in time so they do not all hit the same keys
+        f32 offset = length * (f32)rig / (f32)k_num_rigs;
+
+        switch (scenario)
+        {
+            case SCENARIO_FORWARD:
+                return fmodf(offset + (f32)update / 60.0f, length);
+            case SCENARIO_BACKWARD:
+                return length - fmodf(offset + (f32)update / 60.0f, length);
+            default:
+                return ((f32)rand() / (f32)RAND_MAX) * length;
+        }
+    }
+} // namespace
+
+// key lookup for 100 rigs x 80 joints over a 3000 key clip, the old rescan and linear searches against the cursor and
+// binary search used by update_animations. one channel major clip is shared, each rig samples it with its own cursors.
+void benchmark_anim_keys(ecs_scene* scene, Str& results)
+{
+    f32* times = new f32[k_num_joints * k_num_keys];
+    for (u32 j = 0; j < k_num_joints; ++j)
+        for (u32 k = 0; k < k_num_keys; ++k)
+            times[j * k_num_keys + k] = (f32)k * k_key_step;
+
+    f32  length = (f32)(k_num_keys - 1) * k_key_step;
+    u32* cursors = new u32[k_num_rigs * k_num_joints];
+    f32* sample_times = new f32[k_num_rigs];
+
+    pen::timer* t = pen::timer_create();
+
+    results.appendf("%u rigs x %u joints, %u keys, ms per update:\n", k_num_rigs, k_num_joints, k_num_keys);
+
+    for (u32 s = 0; s < SCENARIO_COUNT; ++s)
+    {
+        results.appendf("  %s:", k_scenario_names[s]);
+
+        u32 reference = 0;
+        for (u32 m = 0; m < SEARCH_COUNT; ++m)
+        {
+            memset(cursors, 0x0, k_num_rigs * k_num_joints * sizeof(u32));
+            srand(0);
+
+            f32 total_ms = 0.0f;
+            u32 checksum = 0;
+
+            for (u32 u = 0; u < k_num_updates; ++u)
+            {
+                for (u32 r = 0; r < k_num_rigs; ++r)
+                    sample_times[r] = scenario_time(s, r, u, length);
+
+                pen::timer_start(t);
+
+                for (u32 r = 0; r < k_num_rigs; ++r)
+                {
+                    for (u32 j = 0; j < k_num_joints; ++j)
+                    {
+                        const f32* channel_times = &times[j * k_num_keys];
+                        u32&       cursor = cursors[r * k_num_joints + j];
+
+                        switch (m)
+                        {
+                            case SEARCH_RESCAN:
+                                cursor = rescan_key(channel_times, k_num_keys, sample_times[r]);
+                                break;
+                            case SEARCH_LINEAR:
+                                cursor = linear_key(channel_times, k_num_keys, cursor, sample_times[r]);
+                                break;
+                            default:
+                                cursor = find_anim_key(channel_times, k_num_keys, cursor, sample_times[r]);
+                                break;
+                        }
+
+                        checksum += cursor;
+                    }
+                }
+
+                total_ms += pen::timer_elapsed_ms(t);
+            }
+
+            results.appendf(" %s %.4f", k_search_names[m], total_ms / (f32)k_num_updates);
+
+            // all three searches must agree, the checksum also keeps the loops from being optimised away
+            if (m == 0)
+                reference = checksum;
+            else if (checksum != reference)
+                results.append(" (mismatch)");
+        }
+
+        results.append("\n");
+    }
+
+    pen::timer_destroy(t);
+
+    delete[] times;
+    delete[] cursors;
+    delete[] sample_times;
+}
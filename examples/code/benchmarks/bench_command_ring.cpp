@@ -0,0 +1,75 @@
+#include "benchmarks.h"
+
+#include "ecs/ecs_resources.h"
+#include "pmfx.h"
+#include "renderer.h"
+#include "timer.h"
+
+#include <algorithm>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    const u32 k_num_draws = 500000; // each draw is paired with a constant buffer bind, 1M commands in total
+}
+
+// pushes 1M draw and state commands through the ring and times the user thread encode and the render thread drain.
+// draws have an index count of 0 so the drain measures command dispatch and state binding rather than gpu work.
+void benchmark_command_ring(ecs_scene* scene, Str& results)
+{
+    // flush whatever the frame has already written so only the benchmark commands are counted
+    pen::renderer_consume_cmd_buffer();
+
+    pen::buffer_creation_params bcp;
+    bcp.usage_flags = PEN_USAGE_DYNAMIC;
+    bcp.bind_flags = PEN_BIND_CONSTANT_BUFFER;
+    bcp.cpu_access_flags = PEN_CPU_ACCESS_WRITE;
+    bcp.buffer_size = sizeof(cmp_draw_call);
+    bcp.data = nullptr;
+
+    // alternate two buffers so the bind is never elided as redundant
+    u32 cbuffers[2];
+    for (u32 i = 0; i < 2; ++i)
+        cbuffers[i] = pen::renderer_create_buffer(bcp);
+
+    static const u32 shader = pmfx::load_shader("pmfx_utility");
+    geometry_resource* cube = get_geometry_resource(PEN_HASH("cube"));
+
+    pmfx::set_technique_perm(shader, PEN_HASH("constant_colour"));
+    pen::renderer_set_vertex_buffer(cube->vertex_buffer, 0, cube->vertex_size, 0);
+    pen::renderer_set_index_buffer(cube->index_buffer, cube->index_type, 0);
+
+    pen::timer* t = pen::timer_create();
+    pen::timer_start(t);
+
+    for (u32 i = 0; i < k_num_draws; ++i)
+    {
+        pen::renderer_set_constant_buffer(cbuffers[i & 1], 1, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
+        pen::renderer_draw_indexed(0, 0, 0, PEN_PT_TRIANGLELIST);
+    }
+
+    f32 push_ms = pen::timer_elapsed_ms(t);
+
+    // the render thread posts continue once it starts executing, the second consume waits for it to finish the first
+    pen::timer_start(t);
+    pen::renderer_consume_cmd_buffer();
+
+    // ring stats are sampled by consume
+    pen::renderer_cmd_buffer_stats stats;
+    pen::renderer_get_cmd_buffer_stats(stats);
+
+    pen::renderer_consume_cmd_buffer();
+    f32 drain_ms = pen::timer_elapsed_ms(t);
+
+    f32 num_cmds = (f32)(k_num_draws * 2);
+    results.appendf("commands: %u, ring bytes: %u (%.1f bytes per command)\n", stats.cmds, stats.cmd_bytes,
+                    (f32)stats.cmd_bytes / (f32)std::max<u32>(stats.cmds, 1));
+    results.appendf("push: %.3fms (%.1fns per command)\n", push_ms, push_ms * 1000000.0f / num_cmds);
+    results.appendf("drain: %.3fms (%.1fns per command)\n", drain_ms, drain_ms * 1000000.0f / num_cmds);
+
+    pen::timer_destroy(t);
+    for (u32 i = 0; i < 2; ++i)
+        pen::renderer_release_buffer(cbuffers[i]);
+}
@@ -0,0 +1,154 @@
+#include "benchmarks.h"
+
+#include "camera.h"
+#include "memory.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    const u32 k_entity_counts[] = {10000, 100000, 1000000};
+    const u32 k_iterations = 16; // culls timed per size, the fastest is reported
+
+    f32 random_range(f32 min, f32 max)
+    {
+        return min + ((f32)rand() / (f32)RAND_MAX) * (max - min);
+    }
+
+    // the per entity loop render_scene_view used before the batched cull, centre recomputed from the aabb and
+    // six point_plane_distance calls against the frustum
+    u32 cull_scalar(const cmp_bounding_volume* volumes, u32 count, const frustum& f, u32* visible)
+    {
+        u32 num_visible = 0;
+        for (u32 n = 0; n < count; ++n)
+        {
+            const vec3f& min = volumes[n].transformed_min_extents;
+            const vec3f& max = volumes[n].transformed_max_extents;
+
+            vec3f pos = min + (max - min) * 0.5f;
+            f32   radius = volumes[n].radius;
+
+            bool inside = true;
+            for (s32 i = 0; i < 6; ++i)
+            {
+                f32 d = maths::point_plane_distance(pos, f.p[i], f.n[i]);
+
+                if (d > radius)
+                {
+                    inside = false;
+                    break;
+                }
+            }
+
+            if (inside)
+                visible[num_visible++] = n;
+        }
+
+        return num_visible;
+    }
+} // namespace
+
+// scalar per entity frustum cull against the batched simd cull over the same random spheres at 10k, 100k and 1M.
+// volumes are generated directly rather than through an ecs_scene so the 1M case does not allocate every component.
+void benchmark_cull(ecs_scene* scene, Str& results)
+{
+    srand(0);
+
+    camera cam;
+    camera_create_perspective(&cam, 60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    pen::timer* t = pen::timer_create();
+
+    for (u32 c = 0; c < PEN_ARRAY_SIZE(k_entity_counts); ++c)
+    {
+        u32 count = k_entity_counts[c];
+
+        // keep density constant so roughly the same fraction is visible at every size
+        f32 half_size = powf((f32)count, 1.0f / 3.0f);
+
+        cam.focus = vec3f::zero();
+        cam.zoom = half_size * 2.0f;
+        cam.far_plane = half_size * 4.0f;
+        camera_update_projection_matrix(&cam);
+        camera_update_look_at(&cam);
+        camera_update_frustum(&cam);
+
+        cmp_bounding_volume* volumes = (cmp_bounding_volume*)pen::memory_alloc(count * sizeof(cmp_bounding_volume));
+
+        u32          capacity = (count + 3) & ~3;
+        cull_volumes cv;
+        cv.entities = (u32*)pen::memory_alloc_align(capacity * sizeof(u32), 16);
+        cv.x = (f32*)pen::memory_alloc_align(capacity * sizeof(f32), 16);
+        cv.y = (f32*)pen::memory_alloc_align(capacity * sizeof(f32), 16);
+        cv.z = (f32*)pen::memory_alloc_align(capacity * sizeof(f32), 16);
+        cv.radius = (f32*)pen::memory_alloc_align(capacity * sizeof(f32), 16);
+        cv.count = count;
+        cv.capacity = capacity;
+
+        for (u32 n = 0; n < count; ++n)
+        {
+            vec3f pos = vec3f(random_range(-half_size, half_size), random_range(-half_size, half_size),
+                              random_range(-half_size, half_size));
+            vec3f extents = vec3f(random_range(0.1f, 0.5f));
+
+            volumes[n].transformed_min_extents = pos - extents;
+            volumes[n].transformed_max_extents = pos + extents;
+            volumes[n].radius = mag(extents);
+
+            cv.entities[n] = n;
+            cv.x[n] = pos.x;
+            cv.y[n] = pos.y;
+            cv.z[n] = pos.z;
+            cv.radius[n] = volumes[n].radius;
+        }
+
+        // padding lanes are always outside, as in update_cull_volumes
+        for (u32 n = count; n < capacity; ++n)
+        {
+            cv.entities[n] = PEN_INVALID_HANDLE;
+            cv.x[n] = cv.y[n] = cv.z[n] = 0.0f;
+            cv.radius[n] = -FLT_MAX;
+        }
+
+        u32* visible = (u32*)pen::memory_alloc(capacity * sizeof(u32));
+
+        f32 scalar_ms = FLT_MAX;
+        f32 simd_ms = FLT_MAX;
+        u32 scalar_visible = 0;
+        u32 simd_visible = 0;
+
+        for (u32 i = 0; i < k_iterations; ++i)
+        {
+            pen::timer_start(t);
+            scalar_visible = cull_scalar(volumes, count, cam.camera_frustum, visible);
+            scalar_ms = std::min(scalar_ms, pen::timer_elapsed_ms(t));
+
+            pen::timer_start(t);
+            simd_visible = frustum_cull_volumes(cv, cam.camera_frustum, visible);
+            simd_ms = std::min(simd_ms, pen::timer_elapsed_ms(t));
+        }
+
+        results.appendf("%u entities, %u visible: scalar %.3fms, simd %.3fms (%.1fx)\n", count, simd_visible,
+                        scalar_ms, simd_ms, scalar_ms / std::max(simd_ms, 0.0001f));
+
+        if (scalar_visible != simd_visible)
+            results.appendf("  mismatch: scalar cull found %u visible\n", scalar_visible);
+
+        pen::memory_free(visible);
+        pen::memory_free(volumes);
+        pen::memory_free_align(cv.entities);
+        pen::memory_free_align(cv.x);
+        pen::memory_free_align(cv.y);
+        pen::memory_free_align(cv.z);
+        pen::memory_free_align(cv.radius);
+    }
+
+    pen::timer_destroy(t);
+}
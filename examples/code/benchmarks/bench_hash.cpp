@@ -0,0 +1,178 @@
+#include "benchmarks.h"
+
+#include "hash.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <float.h>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    // every PEN_HASH literal in the engine and examples, plus short strings to cover each tail length
+#define HASH_CORPUS(X)                                                                                                 \
+    X("a")                                                                                                             \
+    X("ab")                                                                                                            \
+    X("abc")                                                                                                           \
+    X("")                                                                                                              \
+    X("_instanced")                                                                                                    \
+    X("_quantized")                                                                                                    \
+    X("_skinned")                                                                                                      \
+    X("_skinned_quantized")                                                                                            \
+    X("area_light_colour")                                                                                             \
+    X("area_light_texture")                                                                                            \
+    X("area_light_textures")                                                                                           \
+    X("back_light")                                                                                                    \
+    X("bgra8")                                                                                                         \
+    X("blit")                                                                                                          \
+    X("capsule")                                                                                                       \
+    X("checkbox")                                                                                                      \
+    X("chrome")                                                                                                        \
+    X("chrome2")                                                                                                       \
+    X("clamp_linear")                                                                                                  \
+    X("clamp_point")                                                                                                   \
+    X("colour")                                                                                                        \
+    X("cone")                                                                                                          \
+    X("constant_colour")                                                                                               \
+    X("controlrig")                                                                                                    \
+    X("cube")                                                                                                          \
+    X("cubemap")                                                                                                       \
+    X("cyan_light")                                                                                                    \
+    X("cylinder")                                                                                                      \
+    X("d24s8")                                                                                                         \
+    X("debug_2d")                                                                                                      \
+    X("debug_3d")                                                                                                      \
+    X("default")                                                                                                       \
+    X("default_material")                                                                                              \
+    X("directional_light")                                                                                             \
+    X("disabled")                                                                                                      \
+    X("forward_lit")                                                                                                   \
+    X("forward_render")                                                                                                \
+    X("front_face_cull")                                                                                               \
+    X("front_light")                                                                                                   \
+    X("front_light0")                                                                                                  \
+    X("front_light1")                                                                                                  \
+    X("front_light2")                                                                                                  \
+    X("front_light4")                                                                                                  \
+    X("full_screen_quad")                                                                                              \
+    X("gbuffer_albedo")                                                                                                \
+    X("gbuffer_depth")                                                                                                 \
+    X("gbuffer_normals")                                                                                               \
+    X("gbuffer_world_pos")                                                                                             \
+    X("greyscale")                                                                                                     \
+    X("horizontal")                                                                                                    \
+    X("input")                                                                                                         \
+    X("joint")                                                                                                         \
+    X("light")                                                                                                         \
+    X("magenta_light")                                                                                                 \
+    X("main_colour")                                                                                                   \
+    X("main_depth")                                                                                                    \
+    X("mip_mapped")                                                                                                    \
+    X("msaa_colour")                                                                                                   \
+    X("msaa_custom")                                                                                                   \
+    X("msaa_depth")                                                                                                    \
+    X("no_cull")                                                                                                       \
+    X("physics_cone")                                                                                                  \
+    X("picking")                                                                                                       \
+    X("pmfx_utility")                                                                                                  \
+    X("point_light")                                                                                                   \
+    X("pre_skin")                                                                                                      \
+    X("primitive")                                                                                                     \
+    X("quad")                                                                                                          \
+    X("r16f")                                                                                                          \
+    X("r32f")                                                                                                          \
+    X("r32u")                                                                                                          \
+    X("red_light")                                                                                                     \
+    X("rgba16f")                                                                                                       \
+    X("rgba32f")                                                                                                       \
+    X("rgba8")                                                                                                         \
+    X("rt_additive")                                                                                                   \
+    X("rt_alpha_blend")                                                                                                \
+    X("rt_max")                                                                                                        \
+    X("rt_min")                                                                                                        \
+    X("rt_no_blend")                                                                                                   \
+    X("rt_premultiplied_alpha")                                                                                        \
+    X("rt_rev_subtract")                                                                                               \
+    X("rt_subtract")                                                                                                   \
+    X("shadow_map")                                                                                                    \
+    X("shadow_mesh")                                                                                                   \
+    X("signed_distance_field")                                                                                         \
+    X("slider")                                                                                                        \
+    X("sphere")                                                                                                        \
+    X("spot_light")                                                                                                    \
+    X("tex_2d")                                                                                                        \
+    X("tex_2d_array")                                                                                                  \
+    X("tex_cube")                                                                                                      \
+    X("tex_volume")                                                                                                    \
+    X("textures")                                                                                                      \
+    X("trajectoryshjnt")                                                                                               \
+    X("vertical")                                                                                                      \
+    X("view_clear_stencil")                                                                                            \
+    X("view_shadow_volume")                                                                                            \
+    X("view_single_light")                                                                                             \
+    X("volume_raster")                                                                                                 \
+    X("volume_raster_ds")                                                                                              \
+    X("volume_sdf")                                                                                                    \
+    X("volume_texture")                                                                                                \
+    X("wireframe")                                                                                                     \
+    X("wrap_linear")                                                                                                   \
+    X("write")                                                                                                         \
+    X("yellow_light")                                                                                                  \
+    X("a_name_longer_than_any_of_the_literals_above_to_cover_many_whole_words")
+
+    struct hash_entry
+    {
+        const c8* name;
+        hash_id   id;
+    };
+
+#define HASH_ENTRY(S) {S, PEN_HASH(S)},
+
+    // constexpr forces every PEN_HASH above to be evaluated at compile time
+    constexpr hash_entry k_corpus[] = {HASH_CORPUS(HASH_ENTRY)};
+    const u32            k_corpus_size = PEN_ARRAY_SIZE(k_corpus);
+    const u32            k_iterations = 10000;
+} // namespace
+
+// checks the compile time PEN_HASH of each corpus literal against hashMurmur2A of the same string at runtime,
+// then times the runtime hash which every literal lookup paid before PEN_HASH became constexpr
+void benchmark_hash(ecs_scene* scene, Str& results)
+{
+    u32 mismatches = 0;
+    for (u32 i = 0; i < k_corpus_size; ++i)
+    {
+        Str     name = k_corpus[i].name;
+        hash_id runtime = pen::hashMurmur2A(name.c_str());
+
+        if (runtime != k_corpus[i].id || PEN_HASH(name) != k_corpus[i].id)
+        {
+            results.appendf("  mismatch: \"%s\" constexpr 0x%08x runtime 0x%08x\n", k_corpus[i].name, k_corpus[i].id,
+                            runtime);
+            ++mismatches;
+        }
+    }
+
+    results.appendf("%u names, %u mismatches\n", k_corpus_size, mismatches);
+
+    pen::timer* t = pen::timer_create();
+
+    f32     runtime_ms = FLT_MAX;
+    hash_id sum = 0;
+    for (u32 r = 0; r < 8; ++r)
+    {
+        pen::timer_start(t);
+        for (u32 i = 0; i < k_iterations; ++i)
+            for (u32 c = 0; c < k_corpus_size; ++c)
+                sum += pen::hashMurmur2A(k_corpus[c].name);
+
+        runtime_ms = std::min(runtime_ms, pen::timer_elapsed_ms(t));
+    }
+
+    // sum keeps the loop from being optimised away
+    results.appendf("runtime hash: %.1fns per name (sum 0x%08x)\n",
+                    runtime_ms * 1000000.0f / (f32)(k_iterations * k_corpus_size), sum);
+
+    pen::timer_destroy(t);
+}
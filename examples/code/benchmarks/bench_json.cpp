@@ -0,0 +1,149 @@
+#include "benchmarks.h"
+
+#include "file_system.h"
+#include "memory.h"
+#include "pen_json.h"
+#include "pen_string.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <float.h>
+#include <stdlib.h>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    const c8* k_config = "data/configs/editor_renderer.jsn";
+    const u32 k_iterations = 100;
+
+    jsmntok_t* parse_tokens(const c8* js, u32 len, s32& num_tokens)
+    {
+        // starting at 64 tokens and doubling, as the per object parse did
+        u32 capacity = 64;
+        for (;;)
+        {
+            jsmntok_t* tokens = (jsmntok_t*)pen::memory_alloc(capacity * sizeof(jsmntok_t));
+
+            jsmn_parser parser;
+            jsmn_init(&parser);
+
+            num_tokens = jsmn_parse(&parser, js, len, tokens, capacity);
+            if (num_tokens != JSMN_ERROR_NOMEM)
+                return tokens;
+
+            pen::memory_free(tokens);
+            capacity *= 2;
+        }
+    }
+
+    s32 token_span(const jsmntok_t* tokens, s32 t)
+    {
+        // number of tokens in the subtree rooted at t
+        s32 span = 1;
+        s32 children = tokens[t].type == JSMN_OBJECT ? tokens[t].size * 2 : tokens[t].size;
+        for (s32 c = 0; c < children; ++c)
+            span += token_span(tokens, t + span);
+
+        return span;
+    }
+
+    // the cost model of the per object json, every child access copied its text and parsed it again
+    u32 walk_reparse(const c8* js, u32 len)
+    {
+        s32        num_tokens = 0;
+        jsmntok_t* tokens = parse_tokens(js, len, num_tokens);
+
+        u32 leaves = 0;
+        if (num_tokens > 0 && (tokens[0].type == JSMN_OBJECT || tokens[0].type == JSMN_ARRAY))
+        {
+            bool object = tokens[0].type == JSMN_OBJECT;
+
+            s32 t = 1;
+            for (s32 c = 0; c < tokens[0].size; ++c)
+            {
+                // skip the member name
+                if (object)
+                    ++t;
+
+                const jsmntok_t& child = tokens[t];
+                if (child.type == JSMN_OBJECT || child.type == JSMN_ARRAY)
+                {
+                    c8* sub = pen::sub_string(js + child.start, child.end - child.start);
+                    leaves += walk_reparse(sub, child.end - child.start);
+                    free(sub);
+                }
+                else
+                {
+                    ++leaves;
+                }
+
+                t += token_span(tokens, t);
+            }
+        }
+
+        pen::memory_free(tokens);
+        return leaves;
+    }
+
+    u32 walk_handles(const pen::json& j)
+    {
+        jsmntype_t type = j.type();
+        if (type != JSMN_OBJECT && type != JSMN_ARRAY)
+            return 1;
+
+        u32 leaves = 0;
+        u32 num_children = j.size();
+        for (u32 i = 0; i < num_children; ++i)
+            leaves += walk_handles(j[i]);
+
+        return leaves;
+    }
+} // namespace
+
+// parses and walks every node of the editor render config, with the single parse document and token handles against
+// re-parsing each child object from its copied text, which is what json::operator[] did before
+void benchmark_json(ecs_scene* scene, Str& results)
+{
+    void* data = nullptr;
+    u32   size = 0;
+
+    if (pen::filesystem_read_file_to_buffer(k_config, &data, size) != PEN_ERR_OK || size == 0)
+    {
+        results.appendf("failed to open %s\n", k_config);
+        pen::memory_free(data);
+        return;
+    }
+
+    const c8* js = (const c8*)data;
+
+    pen::timer* t = pen::timer_create();
+
+    f32 handles_ms = FLT_MAX;
+    f32 reparse_ms = FLT_MAX;
+    u32 handles_leaves = 0;
+    u32 reparse_leaves = 0;
+
+    for (u32 i = 0; i < k_iterations; ++i)
+    {
+        pen::timer_start(t);
+        pen::json j = pen::json::load(js);
+        handles_leaves = walk_handles(j);
+        handles_ms = std::min(handles_ms, pen::timer_elapsed_ms(t));
+
+        pen::timer_start(t);
+        reparse_leaves = walk_reparse(js, size);
+        reparse_ms = std::min(reparse_ms, pen::timer_elapsed_ms(t));
+    }
+
+    results.appendf("%s: %u bytes, %u values\n", k_config, size, handles_leaves);
+    results.appendf("load and walk: handles %.3fms, reparse %.3fms (%.1fx)\n", handles_ms, reparse_ms,
+                    reparse_ms / std::max(handles_ms, 0.0001f));
+
+    if (handles_leaves != reparse_leaves)
+        results.appendf("  mismatch: reparse walk found %u values\n", reparse_leaves);
+
+    pen::timer_destroy(t);
+    pen::memory_free(data);
+}
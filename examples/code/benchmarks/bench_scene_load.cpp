@@ -0,0 +1,92 @@
+#include "benchmarks.h"
+
+#include "ecs/ecs_resources.h"
+#include "ecs/ecs_utilities.h"
+#include "file_system.h"
+#include "memory.h"
+#include "renderer.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace put;
+using namespace ecs;
+
+namespace
+{
+    const u32 k_entity_counts[] = {10000, 100000};
+    const c8* k_restore_filename = "scene_load_benchmark_restore.pms";
+    const c8* k_scene_filename = "scene_load_benchmark.pms";
+
+    // clear_scene does not release per entity cbuffers, 100k of them are created on every save and load
+    void release_scene(ecs_scene* scene)
+    {
+        for (u32 n = 0; n < scene->num_entities; ++n)
+            if (scene->entities[n] & CMP_GEOMETRY && is_valid_non_null(scene->cbuffer[n]))
+                pen::renderer_release_buffer(scene->cbuffer[n]);
+
+        clear_scene(scene);
+    }
+} // namespace
+
+// saves a grid of named cubes at 10k and 100k entities and times load_scene against reading the same file, which is
+// the floor a load could reach. the scene is saved first and restored afterwards.
+void benchmark_scene_load(ecs_scene* scene, Str& results)
+{
+    save_scene(k_restore_filename, scene);
+
+    material_resource* default_material = get_material_resource(PEN_HASH("default_material"));
+    geometry_resource* box = get_geometry_resource(PEN_HASH("cube"));
+
+    pen::timer* t = pen::timer_create();
+
+    for (u32 c = 0; c < PEN_ARRAY_SIZE(k_entity_counts); ++c)
+    {
+        u32 count = k_entity_counts[c];
+        u32 side = (u32)ceilf(sqrtf((f32)count));
+
+        release_scene(scene);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 e = get_new_entity(scene);
+            scene->names[e] = "box";
+            scene->names[e].appendf("%i", e);
+            scene->id_name[e] = PEN_HASH(scene->names[e].c_str());
+            scene->transforms[e].rotation = quat();
+            scene->transforms[e].scale = vec3f(0.5f);
+            scene->transforms[e].translation = vec3f((f32)(i % side), 0.0f, (f32)(i / side));
+            scene->entities[e] |= CMP_TRANSFORM;
+            scene->parents[e] = e;
+            instantiate_geometry(box, scene, e);
+            instantiate_material(default_material, scene, e);
+            instantiate_model_cbuffer(scene, e);
+        }
+
+        save_scene(k_scene_filename, scene);
+        release_scene(scene);
+
+        // read only, the file is warm in the os cache from the save so both timings exclude the disk
+        void* data = nullptr;
+        u32   size = 0;
+
+        pen::timer_start(t);
+        pen::filesystem_read_file_to_buffer(k_scene_filename, &data, size);
+        f32 read_ms = pen::timer_elapsed_ms(t);
+
+        pen::memory_free(data);
+
+        pen::timer_start(t);
+        load_scene(k_scene_filename, scene);
+        f32 load_ms = pen::timer_elapsed_ms(t);
+
+        results.appendf("%u entities, %u bytes: read %.3fms, load_scene %.3fms (%.1fx read)\n", scene->num_entities,
+                        size, read_ms, load_ms, load_ms / std::max(read_ms, 0.0001f));
+    }
+
+    pen::timer_destroy(t);
+
+    release_scene(scene);
+    load_scene(k_restore_filename, scene);
+}
@@ -0,0 +1,82 @@
+#include "../example_common.h"
+#include "benchmarks.h"
+
+pen::window_creation_params pen_window{
+    1280,        // width
+    720,         // height
+    4,           // MSAA samples
+    "benchmarks" // window title / process name
+};
+
+namespace
+{
+    const benchmark k_benchmarks[] = {
+        {"command ring", benchmark_command_ring},
+        {"frustum cull", benchmark_cull},
+        {"json", benchmark_json},
+        {"hash", benchmark_hash},
+        {"anim keys", benchmark_anim_keys},
+        {"anim compression", benchmark_anim_compression},
+        {"scene load", benchmark_scene_load},
+    };
+    const u32 k_num_benchmarks = PEN_ARRAY_SIZE(k_benchmarks);
+
+    Str s_results[k_num_benchmarks];
+
+    void run_benchmark(ecs_scene* scene, u32 index)
+    {
+        s_results[index].clear();
+        k_benchmarks[index].run(scene, s_results[index]);
+
+        PEN_LOG("[benchmark] %s\n%s", k_benchmarks[index].name, s_results[index].c_str());
+    }
+} // namespace
+
+// cpu micro benchmarks for engine systems, each one is run on demand from the window and logged
+void example_setup(ecs_scene* scene, camera& cam)
+{
+    clear_scene(scene);
+
+    // add light
+    u32 light = get_new_entity(scene);
+    scene->names[light] = "front_light";
+    scene->id_name[light] = PEN_HASH("front_light");
+    scene->lights[light].colour = vec3f::one();
+    scene->lights[light].direction = vec3f::one();
+    scene->lights[light].type = LIGHT_TYPE_DIR;
+    scene->transforms[light].translation = vec3f::zero();
+    scene->transforms[light].rotation = quat();
+    scene->transforms[light].scale = vec3f::one();
+    scene->entities[light] |= CMP_LIGHT;
+    scene->entities[light] |= CMP_TRANSFORM;
+
+    cam.pos = vec3f(0.0f, 30.0f, 60.0f);
+    cam.focus = vec3f::zero();
+}
+
+void example_update(ecs::ecs_scene* scene, camera& cam, f32 dt)
+{
+    bool opened = true;
+    ImGui::Begin("Benchmarks", &opened, ImGuiWindowFlags_AlwaysAutoResize);
+
+    bool run_all = ImGui::Button("Run All");
+
+    for (u32 i = 0; i < k_num_benchmarks; ++i)
+    {
+        ImGui::PushID(i);
+        ImGui::Separator();
+
+        if (ImGui::Button("Run") || run_all)
+            run_benchmark(scene, i);
+
+        ImGui::SameLine();
+        ImGui::Text("%s", k_benchmarks[i].name);
+
+        if (!s_results[i].empty())
+            ImGui::Text("%s", s_results[i].c_str());
+
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+}
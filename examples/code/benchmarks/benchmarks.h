@@ -0,0 +1,23 @@
+// benchmarks.h
+// Copyright 2014 - 2019 Alex Dixon.
+// License: https://github.com/polymonster/pmtech/blob/master/license.md
+
+#pragma once
+
+#include "ecs/ecs_scene.h"
+#include "str/Str.h"
+
+// each benchmark runs to completion inside example_update and appends a line per measurement to results
+struct benchmark
+{
+    const c8* name;
+    void (*run)(put::ecs::ecs_scene* scene, Str& results);
+};
+
+void benchmark_command_ring(put::ecs::ecs_scene* scene, Str& results);
+void benchmark_cull(put::ecs::ecs_scene* scene, Str& results);
+void benchmark_json(put::ecs::ecs_scene* scene, Str& results);
+void benchmark_hash(put::ecs::ecs_scene* scene, Str& results);
+void benchmark_anim_keys(put::ecs::ecs_scene* scene, Str& results);
+void benchmark_anim_compression(put::ecs::ecs_scene* scene, Str& results);
+void benchmark_scene_load(put::ecs::ecs_scene* scene, Str& results);
@@ -30,6 +30,11 @@ namespace physics
     extern PEN_TRV physics_thread_main(void* params);
 }
 
+// examples can define EXAMPLE_PHYSICS_CONFIG as a physics::physics_config* before including to configure the world
+#ifndef EXAMPLE_PHYSICS_CONFIG
+#define EXAMPLE_PHYSICS_CONFIG nullptr
+#endif
+
 PEN_TRV pen::user_entry(void* params)
 {
     // unpack the params passed to the thread and signal to the engine it ok to proceed
@@ -37,8 +42,6 @@ PEN_TRV pen::user_entry(void* params)
     pen::job*               p_thread_info = job_params->job_info;
     pen::semaphore_post(p_thread_info->p_sem_continue, 1);
 
-    pen::jobs_create_job(physics::physics_thread_main, 1024 * 10, nullptr, pen::THREAD_START_DETACHED);
-
     // create the main scene and camera
     put::ecs::ecs_scene* main_scene = put::ecs::create_scene("main_scene");
 
@@ -47,6 +50,10 @@ PEN_TRV pen::user_entry(void* params)
 
     // init systems
     put::dev_ui::init();
+
+    // after dev_ui so examples can pick the physics config from program preferences
+    pen::jobs_create_job(physics::physics_thread_main, 1024 * 10, EXAMPLE_PHYSICS_CONFIG, pen::THREAD_START_DETACHED);
+
     put::dbg::init();
     put::ecs::editor_init(main_scene, &main_camera);
 
@@ -114,6 +121,7 @@ PEN_TRV pen::user_entry(void* params)
 
         pmfx::poll_for_changes();
         put::poll_hot_loader();
+        put::poll_streaming();
 
         // msg from the engine we want to terminate
         if (pen::semaphore_try_wait(p_thread_info->p_sem_exit))
@@ -85,8 +85,6 @@ void example_setup(ecs_scene* scene, camera& cam)
                 scene->entities[new_prim] |= CMP_GEOMETRY;
                 scene->entities[new_prim] |= CMP_MATERIAL;
 
-                scene->entities[new_prim] |= CMP_SUB_INSTANCE;
-
                 ImColor ii = ImColor::HSV((rand() % 255) / 255.0f, (rand() % 255) / 255.0f, (rand() % 255) / 255.0f);
                 scene->draw_call_data[new_prim].v2 = vec4f(ii.Value.x, ii.Value.y, ii.Value.z, 1.0f);
 
@@ -116,6 +114,13 @@ void example_update(ecs::ecs_scene* scene, camera& cam, f32 dt)
         scene->entities.data[i] |= CMP_TRANSFORM;
     }
 
+    // sub instances are flagged by instance_entity_range and drawn through the master,
+    // every view should submit a single packet for the whole range
+    u32                    num_stats = 0;
+    const draw_sort_stats* stats = get_draw_sort_stats(num_stats);
+    for (u32 i = 0; i < num_stats; ++i)
+        PEN_ASSERT(stats[i].draw_packets <= 1);
+
 #if 0 // debug / test array cost vs operator [] in component entity system
     f32 array_cost = pen::timer_elapsed_ms(timer);
     pen::timer_start(timer);
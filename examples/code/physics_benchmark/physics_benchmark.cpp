@@ -0,0 +1,314 @@
+#include "dev_ui.h"
+#include "physics/physics.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+namespace
+{
+    struct benchmark_config
+    {
+        const c8* name;
+        u32       broadphase;
+        u32       flags;
+    };
+
+    const benchmark_config k_configs[] = {
+        {"sweep", physics::BROADPHASE_SWEEP, 0},
+        {"sweep mt", physics::BROADPHASE_SWEEP, physics::PHYSICS_MULTITHREADED},
+        {"dbvt", physics::BROADPHASE_DBVT, 0},
+        {"dbvt mt", physics::BROADPHASE_DBVT, physics::PHYSICS_MULTITHREADED},
+    };
+    const s32 k_num_configs = PEN_ARRAY_SIZE(k_configs);
+
+    const u32 k_warmup_frames = 60;  // let the pile settle into contact before timing
+    const u32 k_sample_frames = 600; // frames averaged for the report
+    const u32 k_num_rays = 10000;    // cast down through the pile, one at a time and as a single batch
+    const u32 k_ray_chunk = 2048;    // one at a time casts are kicked in chunks so they fit in the physics cmd buffer
+
+    s32                     s_config_index = 0;
+    physics::physics_config s_physics_config;
+
+    physics::physics_config* get_benchmark_physics_config()
+    {
+        // the world is created once per run, the config is picked from preferences and changed for the next launch
+        s_config_index = put::dev_ui::get_program_preference("physics_benchmark_config").as_s32(0);
+        s_config_index = std::min<s32>(std::max<s32>(s_config_index, 0), k_num_configs - 1);
+
+        s_physics_config.broadphase = k_configs[s_config_index].broadphase;
+        s_physics_config.flags = k_configs[s_config_index].flags;
+        s_physics_config.world_min = vec3f(-100.0f, -10.0f, -100.0f);
+        s_physics_config.world_max = vec3f(100.0f, 100.0f, 100.0f);
+
+        return &s_physics_config;
+    }
+
+    struct ray_benchmark_result
+    {
+        f32 single_ms = 0.0f;
+        f32 batch_ms = 0.0f;
+        u32 single_hits = 0;
+        u32 batch_hits = 0;
+    };
+
+    a_u32 s_ray_callbacks = {0};
+    a_u32 s_ray_hits = {0};
+
+    void ray_callback(const physics::ray_cast_result& result)
+    {
+        if (result.physics_handle != PEN_INVALID_HANDLE)
+            s_ray_hits++;
+
+        s_ray_callbacks++;
+    }
+
+    // times 10k rays from submission until every result is back on the user thread
+    ray_benchmark_result benchmark_rays()
+    {
+        static physics::query        queries[k_num_rays];
+        static physics::query_result results[k_num_rays];
+
+        // grid of vertical rays over the pile
+        u32 num_xz = (u32)sqrtf((f32)k_num_rays);
+        for (u32 i = 0; i < k_num_rays; ++i)
+        {
+            f32 x = ((f32)(i % num_xz) / (f32)num_xz - 0.5f) * 30.0f;
+            f32 z = ((f32)(i / num_xz) / (f32)num_xz - 0.5f) * 30.0f;
+
+            queries[i].from = vec3f(x, 60.0f, z);
+            queries[i].to = vec3f(x, -5.0f, z);
+            queries[i].mask = 0xffffffff;
+            queries[i].group = 0xffffffff;
+        }
+
+        ray_benchmark_result rbr;
+        pen::timer*          t = pen::timer_create();
+
+        // wait for the physics thread to finish the previous frame so it is not included in the timing
+        physics::physics_consume_command_buffer();
+
+        // one command and callback per ray
+        s_ray_callbacks = 0;
+        s_ray_hits = 0;
+
+        pen::timer_start(t);
+        for (u32 i = 0; i < k_num_rays; ++i)
+        {
+            physics::ray_cast_params rcp;
+            rcp.start = queries[i].from;
+            rcp.end = queries[i].to;
+            rcp.timestamp = 0;
+            rcp.user_data = nullptr;
+            rcp.callback = ray_callback;
+            rcp.mask = queries[i].mask;
+            rcp.group = queries[i].group;
+            physics::cast_ray(rcp);
+
+            if ((i + 1) % k_ray_chunk == 0)
+                physics::physics_consume_command_buffer();
+        }
+        physics::physics_consume_command_buffer();
+
+        while (s_ray_callbacks < k_num_rays)
+            ;
+
+        rbr.single_ms = pen::timer_elapsed_ms(t);
+        rbr.single_hits = s_ray_hits;
+
+        physics::physics_consume_command_buffer();
+
+        // one batch command
+        physics::query_batch batch;
+        batch.type = physics::QUERY_RAY;
+        batch.queries = queries;
+        batch.results = results;
+        batch.count = k_num_rays;
+
+        pen::timer_start(t);
+        physics::submit_query_batch(&batch);
+        physics::physics_consume_command_buffer();
+
+        while (batch.pending)
+            ;
+
+        rbr.batch_ms = pen::timer_elapsed_ms(t);
+
+        for (u32 i = 0; i < k_num_rays; ++i)
+            if (results[i].physics_handle != PEN_INVALID_HANDLE)
+                rbr.batch_hits++;
+
+        // both paths cast the same rays into the same world so must agree
+        // every ray ends below the ground so hits something
+        PEN_ASSERT(rbr.single_hits == rbr.batch_hits);
+        PEN_ASSERT(rbr.batch_hits > 0);
+
+        pen::timer_destroy(t);
+        return rbr;
+    }
+} // namespace
+
+#define EXAMPLE_PHYSICS_CONFIG get_benchmark_physics_config()
+#include "../example_common.h"
+
+using namespace put;
+using namespace ecs;
+
+pen::window_creation_params pen_window{
+    1280,               // width
+    720,                // height
+    4,                  // MSAA samples
+    "physics_benchmark" // window title / process name
+};
+
+// 10k box pile on the rigid_body_primitives ground, reports bullet step time for the broadphase / threading config
+// and the time to cast 10k rays through the pile with cast_ray against a single query batch
+void example_setup(ecs_scene* scene, camera& cam)
+{
+    clear_scene(scene);
+
+    material_resource* default_material = get_material_resource(PEN_HASH("default_material"));
+    geometry_resource* box = get_geometry_resource(PEN_HASH("cube"));
+
+    // add light
+    u32 light = get_new_entity(scene);
+    scene->names[light] = "front_light";
+    scene->id_name[light] = PEN_HASH("front_light");
+    scene->lights[light].colour = vec3f::one();
+    scene->lights[light].direction = vec3f::one();
+    scene->lights[light].type = LIGHT_TYPE_DIR;
+    scene->transforms[light].translation = vec3f::zero();
+    scene->transforms[light].rotation = quat();
+    scene->transforms[light].scale = vec3f::one();
+    scene->entities[light] |= CMP_LIGHT;
+    scene->entities[light] |= CMP_TRANSFORM;
+
+    // ground
+    u32 ground = get_new_entity(scene);
+    scene->names[ground] = "ground";
+    scene->transforms[ground].translation = vec3f::zero();
+    scene->transforms[ground].rotation = quat();
+    scene->transforms[ground].scale = vec3f(50.0f, 1.0f, 50.0f);
+    scene->entities[ground] |= CMP_TRANSFORM;
+    scene->parents[ground] = ground;
+    instantiate_geometry(box, scene, ground);
+    instantiate_material(default_material, scene, ground);
+    instantiate_model_cbuffer(scene, ground);
+
+    scene->physics_data[ground].rigid_body.shape = physics::BOX;
+    scene->physics_data[ground].rigid_body.mass = 0.0f;
+    instantiate_rigid_body(scene, ground);
+
+    // 20 x 25 x 20 boxes
+    s32   num_xz = 20;
+    s32   num_y = 25;
+    f32   spacing = 1.1f;
+    vec3f start_pos = vec3f(-num_xz * spacing * 0.5f, 2.0f, -num_xz * spacing * 0.5f);
+
+    for (s32 i = 0; i < num_y; ++i)
+    {
+        for (s32 j = 0; j < num_xz; ++j)
+        {
+            for (s32 k = 0; k < num_xz; ++k)
+            {
+                u32 new_prim = get_new_entity(scene);
+                scene->names[new_prim] = "box";
+                scene->names[new_prim].appendf("%i", new_prim);
+                scene->transforms[new_prim].rotation = quat();
+                scene->transforms[new_prim].scale = vec3f(0.5f);
+                scene->transforms[new_prim].translation = start_pos + vec3f((f32)k, (f32)i, (f32)j) * spacing;
+                scene->entities[new_prim] |= CMP_TRANSFORM;
+                scene->parents[new_prim] = new_prim;
+                instantiate_geometry(box, scene, new_prim);
+                instantiate_material(default_material, scene, new_prim);
+                instantiate_model_cbuffer(scene, new_prim);
+
+                scene->physics_data[new_prim].rigid_body.shape = physics::BOX;
+                scene->physics_data[new_prim].rigid_body.mass = 1.0f;
+                instantiate_rigid_body(scene, new_prim);
+            }
+        }
+
+        // rigid bodies are added through the physics command buffer, drain it between layers
+        physics::physics_consume_command_buffer();
+        pen::thread_sleep_ms(1);
+    }
+
+    cam.pos = vec3f(0.0f, 30.0f, 60.0f);
+    cam.focus = vec3f(0.0f, 10.0f, 0.0f);
+
+    physics::physics_consume_command_buffer();
+    pen::thread_sleep_ms(16);
+}
+
+void example_update(ecs::ecs_scene* scene, camera& cam, f32 dt)
+{
+    static u32 frame = 0;
+    static f32 total_ms = 0.0f;
+    static f32 min_ms = FLT_MAX;
+    static f32 max_ms = 0.0f;
+    static u32 samples = 0;
+    static s32 next_config = s_config_index;
+
+    static ray_benchmark_result rays;
+    static bool                 rays_done = false;
+
+    physics::physics_stats stats = physics::get_stats();
+
+    ++frame;
+    if (frame > k_warmup_frames && samples < k_sample_frames && stats.substeps > 0)
+    {
+        // step_ms covers every substep of the last step command
+        f32 ms = stats.step_ms / (f32)stats.substeps;
+        total_ms += ms;
+        min_ms = std::min(min_ms, ms);
+        max_ms = std::max(max_ms, ms);
+
+        if (++samples == k_sample_frames)
+            PEN_LOG("[physics benchmark] %s: %i bodies, avg %.3fms min %.3fms max %.3fms per step\n",
+                    k_configs[s_config_index].name, scene->num_entities - 2, total_ms / samples, min_ms, max_ms);
+    }
+
+    // rays are cast once the step timing is complete so they do not disturb it
+    if (samples == k_sample_frames && !rays_done)
+    {
+        rays = benchmark_rays();
+        rays_done = true;
+
+        PEN_LOG("[physics benchmark] %s: %i rays, one at a time %.3fms (%i hits), batch %.3fms (%i hits)\n",
+                k_configs[s_config_index].name, k_num_rays, rays.single_ms, rays.single_hits, rays.batch_ms,
+                rays.batch_hits);
+    }
+
+    bool opened = true;
+    ImGui::Begin("Physics Benchmark", &opened, ImGuiWindowFlags_AlwaysAutoResize);
+
+    ImGui::Text("Config: %s", k_configs[s_config_index].name);
+    ImGui::Text("Bodies: %i", scene->num_entities - 2);
+    ImGui::Text("Last step: %.3fms (%i substeps)", stats.step_ms, stats.substeps);
+
+    if (samples > 0)
+        ImGui::Text("Avg: %.3fms Min: %.3fms Max: %.3fms (%i / %i)", total_ms / samples, min_ms, max_ms, samples,
+                    k_sample_frames);
+    else
+        ImGui::Text("Warming up...");
+
+    if (rays_done)
+    {
+        ImGui::Text("%i rays: one at a time %.3fms (%i hits), batch %.3fms (%i hits)", k_num_rays, rays.single_ms,
+                    rays.single_hits, rays.batch_ms, rays.batch_hits);
+
+        if (ImGui::Button("Cast Rays Again"))
+            rays = benchmark_rays();
+    }
+
+    const c8* names[k_num_configs];
+    for (s32 i = 0; i < k_num_configs; ++i)
+        names[i] = k_configs[i].name;
+
+    if (ImGui::Combo("Next Run", &next_config, names, k_num_configs))
+        dev_ui::set_program_preference("physics_benchmark_config", next_config);
+
+    ImGui::End();
+}
@@ -119,6 +119,7 @@ PEN_TRV pen::user_entry(void* params)
         put::vgt::post_update();
         pmfx::poll_for_changes();
         put::poll_hot_loader();
+        put::poll_streaming();
 
         // msg from the engine we want to terminate
         if (pen::semaphore_try_wait(p_thread_info->p_sem_exit))
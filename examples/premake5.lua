@@ -67,3 +67,5 @@ create_app_example( "ik", script_path() )
 create_app_example( "stencil_shadows", script_path() )
 create_app_example( "msaa_resolve", script_path() )
 create_app_example( "compute_demo", script_path() )
+create_app_example( "physics_benchmark", script_path() )
+create_app_example( "benchmarks", script_path() )
@@ -50,9 +50,20 @@ namespace pen
     uint32_t hashMurmur2A(char* _data);
 
     typedef HashMurmur2A hash_murmur;
+
+    // constexpr murmur2a, bit identical to hashMurmur2A for the same bytes
+    constexpr uint32_t hashMurmur2AConst(const char* _data, uint32_t _size);
+
+    // char arrays (string literals) hash at compile time and can be used in constant expressions and switch cases,
+    // everything else goes through the runtime hashMurmur2A
+    template <size_t N>
+    constexpr hash_id hash_string(const c8 (&str)[N]);
+
+    template <typename Ty>
+    hash_id hash_string(const Ty& v);
 } // namespace pen
 
-#define PEN_HASH(V) pen::hashMurmur2A(V)
+#define PEN_HASH(V) pen::hash_string(V)
 
 #include "hash.inl"
 
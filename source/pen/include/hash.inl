@@ -161,4 +161,86 @@ namespace pen
     {
         return hashMurmur2A(s.c_str());
     }
+
+    // constexpr path, single expression functions for c++11. processes the data as one add call: whole words
+    // little endian, the remaining bytes into the tail then the tail and size are mixed into the hash.
+    namespace murmur_const
+    {
+        constexpr uint32_t k_m = 0x5bd1e995u;
+
+        constexpr uint32_t mix_k(uint32_t k)
+        {
+            return ((k * k_m) ^ ((k * k_m) >> 24)) * k_m;
+        }
+
+        constexpr uint32_t mix(uint32_t h, uint32_t k)
+        {
+            return (h * k_m) ^ mix_k(k);
+        }
+
+        constexpr uint32_t byte(const char* data, uint32_t i)
+        {
+            return (uint32_t)(uint8_t)data[i];
+        }
+
+        constexpr uint32_t read_word(const char* data, uint32_t i)
+        {
+            return byte(data, i) | byte(data, i + 1) << 8 | byte(data, i + 2) << 16 | byte(data, i + 3) << 24;
+        }
+
+        constexpr uint32_t read_tail(const char* data, uint32_t i, uint32_t count)
+        {
+            return count == 0 ? 0 : byte(data, i) | read_tail(data, i + 1, count - 1) << 8;
+        }
+
+        constexpr uint32_t finalise_shift(uint32_t h)
+        {
+            return h ^ (h >> 15);
+        }
+
+        constexpr uint32_t finalise(uint32_t h)
+        {
+            return finalise_shift((h ^ (h >> 13)) * k_m);
+        }
+
+        constexpr uint32_t hash_words(const char* data, uint32_t i, uint32_t size, uint32_t h)
+        {
+            return size - i >= 4 ? hash_words(data, i + 4, size, mix(h, read_word(data, i)))
+                                 : finalise(mix(mix(h, read_tail(data, i, size - i)), size));
+        }
+
+        constexpr uint32_t length(const char* str, uint32_t i)
+        {
+            return str[i] ? length(str, i + 1) : i;
+        }
+    } // namespace murmur_const
+
+    constexpr uint32_t hashMurmur2AConst(const char* _data, uint32_t _size)
+    {
+        return murmur_const::hash_words(_data, 0, _size, 0);
+    }
+
+    template <size_t N>
+    constexpr hash_id hash_string(const c8 (&str)[N])
+    {
+        // hash up to the terminator to match hashMurmur2A(const char*) on char buffers
+        return hashMurmur2AConst(str, murmur_const::length(str, 0));
+    }
+
+    template <typename Ty>
+    inline hash_id hash_string(const Ty& v)
+    {
+        return hashMurmur2A(v);
+    }
+
+    // values from the runtime hashMurmur2A, covers whole words and tails of 1, 2 and 3 bytes
+    static_assert(hash_string("") == 0x00000000, "constexpr hash mismatch");
+    static_assert(hash_string("a") == 0x0803888b, "constexpr hash mismatch");
+    static_assert(hash_string("ab") == 0x618515af, "constexpr hash mismatch");
+    static_assert(hash_string("abc") == 0x11589f67, "constexpr hash mismatch");
+    static_assert(hash_string("cube") == 0xf8543d10, "constexpr hash mismatch");
+    static_assert(hash_string("hello") == 0x0f7e3bda, "constexpr hash mismatch");
+    static_assert(hash_string("main_scene") == 0x7b123c83, "constexpr hash mismatch");
+    static_assert(hash_string("front_light") == 0xcc16c435, "constexpr hash mismatch");
+    static_assert(hash_string("default_material") == 0x7dfc24b6, "constexpr hash mismatch");
 } // namespace pen
@@ -7,7 +7,8 @@
 
 // C++ wrapper api for JSMN.
 // Provides operators to access JSON objects and arrays and get retreive typed values.
-// json file is kept in a char buffer and jsmn tokens are used to iterate.
+// json file is kept in a char buffer and parsed once into a single array of jsmn tokens.
+// a json is a handle to a token in the shared, ref counted document so lookups and copies do not allocate or re-parse.
 // this api does not use any vectors or maps to store the json data.
 
 // Examples:
@@ -55,7 +56,7 @@
 
 namespace pen
 {
-    struct json_object;
+    struct json_document;
     class json;
 
     // functions
@@ -127,8 +128,13 @@ namespace pen
         }
 
       private:
-        json_object* m_internal_object;
-        void         copy(json* dst, const json& other);
+        json(json_document* document, s32 token, s32 key_token);
+
+        json_document* m_document;
+        s32            m_token;     // value token, -1 when null
+        s32            m_key_token; // member name token for object members, -1 otherwise
+        void           copy(json* dst, const json& other);
+        void           release();
     };
 
     // inline functions
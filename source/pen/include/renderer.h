@@ -343,6 +343,23 @@ namespace pen
         float padding_0, padding_1;
     };
 
+    struct renderer_cmd_buffer_stats
+    {
+        // per frame payload arena, sampled in renderer_consume_cmd_buffer
+        u32 payload_bytes = 0;
+        u32 payload_allocs = 0;
+        u32 payload_overflow_blocks = 0;
+        u32 payload_arena_size = 0;
+
+        // variable length commands written into the ring since the last consume
+        u32 cmds = 0;
+        u32 cmd_bytes = 0;
+
+        // state commands passed to the backend vs dropped as redundant, for the last presented frame
+        u32 state_cmds_issued = 0;
+        u32 state_cmds_elided = 0;
+    };
+
     //
 
     PEN_TRV              renderer_thread_function(void* params);
@@ -438,11 +455,24 @@ namespace pen
     void renderer_release_sampler(u32 sampler);
     void renderer_release_depth_stencil_state(u32 depth_stencil_state);
 
+    // command lists
+    // Job threads can record into their own command list, every renderer_ call made on a thread between begin and end
+    // is encoded into the list instead of the ring. Lists are spliced into the ring in order by submit, which must be
+    // called from the user thread before renderer_consume_cmd_buffer. Resource creation and release are not thread safe
+    // and should stay on the user thread.
+    struct command_list;
+    command_list* renderer_create_command_list();
+    void          renderer_release_command_list(command_list* cl);
+    void          renderer_begin_command_list(command_list* cl);
+    void          renderer_end_command_list();
+    void          renderer_submit_command_lists(command_list** lists, u32 num_lists);
+
     // cmd specific
     void renderer_window_resize(s32 width, s32 height);
     void renderer_consume_cmd_buffer();
     void renderer_update_queries();
     void renderer_get_present_time(f32& cpu_ms, f32& gpu_ms);
+    void renderer_get_cmd_buffer_stats(renderer_cmd_buffer_stats& stats);
 
     namespace direct
     {
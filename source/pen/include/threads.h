@@ -6,7 +6,7 @@
 #define _thread_h
 
 // Minimalist c-style thread wrapper api.
-// Includes functions to create jobs, threads, mutex and semaphore.
+// Includes functions to create jobs, tasks, threads, mutex and semaphore.
 
 #include "pen.h"
 
@@ -81,6 +81,37 @@ namespace pen
     job* jobs_create_job(PEN_THREAD_ROUTINE(thread_func), u32 stack_size, void* user_data, thread_start_flags flags,
                          completion_callback cb = nullptr);
 
+    // Tasks
+    // Work stealing scheduler over a pool of workers sized to the hardware, each worker owns a deque of tasks and
+    // steals from the others when it runs dry. Jobs above are for long lived system threads (render, audio, physics).
+    // A task_counter tracks tasks in flight, jobs_wait_for_counter runs other tasks until it reaches zero so it can be
+    // called from inside a task. Threads outside of the pool only run tasks of the counter they wait on.
+    // Counters must outlive their tasks and any tasks waiting on them.
+    typedef void (*task_func)(void* user_data);
+
+    struct task_decl
+    {
+        task_func func = nullptr;
+        void*     user_data = nullptr;
+    };
+
+    struct task_continuation;
+    struct task_counter
+    {
+        a_u32                           value = {0};
+        std::atomic<task_continuation*> continuations = {nullptr};
+    };
+
+    void jobs_run_tasks(const task_decl* tasks, u32 count, task_counter* counter = nullptr);
+    void jobs_run_tasks_after(task_counter* dependency, const task_decl* tasks, u32 count, task_counter* counter = nullptr);
+    void jobs_wait_for_counter(task_counter* counter);
+    u32  jobs_get_num_workers();
+
+    // Parallel for
+    // Splits [0, count) into tasks of grain indices, the calling thread helps and returns once every range has completed.
+    typedef void (*parallel_for_func)(u32 start, u32 end, void* user_data);
+    void parallel_for(u32 count, u32 grain, parallel_for_func func, void* user_data);
+
     // Mutex
     mutex* mutex_create();
     void   mutex_destroy(mutex* p_mutex);
@@ -6,6 +6,8 @@
 #include "threads.h"
 #include "memory.h"
 
+#include <thread>
+
 namespace pen
 {
 #define MAX_THREADS 8
@@ -71,6 +73,9 @@ namespace pen
         {
             pen::semaphore_post(s_jt[i].p_sem_exit, 1);
 
+            // wake threads which block waiting for work so they can see the exit request
+            pen::semaphore_post(s_jt[i].p_sem_consume, 1);
+
             if (pen::semaphore_try_wait(s_jt[i].p_sem_terminated))
             {
                 s_num_active_threads--;
@@ -83,4 +88,433 @@ namespace pen
 
         return true;
     }
+
+    // tasks -------------------------------------------------------------------------------------------------------------
+
+    struct task_continuation
+    {
+        task_continuation* next;
+        task_counter*      counter;
+        u32                count;
+        task_decl          tasks[1]; // allocated with count entries
+    };
+
+    namespace
+    {
+        const u32 k_deque_size = 4096; // power of 2, tasks which do not fit run inline
+        const u32 k_idle_spins = 64;   // failed steal attempts before a worker sleeps
+        const u32 k_push_batch = 64;
+        const u32 k_counter_busy = 0x80000000; // held by the last task while it schedules continuations
+
+        struct task_entry
+        {
+            task_func         func;
+            parallel_for_func range_func;
+            void*             user_data;
+            u32               start;
+            u32               end;
+            task_counter*     counter;
+        };
+
+        // chase-lev deque, the owner pushes and pops at the bottom and thieves take from the top
+        struct task_deque
+        {
+            std::atomic<s64> top = {0};
+            u8               pad_top[64];
+            std::atomic<s64> bottom = {0};
+            u8               pad_bottom[64];
+            task_entry       tasks[k_deque_size];
+        };
+
+        bool deque_push(task_deque& dq, const task_entry& t)
+        {
+            s64 b = dq.bottom.load(std::memory_order_relaxed);
+            s64 top = dq.top.load(std::memory_order_acquire);
+            if (b - top >= (s64)k_deque_size)
+                return false;
+
+            dq.tasks[b & (k_deque_size - 1)] = t;
+            dq.bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool deque_pop(task_deque& dq, task_entry& t)
+        {
+            s64 b = dq.bottom.load(std::memory_order_relaxed) - 1;
+            dq.bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            s64 top = dq.top.load(std::memory_order_relaxed);
+
+            if (top > b)
+            {
+                // empty
+                dq.bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            t = dq.tasks[b & (k_deque_size - 1)];
+            if (top == b)
+            {
+                // last task, race thieves for it
+                bool won = dq.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+                dq.bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        bool deque_steal(task_deque& dq, task_entry& t)
+        {
+            s64 top = dq.top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            s64 b = dq.bottom.load(std::memory_order_acquire);
+
+            if (top >= b)
+                return false;
+
+            // the copy is discarded if another thread claimed the slot first
+            t = dq.tasks[top & (k_deque_size - 1)];
+            return dq.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        struct worker
+        {
+            task_deque deque;
+            thread*    p_thread = nullptr;
+            u32        index = 0;
+        };
+
+        struct worker_pool
+        {
+            worker*    workers = nullptr;
+            u32        num_workers = 0;
+            semaphore* sem_work = nullptr;
+            mutex*     inject_mutex = nullptr; // owner side of inject for threads outside of the pool
+            task_deque inject;
+        };
+
+        worker_pool*     s_pool = nullptr;
+        thread_local s32 t_worker_index = -1;
+
+        void run_task(const task_entry& t);
+
+        bool find_task(worker_pool& pool, task_entry& t)
+        {
+            // own work first, newest first while it is still in cache
+            if (t_worker_index >= 0)
+            {
+                if (deque_pop(pool.workers[t_worker_index].deque, t))
+                    return true;
+            }
+            else if (mutex_try_lock(pool.inject_mutex))
+            {
+                bool found = deque_pop(pool.inject, t);
+                mutex_unlock(pool.inject_mutex);
+
+                if (found)
+                    return true;
+            }
+
+            if (deque_steal(pool.inject, t))
+                return true;
+
+            // steal oldest from the other workers starting next to our own index to spread contention
+            u32 first = t_worker_index >= 0 ? t_worker_index + 1 : 0;
+            for (u32 i = 0; i < pool.num_workers; ++i)
+            {
+                u32 w = (first + i) % pool.num_workers;
+                if ((s32)w == t_worker_index)
+                    continue;
+
+                if (deque_steal(pool.workers[w].deque, t))
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool find_counter_task(worker_pool& pool, task_counter* counter, task_entry& t)
+        {
+            // threads outside of the pool only help with the work they wait on, anything else in inject may be a long
+            // job (file loads, volume generation) which would stall the waiter well past its own counter
+            if (!mutex_try_lock(pool.inject_mutex))
+                return false;
+
+            // the mutex serialises the owner side so the bottom entry can not change between the peek and the pop
+            bool found = false;
+            s64  b = pool.inject.bottom.load(std::memory_order_relaxed);
+            if (b > pool.inject.top.load(std::memory_order_acquire) &&
+                pool.inject.tasks[(b - 1) & (k_deque_size - 1)].counter == counter)
+            {
+                found = deque_pop(pool.inject, t);
+            }
+
+            mutex_unlock(pool.inject_mutex);
+            return found;
+        }
+
+        void wake_workers(worker_pool& pool, u32 count)
+        {
+            semaphore_post(pool.sem_work, count < pool.num_workers ? count : pool.num_workers);
+        }
+
+        void push_tasks(worker_pool& pool, const task_entry* tasks, u32 count)
+        {
+            u32 pushed = 0;
+
+            if (t_worker_index >= 0)
+            {
+                task_deque& dq = pool.workers[t_worker_index].deque;
+                while (pushed < count && deque_push(dq, tasks[pushed]))
+                    ++pushed;
+            }
+            else
+            {
+                mutex_lock(pool.inject_mutex);
+                while (pushed < count && deque_push(pool.inject, tasks[pushed]))
+                    ++pushed;
+                mutex_unlock(pool.inject_mutex);
+            }
+
+            wake_workers(pool, pushed);
+
+            // deque is full
+            for (u32 i = pushed; i < count; ++i)
+                run_task(tasks[i]);
+        }
+
+        void push_decls(worker_pool& pool, const task_decl* tasks, u32 count, task_counter* counter)
+        {
+            task_entry batch[k_push_batch];
+            for (u32 i = 0; i < count; i += k_push_batch)
+            {
+                u32 n = count - i < k_push_batch ? count - i : k_push_batch;
+                for (u32 j = 0; j < n; ++j)
+                    batch[j] = {tasks[i + j].func, nullptr, tasks[i + j].user_data, 0, 0, counter};
+
+                push_tasks(pool, batch, n);
+            }
+        }
+
+        void run_continuations(task_counter* counter)
+        {
+            // whoever takes the list schedules it, completion and jobs_run_tasks_after can both race here
+            task_continuation* tc = counter->continuations.exchange(nullptr);
+            while (tc)
+            {
+                task_continuation* next = tc->next;
+                push_decls(*s_pool, tc->tasks, tc->count, tc->counter);
+                memory_free(tc);
+                tc = next;
+            }
+        }
+
+        void complete_task(task_counter* counter)
+        {
+            // the last task swaps in the busy bit so waiters only see zero once it no longer touches the counter
+            u32 v = counter->value.load();
+            for (;;)
+            {
+                if (v == 1)
+                {
+                    if (counter->value.compare_exchange_weak(v, k_counter_busy))
+                    {
+                        run_continuations(counter);
+                        counter->value -= k_counter_busy;
+                        return;
+                    }
+                }
+                else if (counter->value.compare_exchange_weak(v, v - 1))
+                {
+                    return;
+                }
+            }
+        }
+
+        void run_task(const task_entry& t)
+        {
+            if (t.range_func)
+                t.range_func(t.start, t.end, t.user_data);
+            else
+                t.func(t.user_data);
+
+            if (t.counter)
+                complete_task(t.counter);
+        }
+
+        PEN_TRV worker_thread_function(void* params)
+        {
+            worker* w = (worker*)params;
+            t_worker_index = w->index;
+
+            worker_pool& pool = *s_pool;
+
+            u32 idle = 0;
+            for (;;)
+            {
+                task_entry t;
+                if (find_task(pool, t))
+                {
+                    run_task(t);
+                    idle = 0;
+                    continue;
+                }
+
+                if (++idle < k_idle_spins)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                idle = 0;
+                semaphore_wait(pool.sem_work);
+            }
+
+            return PEN_THREAD_OK;
+        }
+
+        worker_pool* create_worker_pool()
+        {
+            worker_pool* pool = new worker_pool();
+
+            u32 hw = std::thread::hardware_concurrency();
+            pool->num_workers = hw > 1 ? hw - 1 : 1;
+
+            pool->sem_work = semaphore_create(0, 0x7fffffff);
+            pool->inject_mutex = mutex_create();
+            pool->workers = new worker[pool->num_workers];
+
+            for (u32 i = 0; i < pool->num_workers; ++i)
+                pool->workers[i].index = i;
+
+            // workers read s_pool, publish before they start
+            s_pool = pool;
+
+            for (u32 i = 0; i < pool->num_workers; ++i)
+                pool->workers[i].p_thread =
+                    thread_create(worker_thread_function, 1024 * 1024, &pool->workers[i], THREAD_START_DETACHED);
+
+            return pool;
+        }
+
+        worker_pool& get_pool()
+        {
+            // thread safe lazy init
+            static worker_pool* pool = create_worker_pool();
+            return *pool;
+        }
+    } // namespace
+
+    u32 jobs_get_num_workers()
+    {
+        return get_pool().num_workers;
+    }
+
+    void jobs_run_tasks(const task_decl* tasks, u32 count, task_counter* counter)
+    {
+        if (count == 0)
+            return;
+
+        if (counter)
+            counter->value += count;
+
+        push_decls(get_pool(), tasks, count, counter);
+    }
+
+    void jobs_run_tasks_after(task_counter* dependency, const task_decl* tasks, u32 count, task_counter* counter)
+    {
+        if (count == 0)
+            return;
+
+        if (!dependency)
+        {
+            jobs_run_tasks(tasks, count, counter);
+            return;
+        }
+
+        get_pool();
+
+        // count now so waiters on counter also wait for tasks which have not started yet
+        if (counter)
+            counter->value += count;
+
+        task_continuation* tc =
+            (task_continuation*)memory_alloc(sizeof(task_continuation) + sizeof(task_decl) * (count - 1));
+
+        tc->counter = counter;
+        tc->count = count;
+        for (u32 i = 0; i < count; ++i)
+            tc->tasks[i] = tasks[i];
+
+        tc->next = dependency->continuations.load();
+        while (!dependency->continuations.compare_exchange_weak(tc->next, tc))
+            ;
+
+        // dependency may have completed before the continuation was linked, let a completion in progress finish
+        u32 v;
+        while ((v = dependency->value) == k_counter_busy)
+            std::this_thread::yield();
+
+        if (v == 0)
+            run_continuations(dependency);
+    }
+
+    void jobs_wait_for_counter(task_counter* counter)
+    {
+        worker_pool& pool = get_pool();
+
+        while (counter->value > 0)
+        {
+            task_entry t;
+            bool       found = t_worker_index >= 0 ? find_task(pool, t) : find_counter_task(pool, counter, t);
+
+            if (found)
+                run_task(t);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    void parallel_for(u32 count, u32 grain, parallel_for_func func, void* user_data)
+    {
+        if (count == 0)
+            return;
+
+        if (grain == 0)
+            grain = 1;
+
+        if (count <= grain)
+        {
+            func(0, count, user_data);
+            return;
+        }
+
+        worker_pool& pool = get_pool();
+
+        // first range runs on the calling thread, the rest are pushed for workers to steal
+        u32          num_ranges = (count + grain - 1) / grain;
+        task_counter counter;
+        counter.value = num_ranges - 1;
+
+        task_entry batch[k_push_batch];
+        u32        n = 0;
+        for (u32 r = 1; r < num_ranges; ++r)
+        {
+            u32 start = r * grain;
+            u32 end = start + grain < count ? start + grain : count;
+            batch[n++] = {nullptr, func, user_data, start, end, &counter};
+
+            if (n == k_push_batch || r == num_ranges - 1)
+            {
+                push_tasks(pool, batch, n);
+                n = 0;
+            }
+        }
+
+        func(0, grain, user_data);
+
+        jobs_wait_for_counter(&counter);
+    }
 } // namespace pen
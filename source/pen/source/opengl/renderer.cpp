@@ -1026,11 +1026,12 @@ namespace pen
                 CHECK_CALL(glEnableVertexAttribArray(attribute.location));
 
                 u32 base_vertex_offset = g_bound_state.vertex_buffer_stride[v] * g_bound_state.base_vertex;
+                u32 buffer_offset = g_current_state.vertex_buffer_offset[v];
 
                 CHECK_CALL(glVertexAttribPointer(attribute.location, attribute.num_elements, attribute.type,
                                                  attribute.type == GL_UNSIGNED_BYTE ? true : false,
                                                  g_bound_state.vertex_buffer_stride[v],
-                                                 (void*)(attribute.offset + base_vertex_offset)));
+                                                 (void*)(size_t)(attribute.offset + base_vertex_offset + buffer_offset)));
 
                 CHECK_CALL(glVertexAttribDivisor(attribute.location, attribute.step_rate));
             }
@@ -1141,7 +1142,8 @@ namespace pen
         GLuint res = _res_pool[g_bound_state.index_buffer].handle;
         CHECK_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, res));
 
-        void* offset = (void*)(size_t)(start_index * 2);
+        u32   index_size = g_bound_state.index_format == GL_UNSIGNED_INT ? 4 : 2;
+        void* offset = (void*)(size_t)(start_index * index_size);
 
         CHECK_CALL(
             glDrawElementsBaseVertex(primitive_topology, index_count, g_bound_state.index_format, offset, base_vertex));
@@ -1158,8 +1160,8 @@ namespace pen
         GLuint res = _res_pool[g_bound_state.index_buffer].handle;
         CHECK_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, res));
 
-        // todo this needs to check index size 32 or 16 bit
-        void* offset = (void*)(size_t)(start_index * 2);
+        u32   index_size = g_bound_state.index_format == GL_UNSIGNED_INT ? 4 : 2;
+        void* offset = (void*)(size_t)(start_index * index_size);
 
         CHECK_CALL(glDrawElementsInstancedBaseVertex(primitive_topology, index_count, g_bound_state.index_format, offset,
                                                      instance_count, base_vertex));
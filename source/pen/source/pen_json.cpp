@@ -14,18 +14,15 @@ using namespace pen;
 
 namespace pen
 {
-    struct json_object
+    // one per loaded json, string and primitive tokens are null terminated in place after parsing
+    struct json_document
     {
-        jsmntok_t* tokens;
-        s32        num_tokens;
         c8*        data;
         u32        size;
-        c8*        name;
-
-        json_object get_object_by_name(const c8* name);
-        json_object get_object_by_index(const u32 index);
-
-        Str get_name() const;
+        jsmntok_t* tokens;
+        s32*       skip; // index of the token following each token's subtree
+        s32        num_tokens;
+        a_u32      ref_count;
     };
 } // namespace pen
 
@@ -40,14 +37,13 @@ namespace
 #define JSON_NAME NON_STRICT_NAME
 
     union json_value {
-        bool        b;
-        u32         u;
-        s32         s;
-        f32         f;
-        u64         ul;
-        s64         sl;
-        const c8*   str;
-        json_object object;
+        bool      b;
+        u32       u;
+        s32       s;
+        f32       f;
+        u64       ul;
+        s64       sl;
+        const c8* str;
     };
 
     enum PRIMITIVE_TYPE
@@ -62,16 +58,7 @@ namespace
         JSON_S64
     };
 
-    struct enumerate_params
-    {
-        bool       get_next;
-        int        return_value;
-        jsmntok_t* name_token;
-    };
-
-    void create_json_object(json_object& jo);
-
-    int jsoneq(const char* json, jsmntok_t* tok, const char* s)
+    int jsoneq(const char* json, const jsmntok_t* tok, const char* s)
     {
         if ((int)strlen(s) == tok->end - tok->start && strncmp(json + tok->start, s, tok->end - tok->start) == 0)
         {
@@ -80,7 +67,7 @@ namespace
         return -1;
     }
 
-    int _dump(Str& output, const char* js, jsmntok_t* t, size_t count, int indent)
+    int _dump(Str& output, const char* js, const jsmntok_t* t, size_t count, int indent)
     {
         int i, j, k;
         if (count == 0)
@@ -136,48 +123,41 @@ namespace
         return 0;
     }
 
-    bool enumerate_primitve(const char* js, jsmntok_t* t, json_value& result, PRIMITIVE_TYPE type)
+    // strings are treated as primitives so quoted and unquoted values read the same
+    bool enumerate_primitve(const char* js, const jsmntok_t* t, json_value& result, PRIMITIVE_TYPE type)
     {
-        if (t->type == JSMN_PRIMITIVE)
+        if (t->type == JSMN_PRIMITIVE || t->type == JSMN_STRING)
         {
+            const c8* tok_str = js + t->start;
+
             switch (type)
             {
                 case JSON_STR:
-                    result.str = js;
+                    result.str = tok_str;
                     break;
 
                 case JSON_U32:
                 case JSON_S32:
                 case JSON_U64:
                 case JSON_S64:
-                {
-                    c8* tok_str = pen::sub_string(js + t->start, t->end - t->start);
                     result.ul = atoll(tok_str);
-                    pen::memory_free(tok_str);
-                }
-                break;
+                    break;
 
                 case JSON_U32_HEX:
-                {
-                    c8* tok_str = pen::sub_string(js + t->start, t->end - t->start);
                     result.u = strtol(tok_str, NULL, 16);
-                    pen::memory_free(tok_str);
                     break;
-                }
+
                 case JSON_F32:
-                {
-                    c8* tok_str = pen::sub_string(js + t->start, t->end - t->start);
                     result.f = (f32)atof(tok_str);
-                    pen::memory_free(tok_str);
-                }
-                break;
+                    break;
+
                 case JSON_BOOL:
-                    if (*(js + t->start) == 't')
+                    if (*tok_str == 't')
                     {
                         result.b = true;
                         return true;
                     }
-                    else if (*(js + t->start) == 'f')
+                    else if (*tok_str == 'f')
                     {
                         result.b = false;
                         return true;
@@ -192,269 +172,124 @@ namespace
         return false;
     }
 
-    bool is_key(const char* js, size_t jsize, jsmntok_t* t, size_t count)
+    bool as_value(json_value& jv, const json_document* doc, s32 token, PRIMITIVE_TYPE type)
     {
-        if (count < 1)
+        if (token < 0)
             return false;
 
-        jsmntok_t* next = t + 1;
-
-        u32 num = next->start - t->end;
-
-        static c8 buf[64];
-        pen::sub_string(js + t->end, buf, std::min<u32>(num, 63));
-
-        for (u32 i = 0; i <= num; ++i)
-            if (buf[i] == ':')
-                return true;
-
-        return false;
+        return enumerate_primitve(doc->data, &doc->tokens[token], jv, type);
     }
 
-    int enumerate(const char* js, size_t jsize, jsmntok_t* t, size_t count, int indent, const c8* search_name,
-                  s32 search_index, json_value& result, enumerate_params& ep)
+    s32 build_skip(json_document* doc, s32 token)
     {
-        if (ep.return_value != 0)
-            return ep.return_value;
-
-        int i, j;
-        if (count == 0)
-            return 0;
-
-        if (t->type == JSMN_PRIMITIVE)
-        {
-            if (result.object.name)
-                pen::memory_free(result.object.name);
-
-            result.object.name = pen::sub_string(js + t->start, t->end - t->start);
-
-            if (indent == 1)
-            {
-                if (search_name == nullptr)
-                {
-                    ep.get_next = true;
-                }
-                else if (jsoneq(js, t, search_name) == 0)
-                {
-                    if (is_key(js, jsize, t, count))
-                        ep.get_next = true;
-                }
-            }
-            return 1;
-        }
-        else if (t->type == JSMN_STRING)
-        {
-            if (result.object.name)
-                pen::memory_free(result.object.name);
+        const jsmntok_t& t = doc->tokens[token];
 
-            result.object.name = pen::sub_string(js + t->start, t->end - t->start);
-
-            if (indent == 1)
-            {
-                if (search_name == nullptr)
-                {
-                    ep.get_next = true;
-                }
-                else if (jsoneq(js, t, search_name) == 0)
-                {
-                    if (is_key(js, jsize, t, count))
-                        ep.get_next = true;
-                }
-            }
-            return 1;
-        }
-        else if (t->type == JSMN_OBJECT)
+        s32 next = token + 1;
+        if (t.type == JSMN_OBJECT)
         {
-            j = 0;
-            for (i = 0; i < t->size; i++)
+            // key tokens are followed by their value
+            for (s32 i = 0; i < t.size && next + 1 < doc->num_tokens; ++i)
             {
-                j += enumerate(js, jsize, t + 1 + j, count - j, indent + 1, search_name, search_index, result, ep);
-
-                if ((indent == 0 && search_index == i) || ep.get_next)
-                {
-                    jsmntok_t* at = t + 1 + j;
-
-                    result.object.data = pen::sub_string(js + at->start, at->end - at->start);
-                    result.object.size = at->end - at->start;
-
-                    create_json_object(result.object);
-
-                    ep.return_value = 1;
-                    ep.get_next = false;
-                    return 1;
-                }
-
-                j += enumerate(js, jsize, t + 1 + j, count - j, indent + 1, search_name, search_index, result, ep);
+                doc->skip[next] = next + 1;
+                next = build_skip(doc, next + 1);
             }
-            return j + 1;
         }
-        else if (t->type == JSMN_ARRAY)
+        else if (t.type == JSMN_ARRAY)
         {
-            if (ep.get_next)
-            {
-                result.object.data = pen::sub_string(js + t->start, t->end - t->start);
-                result.object.size = t->end - t->start;
-
-                create_json_object(result.object);
-
-                ep.return_value = 1;
-                ep.get_next = false;
-                return 1;
-            }
-
-            j = 0;
-            for (i = 0; i < t->size; i++)
-            {
-                if (indent == 0 && search_index == i)
-                {
-                    jsmntok_t* at = t + 1 + j;
-
-                    result.object.data = pen::sub_string(js + at->start, at->end - at->start);
-                    result.object.size = at->end - at->start;
-
-                    create_json_object(result.object);
-
-                    ep.return_value = 1;
-                    ep.get_next = false;
-                    return 1;
-                }
-
-                j += enumerate(js, jsize, t + 1 + j, count - j, indent + 1, search_name, search_index, result, ep);
-            }
-            return j + 1;
+            for (s32 i = 0; i < t.size && next < doc->num_tokens; ++i)
+                next = build_skip(doc, next);
         }
 
-        return ep.return_value;
+        doc->skip[token] = next;
+        return next;
     }
 
-    bool as_value(json_value& jv, json_object* jo, PRIMITIVE_TYPE type)
-    {
-        if (jo->num_tokens <= 0 || jo->num_tokens > 1)
-            return false;
-
-        return enumerate_primitve(jo->data, jo->tokens, jv, type);
-    }
-
-    json_object get_object(json_object* jo, const c8* name, s32 index)
-    {
-        json_value jv;
-        jv.object.name = nullptr;
-        jv.object.tokens = nullptr;
-        jv.object.data = nullptr;
-        jv.object.num_tokens = 0;
-
-        if (jo == NULL)
-            return jv.object;
-
-        enumerate_params ep = {false, 0, nullptr};
-
-        enumerate(jo->data, jo->size, jo->tokens, jo->num_tokens, 0, name, index, jv, ep);
-
-        return jv.object;
-    }
-
-    void create_json_object(json_object& jo)
+    // takes ownership of data which must have space for a null terminator at size
+    json_document* create_json_document(c8* data, u32 size)
     {
         jsmn_parser p;
 
-        // default try 64 tokens
-        u32 token_count = 64;
-        jo.tokens = new jsmntok_t[token_count];
+        // count then parse
+        jsmn_init(&p);
+        s32 num_tokens = jsmn_parse(&p, data, size, nullptr, 0);
 
-        bool loaded = false;
-        while (!loaded)
+        jsmntok_t* tokens = nullptr;
+        if (num_tokens > 0)
         {
-            jsmn_init(&p);
-            jo.num_tokens = jsmn_parse(&p, jo.data, jo.size, jo.tokens, token_count);
-            if (jo.num_tokens < JSMN_ERROR_NOMEM)
-            {
-                PEN_LOG("Failed to parse JSON: %d\n", jo.num_tokens);
-                break;
-            }
-            else if (jo.num_tokens == JSMN_ERROR_NOMEM)
-            {
-                // allocate space for more tokens
-                delete jo.tokens;
-
-                token_count <<= 1;
-                jo.tokens = new jsmntok_t[token_count];
-
-                continue;
-            }
+            tokens = (jsmntok_t*)pen::memory_alloc(sizeof(jsmntok_t) * num_tokens);
 
-            loaded = true;
-            break;
+            jsmn_init(&p);
+            num_tokens = jsmn_parse(&p, data, size, tokens, num_tokens);
         }
 
-        if (!loaded)
+        if (num_tokens <= 0)
         {
-            delete jo.tokens;
-            jo.tokens = nullptr;
-
-            jo.num_tokens = 0;
+            if (num_tokens < 0)
+                PEN_LOG("Failed to parse JSON: %d\n", num_tokens);
 
-            pen::memory_free(jo.data);
-            jo.data = nullptr;
+            pen::memory_free(tokens);
+            pen::memory_free(data);
+            return nullptr;
         }
-    }
-} // namespace
 
-namespace pen
-{
-    Str json_object::get_name() const
-    {
-        return Str(this->name);
-    }
+        json_document* doc = (json_document*)pen::memory_alloc(sizeof(json_document));
+        doc->data = data;
+        doc->size = size;
+        doc->tokens = tokens;
+        doc->num_tokens = num_tokens;
+        doc->skip = (s32*)pen::memory_alloc(sizeof(s32) * num_tokens);
+        doc->ref_count = 0;
 
-    json_object json_object::get_object_by_name(const c8* name)
-    {
-        return get_object(this, name, -1);
+        for (s32 i = 0; i < num_tokens; i = doc->skip[i])
+            build_skip(doc, i);
+
+        for (s32 i = 0; i < num_tokens; ++i)
+            if (tokens[i].type == JSMN_PRIMITIVE || tokens[i].type == JSMN_STRING)
+                data[tokens[i].end] = '\0';
+
+        return doc;
     }
 
-    json_object json_object::get_object_by_index(const u32 index)
+    void destroy_json_document(json_document* doc)
     {
-        return get_object(this, "__unused_ai__", index);
+        pen::memory_free(doc->data);
+        pen::memory_free(doc->tokens);
+        pen::memory_free(doc->skip);
+        pen::memory_free(doc);
     }
+} // namespace
 
+namespace pen
+{
     //------------------------------------------------------------------------------
     // C++ Public API
     //------------------------------------------------------------------------------
     json json::load_from_file(const c8* filename)
     {
-        json new_json;
-
         void* data = nullptr;
         u32   size = 0;
 
         pen_error err = pen::filesystem_read_file_to_buffer(filename, &data, size);
 
-        if (err == PEN_ERR_OK)
-        {
-            new_json.m_internal_object = (json_object*)memory_alloc(sizeof(json_object));
-            new_json.m_internal_object->data = (c8*)data;
-            new_json.m_internal_object->size = size;
-            new_json.m_internal_object->name = nullptr;
+        if (err != PEN_ERR_OK)
+            return json();
 
-            create_json_object(*new_json.m_internal_object);
-        }
+        json_document* doc = create_json_document((c8*)data, size);
+        if (!doc)
+            return json();
 
-        return new_json;
+        return json(doc, 0, -1);
     }
 
     json json::load(const c8* json_str)
     {
-        json new_json;
-
-        new_json.m_internal_object = (json_object*)memory_alloc(sizeof(json_object));
-
-        new_json.m_internal_object->data = pen::sub_string(json_str, pen::string_length(json_str));
-
-        new_json.m_internal_object->size = pen::string_length(json_str);
-        new_json.m_internal_object->name = nullptr;
+        u32 size = pen::string_length(json_str);
 
-        create_json_object(*new_json.m_internal_object);
+        json_document* doc = create_json_document(pen::sub_string(json_str, size), size);
+        if (!doc)
+            return json();
 
-        return new_json;
+        return json(doc, 0, -1);
     }
 
     enum combine_action
@@ -487,8 +322,6 @@ namespace pen
 
             Str name1 = j3.name();
 
-            bool action = false;
-
             for (s32 j = 0; j < s2; ++j)
             {
                 json j4 = j2[j];
@@ -509,8 +342,6 @@ namespace pen
                         j1_action[i] = json_discard;
                         j2_action[j] = json_keep;
                     }
-
-                    action = true;
                 }
             }
         }
@@ -525,7 +356,7 @@ namespace pen
                 JSON_NAME(json_string);
 
                 json_string.append(": ");
-                json_string.append(j1[i].m_internal_object->data);
+                json_string.append(j1[i].dumps().c_str());
                 json_string.append(",\n");
             }
 
@@ -556,7 +387,7 @@ namespace pen
                 JSON_NAME(json_string);
 
                 json_string.append(": ");
-                json_string.append(j2[i].m_internal_object->data);
+                json_string.append(j2[i].dumps().c_str());
                 json_string.append(",\n");
             }
         }
@@ -575,31 +406,71 @@ namespace pen
 
     u32 json::size() const
     {
-        if (m_internal_object->num_tokens > 0)
-            if (m_internal_object->tokens[0].type == JSMN_ARRAY || m_internal_object->tokens[0].type == JSMN_OBJECT)
-                return m_internal_object->tokens[0].size;
+        if (m_token < 0)
+            return 0;
+
+        const jsmntok_t& t = m_document->tokens[m_token];
+        if (t.type == JSMN_ARRAY || t.type == JSMN_OBJECT)
+            return t.size;
 
         return 0;
     }
 
     json json::operator[](const c8* name) const
     {
-        json new_json;
+        if (m_token < 0)
+            return json();
+
+        const jsmntok_t* tokens = m_document->tokens;
+        if (tokens[m_token].type != JSMN_OBJECT)
+            return json();
 
-        new_json.m_internal_object = (json_object*)memory_alloc(sizeof(json_object));
+        // walk keys, skipping over each value's subtree
+        s32 key = m_token + 1;
+        for (s32 i = 0; i < tokens[m_token].size && key + 1 < m_document->num_tokens; ++i)
+        {
+            if (jsoneq(m_document->data, &tokens[key], name) == 0)
+                return json(m_document, key + 1, key);
+
+            key = m_document->skip[key + 1];
+        }
 
-        *new_json.m_internal_object = m_internal_object->get_object_by_name(name);
-        return new_json;
+        return json();
     }
 
     json json::operator[](const u32 index) const
     {
-        json new_json;
+        if (m_token < 0)
+            return json();
+
+        const jsmntok_t& t = m_document->tokens[m_token];
+        if (index >= (u32)t.size)
+            return json();
+
+        s32 next = m_token + 1;
+        if (t.type == JSMN_OBJECT)
+        {
+            // members by index, value with its key
+            for (u32 i = 0; i < index; ++i)
+                next = m_document->skip[next + 1];
+
+            if (next + 1 >= m_document->num_tokens)
+                return json();
+
+            return json(m_document, next + 1, next);
+        }
+        else if (t.type == JSMN_ARRAY)
+        {
+            for (u32 i = 0; i < index; ++i)
+                next = m_document->skip[next];
 
-        new_json.m_internal_object = (json_object*)memory_alloc(sizeof(json_object));
+            if (next >= m_document->num_tokens)
+                return json();
 
-        *new_json.m_internal_object = m_internal_object->get_object_by_index(index);
-        return new_json;
+            return json(m_document, next, -1);
+        }
+
+        return json();
     }
 
     json json::operator[](const s32 index) const
@@ -609,48 +480,46 @@ namespace pen
 
     json::json()
     {
-        m_internal_object = nullptr;
+        m_document = nullptr;
+        m_token = -1;
+        m_key_token = -1;
     }
 
-    void json::copy(json* dst, const json& other)
+    json::json(json_document* document, s32 token, s32 key_token)
     {
-        dst->m_internal_object = nullptr;
-
-        if (other.m_internal_object == nullptr)
-            return;
-
-        dst->m_internal_object = (json_object*)memory_alloc(sizeof(json_object));
+        m_document = document;
+        m_token = token;
+        m_key_token = key_token;
 
-        // shallow copy default copy ctor
-        *dst->m_internal_object = *other.m_internal_object;
+        m_document->ref_count++;
+    }
 
-        u32 num_tokens = other.m_internal_object->num_tokens;
-        dst->m_internal_object->tokens = new jsmntok_t[num_tokens];
-        memcpy(dst->m_internal_object->tokens, other.m_internal_object->tokens, sizeof(jsmntok_t) * num_tokens);
+    void json::release()
+    {
+        if (m_document && --m_document->ref_count == 0)
+            destroy_json_document(m_document);
 
-        // deep copy take ownership of mem
-        if (other.m_internal_object->data)
-        {
-            s32 data_size = string_length(other.m_internal_object->data);
+        m_document = nullptr;
+        m_token = -1;
+        m_key_token = -1;
+    }
 
-            dst->m_internal_object->data = (c8*)memory_alloc(data_size + 1);
-            memcpy(dst->m_internal_object->data, other.m_internal_object->data, data_size);
-            dst->m_internal_object->data[data_size] = '\0';
-        }
+    void json::copy(json* dst, const json& other)
+    {
+        // share the document
+        if (other.m_document)
+            other.m_document->ref_count++;
 
-        // take ownership of name
-        if (other.m_internal_object->name)
-        {
-            s32 name_size = string_length(other.m_internal_object->name);
-            m_internal_object->name = (c8*)memory_alloc(name_size + 1);
-            m_internal_object->name[name_size] = '\0';
+        dst->release();
 
-            memcpy(m_internal_object->name, other.m_internal_object->name, name_size);
-        }
+        dst->m_document = other.m_document;
+        dst->m_token = other.m_token;
+        dst->m_key_token = other.m_key_token;
     }
 
     json::json(const json& other)
     {
+        m_document = nullptr;
         copy(this, other);
     }
 
@@ -664,8 +533,8 @@ namespace pen
     Str json::as_str(const c8* default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_STR))
-            return m_internal_object->data;
+        if (as_value(jv, m_document, m_token, JSON_STR))
+            return jv.str;
 
         return default_value;
     }
@@ -673,8 +542,8 @@ namespace pen
     const c8* json::as_cstr(const c8* default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_STR))
-            return m_internal_object->data;
+        if (as_value(jv, m_document, m_token, JSON_STR))
+            return jv.str;
 
         return default_value;
     }
@@ -683,7 +552,7 @@ namespace pen
     {
         const c8* cstr = as_cstr();
         if (!cstr)
-            return 0;
+            return default_value;
 
         return PEN_HASH(cstr);
     }
@@ -691,7 +560,7 @@ namespace pen
     u32 json::as_u32(u32 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_U32))
+        if (as_value(jv, m_document, m_token, JSON_U32))
             return jv.u;
 
         return default_value;
@@ -700,7 +569,7 @@ namespace pen
     s32 json::as_s32(s32 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_S32))
+        if (as_value(jv, m_document, m_token, JSON_S32))
             return jv.s;
 
         return default_value;
@@ -709,7 +578,7 @@ namespace pen
     u64 json::as_u64(u64 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_U64))
+        if (as_value(jv, m_document, m_token, JSON_U64))
             return jv.ul;
 
         return default_value;
@@ -718,7 +587,7 @@ namespace pen
     s64 json::as_s64(s64 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_S64))
+        if (as_value(jv, m_document, m_token, JSON_S64))
             return jv.sl;
 
         return default_value;
@@ -727,7 +596,7 @@ namespace pen
     bool json::as_bool(bool default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_BOOL))
+        if (as_value(jv, m_document, m_token, JSON_BOOL))
             return jv.b;
 
         return default_value;
@@ -736,7 +605,7 @@ namespace pen
     f32 json::as_f32(f32 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_F32))
+        if (as_value(jv, m_document, m_token, JSON_F32))
             return jv.f;
 
         return default_value;
@@ -745,7 +614,7 @@ namespace pen
     u8 json::as_u8_hex(u8 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_U32_HEX))
+        if (as_value(jv, m_document, m_token, JSON_U32_HEX))
             return jv.u;
 
         return default_value;
@@ -754,7 +623,7 @@ namespace pen
     u32 json::as_u32_hex(u32 default_value) const
     {
         json_value jv;
-        if (as_value(jv, m_internal_object, JSON_U32_HEX))
+        if (as_value(jv, m_document, m_token, JSON_U32_HEX))
             return jv.u;
 
         return default_value;
@@ -772,29 +641,32 @@ namespace pen
     Str json::dumps() const
     {
         Str t;
-        _dump(t, m_internal_object->data, m_internal_object->tokens, m_internal_object->num_tokens, 0);
+        if (m_token < 0)
+            return t;
+
+        _dump(t, m_document->data, &m_document->tokens[m_token], m_document->skip[m_token] - m_token, 0);
         return t;
     }
 
     Str json::name() const
     {
-        return m_internal_object->get_name();
+        if (m_key_token < 0)
+            return Str();
+
+        return Str(m_document->data + m_document->tokens[m_key_token].start);
     }
 
     Str json::key() const
     {
-        return m_internal_object->get_name();
+        return name();
     }
 
     jsmntype_t json::type() const
     {
-        if (!m_internal_object)
+        if (m_token < 0)
             return JSMN_UNDEFINED;
 
-        if (m_internal_object->num_tokens <= 0)
-            return JSMN_UNDEFINED;
-
-        return m_internal_object->tokens[0].type;
+        return m_document->tokens[m_token].type;
     }
 
     bool json::is_null() const
@@ -804,16 +676,7 @@ namespace pen
 
     json::~json()
     {
-        if (m_internal_object)
-        {
-            delete[] m_internal_object->tokens;
-
-            pen::memory_free(m_internal_object->data);
-            pen::memory_free(m_internal_object->name);
-        }
-
-        pen::memory_free(m_internal_object);
-        m_internal_object = nullptr;
+        release();
     }
 
     void json::set(const c8* name, const Str val)
@@ -828,12 +691,9 @@ namespace pen
 
         pen::json json_set = pen::json::load(new_json_object.c_str());
 
-        if (m_internal_object)
+        if (m_document)
         {
             pen::json combined = combine(*this, json_set);
-
-            // free mem and copy combined
-            this->~json();
             *this = combined;
         }
         else
@@ -863,12 +723,9 @@ namespace pen
 
         pen::json json_set = pen::json::load(new_json_object.c_str());
 
-        if (m_internal_object)
+        if (m_document)
         {
             pen::json combined = combine(*this, json_set);
-
-            // free mem and copy combined
-            this->~json();
             *this = combined;
         }
         else
@@ -140,7 +140,8 @@ namespace pen
 
     void semaphore_post(semaphore* p_semaphore, u32 count)
     {
-        sem_post(p_semaphore->handle);
+        for (u32 i = 0; i < count; ++i)
+            sem_post(p_semaphore->handle);
     }
 
     void thread_sleep_ms(u32 milliseconds)
@@ -23,6 +23,9 @@
 #include "stb/stb_image_write.h"
 
 #define MAX_COMMANDS (1 << 21)
+#define CMD_BUFFER_SIZE (MAX_COMMANDS * 24)
+#define CMD_PAYLOAD_ARENA_SIZE (4 * 1024 * 1024)
+#define CMD_PAYLOAD_ALIGN 16
 
 extern pen::window_creation_params pen_window;
 
@@ -83,7 +86,8 @@ namespace
         CMD_PUSH_PERF_MARKER,
         CMD_POP_PERF_MARKER,
         CMD_DISPATCH_COMPUTE,
-        CMD_SET_STENCIL_REF
+        CMD_SET_STENCIL_REF,
+        CMD_WRAP
     };
 
     struct set_shader_cmd
@@ -191,9 +195,12 @@ namespace
         uint3 num_threads;
     };
 
+    // Commands are variable length, only the 8 byte header and the active union member are written into the ring.
+    // Payloads which are large or variable sized live out of line in the payload arena or a memory_alloc.
     struct renderer_cmd
     {
-        u32 command_index;
+        u16 command_index;
+        u16 command_size;
         u32 resource_slot;
 
         union {
@@ -224,7 +231,7 @@ namespace
             resource_read_back_params        rrb_params;
             msaa_resolve_params              resolve_params;
             replace_resource                 replace_resource_params;
-            clear_state                      clear_state_params;
+            clear_state*                     p_clear_state;
             c8*                              name;
             compute_dispatch_params          cs_dispatch;
             u8                               stencil_ref;
@@ -233,10 +240,486 @@ namespace
         renderer_cmd(){};
     };
 
-    pen::timer*               _present_timer;
-    f32                       _present_time;
-    pen::resolve_resources    _resolve_resources;
-    ring_buffer<renderer_cmd> _cmd_buffer;
+    static const u32 k_cmd_header_size = 8;
+    static const u32 k_cmd_align = 8;
+    static_assert(offsetof(renderer_cmd, command_data_index) == k_cmd_header_size, "renderer_cmd header size mismatch");
+
+    // lockless single producer single consumer byte ring. a command never straddles the end of the ring,
+    // when one does not fit a CMD_WRAP header is written and the producer restarts at 0.
+    // the allocation has sizeof(renderer_cmd) of slack so a header can always be written at _capacity.
+    struct cmd_ring
+    {
+        u8*   data = nullptr;
+        u32   capacity = 0;
+        a_u32 put_pos;
+        a_u32 get_pos;
+
+        void create(u32 size)
+        {
+            capacity = size;
+            data = (u8*)pen::memory_alloc_align(capacity + sizeof(renderer_cmd), k_cmd_align);
+            put_pos = 0;
+            get_pos = 0;
+        }
+
+        u32 wrap(u32 pp, u32 size)
+        {
+            if (pp + size <= capacity)
+                return pp;
+
+            renderer_cmd* wrap = (renderer_cmd*)(data + pp);
+            wrap->command_index = CMD_WRAP;
+            wrap->command_size = 0;
+            return 0;
+        }
+
+        void put(const renderer_cmd& cmd)
+        {
+            u32 pp = wrap(put_pos, cmd.command_size);
+
+            memcpy(data + pp, &cmd, cmd.command_size);
+            put_pos = pp + cmd.command_size;
+        }
+
+        // write a block of pre-encoded commands, a single memcpy unless the block crosses the end of the ring
+        void put_block(const u8* cmds, u32 size)
+        {
+            u32 pp = put_pos;
+            if (pp + size <= capacity)
+            {
+                memcpy(data + pp, cmds, size);
+                put_pos = pp + size;
+                return;
+            }
+
+            u32 pos = 0;
+            while (pos < size)
+            {
+                const renderer_cmd* cmd = (const renderer_cmd*)(cmds + pos);
+                pp = wrap(pp, cmd->command_size);
+                memcpy(data + pp, cmd, cmd->command_size);
+                pp += cmd->command_size;
+                pos += cmd->command_size;
+            }
+
+            put_pos = pp;
+        }
+
+        const renderer_cmd* get()
+        {
+            u32 gp = get_pos;
+            if (gp == put_pos)
+                return nullptr;
+
+            const renderer_cmd* cmd = (const renderer_cmd*)(data + gp);
+            if (cmd->command_index == CMD_WRAP)
+            {
+                gp = 0;
+                cmd = (const renderer_cmd*)data;
+            }
+
+            get_pos = gp + cmd->command_size;
+            return cmd;
+        }
+    };
+
+    // Linear allocator for per frame command payloads (buffer updates, vertex buffer arrays, marker names).
+    // Double buffered, the user thread writes frame n + 1 while the render thread consumes frame n.
+    // Payloads are never freed individually, the whole arena is reclaimed in renderer_consume_cmd_buffer once the
+    // render thread is guaranteed to have executed every command which referenced it.
+    // Allocation is lock free so command lists can be recorded from job threads, overflow takes a mutex.
+    struct payload_arena
+    {
+        u8*      block = nullptr;
+        size_t   block_size = 0;
+        a_size_t pos = {0};
+
+        // if the main block is exhausted overflow blocks are allocated, main block grows on the next reset
+        u8**   overflow = nullptr;
+        size_t overflow_pos = 0;
+        size_t overflow_size = 0;
+
+        a_u32 bytes = {0};
+        a_u32 allocs = {0};
+    };
+
+    pen::timer*                    _present_timer;
+    f32                            _present_time;
+    pen::resolve_resources         _resolve_resources;
+    cmd_ring                       _cmd_buffer;
+    payload_arena                  _payload_arena[2];
+    u32                            _payload_arena_index = 0;
+    pen::renderer_cmd_buffer_stats _cmd_buffer_stats;
+    u32                            _cmd_bytes = 0;
+    u32                            _cmd_count = 0;
+    pen::mutex*                    _payload_mutex = nullptr;
+    u32                            _state_issued = 0;
+    u32                            _state_elided = 0;
+    a_u32                          _state_issued_frame = {0};
+    a_u32                          _state_elided_frame = {0};
+
+    void payload_arena_init(payload_arena& arena, size_t size)
+    {
+        arena.block = (u8*)pen::memory_alloc_align(size, CMD_PAYLOAD_ALIGN);
+        arena.block_size = size;
+        arena.pos = 0;
+        arena.bytes = 0;
+        arena.allocs = 0;
+    }
+
+    void payload_arena_reset(payload_arena& arena)
+    {
+        u32 num_overflow = sb_count(arena.overflow);
+        if (num_overflow > 0)
+        {
+            for (u32 i = 0; i < num_overflow; ++i)
+                pen::memory_free_align(arena.overflow[i]);
+
+            sb_free(arena.overflow);
+            arena.overflow = nullptr;
+            arena.overflow_pos = 0;
+            arena.overflow_size = 0;
+
+            // grow so the next frame of this size fits in the main block
+            size_t new_size = arena.block_size;
+            while (new_size < arena.bytes)
+                new_size *= 2;
+
+            pen::memory_free_align(arena.block);
+            payload_arena_init(arena, new_size);
+            return;
+        }
+
+        arena.pos = 0;
+        arena.bytes = 0;
+        arena.allocs = 0;
+    }
+
+    void* payload_alloc(size_t size)
+    {
+        payload_arena& arena = _payload_arena[_payload_arena_index];
+
+        size = (size + (CMD_PAYLOAD_ALIGN - 1)) & ~((size_t)CMD_PAYLOAD_ALIGN - 1);
+
+        arena.bytes += (u32)size;
+        arena.allocs++;
+
+        size_t pos = arena.pos.fetch_add(size);
+        if (pos + size <= arena.block_size)
+            return arena.block + pos;
+
+        pen::mutex_lock(_payload_mutex);
+
+        if (!arena.overflow || arena.overflow_pos + size > arena.overflow_size)
+        {
+            arena.overflow_size = std::max<size_t>(size, arena.block_size);
+            arena.overflow_pos = 0;
+            sb_push(arena.overflow, (u8*)pen::memory_alloc_align(arena.overflow_size, CMD_PAYLOAD_ALIGN));
+        }
+
+        void* mem = sb_last(arena.overflow) + arena.overflow_pos;
+        arena.overflow_pos += size;
+
+        pen::mutex_unlock(_payload_mutex);
+
+        return mem;
+    }
+
+    void cmd_buffer_end_frame()
+    {
+        payload_arena& submitted = _payload_arena[_payload_arena_index];
+
+        _cmd_buffer_stats.payload_bytes = submitted.bytes;
+        _cmd_buffer_stats.payload_allocs = submitted.allocs;
+        _cmd_buffer_stats.payload_overflow_blocks = sb_count(submitted.overflow);
+        _cmd_buffer_stats.payload_arena_size = (u32)submitted.block_size;
+        _cmd_buffer_stats.cmd_bytes = _cmd_bytes;
+        _cmd_buffer_stats.cmds = _cmd_count;
+        _cmd_buffer_stats.state_cmds_issued = _state_issued_frame;
+        _cmd_buffer_stats.state_cmds_elided = _state_elided_frame;
+        _cmd_bytes = 0;
+        _cmd_count = 0;
+
+        // the other arena was used 2 consumes ago and is no longer referenced by the render thread
+        _payload_arena_index ^= 1;
+        payload_arena_reset(_payload_arena[_payload_arena_index]);
+    }
+
+    void command_list_put(pen::command_list* cl, const renderer_cmd& cmd);
+
+    // when a command list is bound the calling thread records into it instead of the ring
+    thread_local pen::command_list* t_command_list = nullptr;
+
+    inline void cmd_buffer_put(renderer_cmd& cmd, u32 payload_size)
+    {
+        cmd.command_size = (u16)((k_cmd_header_size + payload_size + (k_cmd_align - 1)) & ~(k_cmd_align - 1));
+
+        if (t_command_list)
+        {
+            command_list_put(t_command_list, cmd);
+            return;
+        }
+
+        _cmd_buffer.put(cmd);
+
+        _cmd_bytes += cmd.command_size;
+        _cmd_count++;
+    }
+} // namespace
+
+namespace pen
+{
+    // commands encoded exactly as they are in the ring so submit is a straight copy
+    struct command_list
+    {
+        u8* data = nullptr;
+        u32 size = 0;
+        u32 capacity = 0;
+        u32 num_cmds = 0;
+    };
+} // namespace pen
+
+namespace
+{
+    void command_list_put(pen::command_list* cl, const renderer_cmd& cmd)
+    {
+        if (cl->size + cmd.command_size > cl->capacity)
+        {
+            cl->capacity = std::max<u32>(cl->capacity * 2, 4096);
+            while (cl->size + cmd.command_size > cl->capacity)
+                cl->capacity *= 2;
+
+            cl->data = (u8*)pen::memory_realloc(cl->data, cl->capacity);
+        }
+
+        memcpy(cl->data + cl->size, &cmd, cmd.command_size);
+        cl->size += cmd.command_size;
+        cl->num_cmds++;
+    }
+
+    // Shadow of the state last passed to the direct:: backend, redundant state commands are elided at exec time.
+    // Filtering on the render thread sees the final command order after command lists have been spliced in.
+    // Invalidated (all 0xff) by anything which may change bindings behind our back: targets, clears, resolves,
+    // resource creation / release and present.
+    static const u32 k_max_shadow_slots = 32;
+    static const u32 k_max_shadow_vbs = 8;
+
+    struct state_shadow
+    {
+        u32                     shader[4]; // vs, ps, so, cs
+        u32                     input_layout;
+        u32                     raster_state;
+        u32                     blend_state;
+        u32                     depth_stencil_state;
+        u32                     stencil_ref;
+        set_index_buffer_cmd    index_buffer;
+        u32                     vb_start_slot;
+        u32                     vb_num;
+        u32                     vb[k_max_shadow_vbs * 3];
+        set_constant_buffer_cmd cbuffer[k_max_shadow_slots];
+        set_texture_cmd         texture[k_max_shadow_slots];
+        viewport                vp;
+        rect                    scissor;
+    };
+
+    state_shadow _shadow;
+
+    void state_shadow_invalidate()
+    {
+        memset(&_shadow, 0xff, sizeof(_shadow));
+    }
+
+    void state_shadow_invalidate_textures()
+    {
+        memset(&_shadow.texture, 0xff, sizeof(_shadow.texture));
+    }
+
+    s32 shadow_shader_index(u32 shader_type)
+    {
+        switch (shader_type)
+        {
+            case PEN_SHADER_TYPE_VS:
+                return 0;
+            case PEN_SHADER_TYPE_PS:
+                return 1;
+            case PEN_SHADER_TYPE_SO:
+                return 2;
+            case PEN_SHADER_TYPE_CS:
+                return 3;
+            default:
+                return -1;
+        }
+    }
+
+    template <typename T>
+    inline bool shadow_test(T& shadow, const T& v)
+    {
+        if (memcmp(&shadow, &v, sizeof(T)) == 0)
+            return true;
+
+        memcpy(&shadow, &v, sizeof(T));
+        return false;
+    }
+
+    bool state_shadow_test(const renderer_cmd& cmd)
+    {
+        switch (cmd.command_index)
+        {
+            case CMD_SET_SHADER:
+            {
+                s32 i = shadow_shader_index(cmd.set_shader.shader_type);
+                if (i < 0)
+                    return false;
+
+                if (_shadow.shader[i] == cmd.set_shader.shader_index)
+                    return true;
+
+                // stream out replaces vs + ps and setting a vs clears stream out in some backends
+                if (i == 2)
+                    _shadow.shader[0] = _shadow.shader[1] = PEN_INVALID_HANDLE;
+                else if (i == 0)
+                    _shadow.shader[2] = PEN_INVALID_HANDLE;
+
+                _shadow.shader[i] = cmd.set_shader.shader_index;
+                return false;
+            }
+
+            case CMD_SET_INPUT_LAYOUT:
+                return shadow_test(_shadow.input_layout, cmd.command_data_index);
+
+            case CMD_SET_RASTER_STATE:
+                return shadow_test(_shadow.raster_state, cmd.command_data_index);
+
+            case CMD_SET_BLEND_STATE:
+                return shadow_test(_shadow.blend_state, cmd.command_data_index);
+
+            case CMD_SET_DEPTH_STENCIL_STATE:
+                return shadow_test(_shadow.depth_stencil_state, cmd.command_data_index);
+
+            case CMD_SET_STENCIL_REF:
+                return shadow_test(_shadow.stencil_ref, (u32)cmd.stencil_ref);
+
+            case CMD_SET_INDEX_BUFFER:
+                return shadow_test(_shadow.index_buffer, cmd.set_index_buffer);
+
+            case CMD_SET_VERTEX_BUFFER:
+            {
+                // backends track the number of bound buffers, so only an identical call is redundant
+                const set_vertex_buffer_cmd& vb = cmd.set_vertex_buffer;
+                if (vb.num_buffers > k_max_shadow_vbs)
+                {
+                    _shadow.vb_num = PEN_INVALID_HANDLE;
+                    return false;
+                }
+
+                u32  n = vb.num_buffers;
+                bool redundant = _shadow.vb_start_slot == vb.start_slot && _shadow.vb_num == n;
+                redundant &= memcmp(&_shadow.vb[0], vb.buffer_indices, sizeof(u32) * n) == 0;
+                redundant &= memcmp(&_shadow.vb[n], vb.strides, sizeof(u32) * n) == 0;
+                redundant &= memcmp(&_shadow.vb[n * 2], vb.offsets, sizeof(u32) * n) == 0;
+
+                if (redundant)
+                    return true;
+
+                _shadow.vb_start_slot = vb.start_slot;
+                _shadow.vb_num = n;
+                memcpy(&_shadow.vb[0], vb.buffer_indices, sizeof(u32) * n);
+                memcpy(&_shadow.vb[n], vb.strides, sizeof(u32) * n);
+                memcpy(&_shadow.vb[n * 2], vb.offsets, sizeof(u32) * n);
+                return false;
+            }
+
+            case CMD_SET_CONSTANT_BUFFER:
+            {
+                u32 slot = cmd.set_constant_buffer.resource_slot;
+                if (slot >= k_max_shadow_slots)
+                    return false;
+
+                return shadow_test(_shadow.cbuffer[slot], cmd.set_constant_buffer);
+            }
+
+            case CMD_SET_TEXTURE:
+            {
+                u32 slot = cmd.set_texture.resource_slot;
+                if (slot >= k_max_shadow_slots)
+                    return false;
+
+                if (shadow_test(_shadow.texture[slot], cmd.set_texture))
+                    return true;
+
+                // sampler state may be stored on the texture object (gl),
+                // other slots holding the same texture can no longer be trusted
+                for (u32 i = 0; i < k_max_shadow_slots; ++i)
+                    if (i != slot && _shadow.texture[i].texture_index == cmd.set_texture.texture_index)
+                        memset(&_shadow.texture[i], 0xff, sizeof(set_texture_cmd));
+
+                return false;
+            }
+
+            case CMD_SET_VIEWPORT:
+            {
+                if (shadow_test(_shadow.vp, cmd.set_viewport))
+                    return true;
+
+                // scissor is relative to the viewport in some backends
+                memset(&_shadow.scissor, 0xff, sizeof(rect));
+                return false;
+            }
+
+            case CMD_SET_SCISSOR_RECT:
+                return shadow_test(_shadow.scissor, cmd.set_rect);
+
+            // commands which do not change bound state
+            case CMD_DRAW:
+            case CMD_DRAW_INDEXED:
+            case CMD_DRAW_INDEXED_INSTANCED:
+            case CMD_UPDATE_BUFFER:
+            case CMD_PUSH_PERF_MARKER:
+            case CMD_POP_PERF_MARKER:
+            case CMD_UPDATE_QUERIES:
+            case CMD_SET_SO_TARGET:
+                return false;
+
+            case CMD_DISPATCH_COMPUTE:
+            case CMD_DRAW_AUTO:
+                state_shadow_invalidate_textures();
+                return false;
+
+            case CMD_PRESENT:
+                _state_issued_frame = _state_issued;
+                _state_elided_frame = _state_elided;
+                _state_issued = 0;
+                _state_elided = 0;
+                state_shadow_invalidate();
+                return false;
+
+            default:
+                state_shadow_invalidate();
+                return false;
+        }
+    }
+
+    inline bool state_cmd(u32 command_index)
+    {
+        switch (command_index)
+        {
+            case CMD_SET_SHADER:
+            case CMD_SET_INPUT_LAYOUT:
+            case CMD_SET_RASTER_STATE:
+            case CMD_SET_BLEND_STATE:
+            case CMD_SET_DEPTH_STENCIL_STATE:
+            case CMD_SET_STENCIL_REF:
+            case CMD_SET_INDEX_BUFFER:
+            case CMD_SET_VERTEX_BUFFER:
+            case CMD_SET_CONSTANT_BUFFER:
+            case CMD_SET_TEXTURE:
+            case CMD_SET_VIEWPORT:
+            case CMD_SET_SCISSOR_RECT:
+                return true;
+            default:
+                return false;
+        }
+    }
 } // namespace
 
 namespace pen
@@ -249,6 +732,53 @@ namespace pen
         gpu_ms = (f64)g_gpu_total / 1000.0 / 1000.0;
     }
 
+    void renderer_get_cmd_buffer_stats(renderer_cmd_buffer_stats& stats)
+    {
+        stats = _cmd_buffer_stats;
+    }
+
+    command_list* renderer_create_command_list()
+    {
+        return new command_list();
+    }
+
+    void renderer_release_command_list(command_list* cl)
+    {
+        memory_free(cl->data);
+        delete cl;
+    }
+
+    void renderer_begin_command_list(command_list* cl)
+    {
+        PEN_ASSERT_MSG(!t_command_list, "a command list is already being recorded on this thread");
+
+        cl->size = 0;
+        cl->num_cmds = 0;
+        t_command_list = cl;
+    }
+
+    void renderer_end_command_list()
+    {
+        t_command_list = nullptr;
+    }
+
+    void renderer_submit_command_lists(command_list** lists, u32 num_lists)
+    {
+        PEN_ASSERT_MSG(!t_command_list, "command lists must be submitted from the thread which owns the ring");
+
+        for (u32 i = 0; i < num_lists; ++i)
+        {
+            command_list* cl = lists[i];
+            if (!cl || cl->size == 0)
+                continue;
+
+            _cmd_buffer.put_block(cl->data, cl->size);
+
+            _cmd_bytes += cl->size;
+            _cmd_count += cl->num_cmds;
+        }
+    }
+
     void exec_cmd(const renderer_cmd& cmd)
     {
         switch (cmd.command_index)
@@ -303,9 +833,6 @@ namespace pen
                 direct::renderer_set_vertex_buffers(cmd.set_vertex_buffer.buffer_indices, cmd.set_vertex_buffer.num_buffers,
                                                     cmd.set_vertex_buffer.start_slot, cmd.set_vertex_buffer.strides,
                                                     cmd.set_vertex_buffer.offsets);
-                memory_free(cmd.set_vertex_buffer.buffer_indices);
-                memory_free(cmd.set_vertex_buffer.strides);
-                memory_free(cmd.set_vertex_buffer.offsets);
                 break;
 
             case CMD_SET_INDEX_BUFFER:
@@ -392,7 +919,6 @@ namespace pen
             case CMD_UPDATE_BUFFER:
                 direct::renderer_update_buffer(cmd.update_buffer.buffer_index, cmd.update_buffer.data,
                                                cmd.update_buffer.data_size, cmd.update_buffer.offset);
-                memory_free(cmd.update_buffer.data);
                 break;
 
             case CMD_CREATE_DEPTH_STENCIL_STATE:
@@ -464,7 +990,7 @@ namespace pen
                 break;
 
             case CMD_CREATE_CLEAR_STATE:
-                direct::renderer_create_clear_state(cmd.clear_state_params, cmd.resource_slot);
+                direct::renderer_create_clear_state(*cmd.p_clear_state, cmd.resource_slot);
                 break;
 
             case CMD_PUSH_PERF_MARKER:
@@ -511,6 +1037,8 @@ namespace pen
             semaphore_wait(p_continue_semaphore);
         }
 
+        cmd_buffer_end_frame();
+
         // sync on window surface
         direct::renderer_sync();
     }
@@ -531,11 +1059,20 @@ namespace pen
 
 			s32 cmds = 0;
 
-            renderer_cmd* cmd = _cmd_buffer.get();
+            const renderer_cmd* cmd = _cmd_buffer.get();
             while (cmd)
             {
-                renderer_cmd foff = *cmd;
-                exec_cmd(foff);
+                if (state_shadow_test(*cmd))
+                {
+                    _state_elided++;
+                }
+                else
+                {
+                    if (state_cmd(cmd->command_index))
+                        _state_issued++;
+
+                    exec_cmd(*cmd);
+                }
 
                 cmd = _cmd_buffer.get();
 
@@ -706,7 +1243,14 @@ namespace pen
         if (!p_continue_semaphore)
             p_continue_semaphore = semaphore_create(0, 1);
 
-        _cmd_buffer.create(MAX_COMMANDS);
+        _cmd_buffer.create(CMD_BUFFER_SIZE);
+
+        for (u32 i = 0; i < 2; ++i)
+            payload_arena_init(_payload_arena[i], CMD_PAYLOAD_ARENA_SIZE);
+
+        _payload_mutex = mutex_create();
+
+        state_shadow_invalidate();
         slot_resources_init(&s_renderer_slot_resources, 2048);
 
         // initialise renderer
@@ -749,7 +1293,7 @@ namespace pen
         renderer_cmd cmd;
 
         cmd.command_index = CMD_UPDATE_QUERIES;
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, 0);
     }
 
     void renderer_clear(u32 clear_state_index, u32 array_index)
@@ -760,7 +1304,7 @@ namespace pen
         cmd.clear.clear_state = clear_state_index;
         cmd.clear.array_index = array_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.clear));
     }
 
     void renderer_present()
@@ -769,7 +1313,7 @@ namespace pen
 
         cmd.command_index = CMD_PRESENT;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, 0);
     }
 
     u32 renderer_load_shader(const shader_load_params& params)
@@ -801,7 +1345,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.shader_load));
 
         return resource_slot;
     }
@@ -851,7 +1395,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.link_params));
 
         return resource_slot;
     }
@@ -865,7 +1409,7 @@ namespace pen
         cmd.set_shader.shader_index = shader_index;
         cmd.set_shader.shader_type = shader_type;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_shader));
     }
 
     u32 renderer_create_input_layout(const input_layout_creation_params& params)
@@ -891,7 +1435,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_input_layout));
 
         return resource_slot;
     }
@@ -904,7 +1448,7 @@ namespace pen
 
         cmd.command_data_index = layout_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     u32 renderer_create_buffer(const buffer_creation_params& params)
@@ -925,7 +1469,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_buffer));
 
         return resource_slot;
     }
@@ -945,9 +1489,10 @@ namespace pen
         cmd.set_vertex_buffer.start_slot = start_slot;
         cmd.set_vertex_buffer.num_buffers = num_buffers;
 
-        cmd.set_vertex_buffer.buffer_indices = (u32*)memory_alloc(sizeof(u32) * num_buffers);
-        cmd.set_vertex_buffer.strides = (u32*)memory_alloc(sizeof(u32) * num_buffers);
-        cmd.set_vertex_buffer.offsets = (u32*)memory_alloc(sizeof(u32) * num_buffers);
+        u32* payload = (u32*)payload_alloc(sizeof(u32) * num_buffers * 3);
+        cmd.set_vertex_buffer.buffer_indices = payload;
+        cmd.set_vertex_buffer.strides = payload + num_buffers;
+        cmd.set_vertex_buffer.offsets = payload + num_buffers * 2;
 
         for (u32 i = 0; i < num_buffers; ++i)
         {
@@ -956,7 +1501,7 @@ namespace pen
             cmd.set_vertex_buffer.offsets[i] = offsets[i];
         }
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_vertex_buffer));
     }
 
     void renderer_set_index_buffer(u32 buffer_index, u32 format, u32 offset)
@@ -968,7 +1513,7 @@ namespace pen
         cmd.set_index_buffer.format = format;
         cmd.set_index_buffer.offset = offset;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_index_buffer));
     }
 
     void renderer_draw(u32 vertex_count, u32 start_vertex, u32 primitive_topology)
@@ -980,7 +1525,7 @@ namespace pen
         cmd.draw.start_vertex = start_vertex;
         cmd.draw.primitive_topology = primitive_topology;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.draw));
     }
 
     void renderer_draw_indexed(u32 index_count, u32 start_index, u32 base_vertex, u32 primitive_topology)
@@ -993,7 +1538,7 @@ namespace pen
         cmd.draw_indexed.base_vertex = base_vertex;
         cmd.draw_indexed.primitive_topology = primitive_topology;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.draw_indexed));
     }
 
     void renderer_draw_indexed_instanced(u32 instance_count, u32 start_instance, u32 index_count, u32 start_index,
@@ -1009,7 +1554,7 @@ namespace pen
         cmd.draw_indexed_instanced.base_vertex = base_vertex;
         cmd.draw_indexed_instanced.primitive_topology = primitive_topology;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.draw_indexed_instanced));
     }
 
     u32 renderer_create_render_target(const texture_creation_params& tcp)
@@ -1025,7 +1570,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_render_target));
 
         return resource_slot;
     }
@@ -1063,7 +1608,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_texture));
 
         return resource_slot;
     }
@@ -1080,7 +1625,7 @@ namespace pen
         cmd.set_shader.shader_index = shader_index;
         cmd.set_shader.shader_type = shader_type;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_shader));
     }
 
     void renderer_release_buffer(u32 buffer_index)
@@ -1094,7 +1639,7 @@ namespace pen
 
         cmd.command_data_index = buffer_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_release_texture(u32 texture_index)
@@ -1108,7 +1653,7 @@ namespace pen
 
         cmd.command_data_index = texture_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     u32 renderer_create_sampler(const sampler_creation_params& scp)
@@ -1122,7 +1667,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_sampler));
 
         return resource_slot;
     }
@@ -1138,7 +1683,7 @@ namespace pen
         cmd.set_texture.resource_slot = resource_slot;
         cmd.set_texture.bind_flags = bind_flags;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_texture));
     }
 
     u32 renderer_create_rasterizer_state(const rasteriser_state_creation_params& rscp)
@@ -1152,7 +1697,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_raster_state));
 
         return resource_slot;
     }
@@ -1165,7 +1710,7 @@ namespace pen
 
         cmd.command_data_index = rasterizer_state_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_set_viewport(const viewport& vp)
@@ -1176,7 +1721,7 @@ namespace pen
 
         memcpy(&cmd.set_viewport, (void*)&vp, sizeof(viewport));
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_viewport));
     }
 
     void renderer_set_scissor_rect(const rect& r)
@@ -1187,7 +1732,7 @@ namespace pen
 
         memcpy(&cmd.set_rect, (void*)&r, sizeof(rect));
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_rect));
     }
 
     void renderer_release_raster_state(u32 raster_state_index)
@@ -1201,7 +1746,7 @@ namespace pen
 
         cmd.command_data_index = raster_state_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     u32 renderer_create_blend_state(const blend_creation_params& bcp)
@@ -1222,7 +1767,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.create_blend_state));
 
         return resource_slot;
     }
@@ -1235,7 +1780,7 @@ namespace pen
 
         cmd.command_data_index = blend_state_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_set_constant_buffer(u32 buffer_index, u32 resource_slot, u32 flags)
@@ -1248,16 +1793,13 @@ namespace pen
         cmd.set_constant_buffer.resource_slot = resource_slot;
         cmd.set_constant_buffer.flags = flags;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_constant_buffer));
     }
 
     void renderer_update_buffer(u32 buffer_index, const void* data, u32 data_size, u32 offset)
     {
         renderer_cmd cmd;
 
-        if (buffer_index == 80)
-            u32 a = 0;
-
         if (buffer_index == 0)
             return;
 
@@ -1266,10 +1808,10 @@ namespace pen
         cmd.update_buffer.buffer_index = buffer_index;
         cmd.update_buffer.data_size = data_size;
         cmd.update_buffer.offset = offset;
-        cmd.update_buffer.data = memory_alloc(data_size);
+        cmd.update_buffer.data = payload_alloc(data_size);
         memcpy(cmd.update_buffer.data, data, data_size);
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.update_buffer));
     }
 
     u32 renderer_create_depth_stencil_state(const depth_stencil_creation_params& dscp)
@@ -1286,7 +1828,7 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.p_create_depth_stencil_state));
 
         return resource_slot;
     }
@@ -1299,7 +1841,7 @@ namespace pen
 
         cmd.command_data_index = depth_stencil_state;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_set_targets(u32* colour_targets, u32 num_colour_targets, u32 depth_target, u32 array_index)
@@ -1312,7 +1854,7 @@ namespace pen
         cmd.set_targets.depth = depth_target;
         cmd.set_targets.array_index = array_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_targets));
     }
 
     void renderer_set_targets(u32 colour_target, u32 depth_target)
@@ -1325,7 +1867,7 @@ namespace pen
         cmd.set_targets.depth = depth_target;
         cmd.set_targets.array_index = 0;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.set_targets));
     }
 
     void renderer_release_blend_state(u32 blend_state)
@@ -1338,7 +1880,7 @@ namespace pen
         cmd.command_index = CMD_RELEASE_BLEND_STATE;
         cmd.command_data_index = blend_state;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_release_render_target(u32 render_target)
@@ -1352,7 +1894,7 @@ namespace pen
 
         cmd.command_data_index = render_target;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_release_clear_state(u32 clear_state)
@@ -1366,7 +1908,7 @@ namespace pen
 
         cmd.command_data_index = clear_state;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_release_input_layout(u32 input_layout)
@@ -1380,7 +1922,7 @@ namespace pen
 
         cmd.command_data_index = input_layout;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_release_sampler(u32 sampler)
@@ -1394,7 +1936,7 @@ namespace pen
 
         cmd.command_data_index = sampler;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_release_depth_stencil_state(u32 depth_stencil_state)
@@ -1408,7 +1950,7 @@ namespace pen
 
         cmd.command_data_index = depth_stencil_state;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_set_stream_out_target(u32 buffer_index)
@@ -1419,7 +1961,7 @@ namespace pen
 
         cmd.command_data_index = buffer_index;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.command_data_index));
     }
 
     void renderer_resolve_target(u32 target, e_msaa_resolve_type type)
@@ -1431,7 +1973,7 @@ namespace pen
         cmd.resolve_params.render_target = target;
         cmd.resolve_params.resolve_type = type;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.resolve_params));
     }
 
     void renderer_draw_auto()
@@ -1440,7 +1982,7 @@ namespace pen
 
         cmd.command_index = CMD_DRAW_AUTO;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, 0);
     }
 
     void renderer_dispatch_compute(uint3 grid, uint3 num_threads)
@@ -1451,7 +1993,7 @@ namespace pen
         cmd.cs_dispatch.grid = grid;
         cmd.cs_dispatch.num_threads = num_threads;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.cs_dispatch));
     }
 
     void renderer_read_back_resource(const resource_read_back_params& rrbp)
@@ -1462,7 +2004,7 @@ namespace pen
 
         cmd.rrb_params = rrbp;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.rrb_params));
     }
 
     void renderer_replace_resource(u32 dest, u32 src, e_renderer_resource type)
@@ -1473,7 +2015,7 @@ namespace pen
 
         cmd.replace_resource_params = {dest, src, type};
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.replace_resource_params));
     }
 
     u32 renderer_create_clear_state(const clear_state& cs)
@@ -1483,10 +2025,11 @@ namespace pen
         u32 resource_slot = slot_resources_get_next(&s_renderer_slot_resources);
 
         cmd.command_index = CMD_CREATE_CLEAR_STATE;
-        cmd.clear_state_params = cs;
+        cmd.p_clear_state = (clear_state*)payload_alloc(sizeof(clear_state));
+        memcpy(cmd.p_clear_state, &cs, sizeof(clear_state));
         cmd.resource_slot = resource_slot;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.p_clear_state));
 
         return resource_slot;
     }
@@ -1498,7 +2041,7 @@ namespace pen
         cmd.command_index = CMD_SET_STENCIL_REF;
         cmd.stencil_ref = ref;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.stencil_ref));
     }
 
     void renderer_push_perf_marker(const c8* name)
@@ -1509,11 +2052,11 @@ namespace pen
 
         // make copy of string to be able to use temporaries
         u32 len = string_length(name);
-        cmd.name = (c8*)memory_alloc(len);
+        cmd.name = (c8*)payload_alloc(len + 1);
         memcpy(cmd.name, name, len);
         cmd.name[len] = '\0';
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, sizeof(cmd.name));
     }
 
     void renderer_pop_perf_marker()
@@ -1522,7 +2065,7 @@ namespace pen
 
         cmd.command_index = CMD_POP_PERF_MARKER;
 
-        _cmd_buffer.put(cmd);
+        cmd_buffer_put(cmd, 0);
     }
 
     // graphics test
@@ -12,6 +12,9 @@ project "put"
     language "C++"
     
     if platform_dir == "ios" then defines { PEN_GLES3 } end
+
+    -- must match the bullet lib build
+    defines { "BT_THREADSAFE=1" }
     
     libdirs
     { 
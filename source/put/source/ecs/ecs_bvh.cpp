@@ -0,0 +1,591 @@
+// ecs_bvh.cpp
+// Copyright 2014 - 2019 Alex Dixon.
+// License: https://github.com/polymonster/pmtech/blob/master/license.md
+
+#include "ecs/ecs_bvh.h"
+#include "ecs/ecs_scene.h"
+
+#include "data_struct.h"
+#include "memory.h"
+
+namespace
+{
+    const s32 k_null_node = -1;
+    const u32 k_max_stack = 256;
+    const f32 k_fat_margin = 0.1f; // fraction of the leaf size added on each side
+    const f32 k_fat_min_margin = 0.01f;
+} // namespace
+
+namespace put
+{
+    namespace ecs
+    {
+        static inline bool is_leaf(const bvh_node& node)
+        {
+            return node.left == k_null_node;
+        }
+
+        static inline f32 surface_area(const vec3f& min, const vec3f& max)
+        {
+            vec3f e = max - min;
+            return e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+
+        static inline void merge(const bvh_node& a, const bvh_node& b, bvh_node& out)
+        {
+            out.min = vec3f::vmin(a.min, b.min);
+            out.max = vec3f::vmax(a.max, b.max);
+        }
+
+        static inline bool contains(const bvh_node& node, const vec3f& min, const vec3f& max)
+        {
+            return node.min.x <= min.x && node.min.y <= min.y && node.min.z <= min.z && node.max.x >= max.x &&
+                   node.max.y >= max.y && node.max.z >= max.z;
+        }
+
+        static s32 alloc_node(bvh& tree)
+        {
+            if (tree.free_list == k_null_node)
+            {
+                u32 new_capacity = tree.capacity ? tree.capacity * 2 : 64;
+                tree.nodes = (bvh_node*)pen::memory_realloc(tree.nodes, new_capacity * sizeof(bvh_node));
+
+                for (u32 i = tree.capacity; i < new_capacity; ++i)
+                    tree.nodes[i].parent = i + 1 < new_capacity ? i + 1 : k_null_node;
+
+                tree.free_list = tree.capacity;
+                tree.capacity = new_capacity;
+            }
+
+            s32 index = tree.free_list;
+            tree.free_list = tree.nodes[index].parent;
+
+            bvh_node& node = tree.nodes[index];
+            node.parent = k_null_node;
+            node.left = k_null_node;
+            node.right = k_null_node;
+            node.height = 0;
+            node.entity = PEN_INVALID_HANDLE;
+
+            return index;
+        }
+
+        static void free_node(bvh& tree, s32 index)
+        {
+            tree.nodes[index].parent = tree.free_list;
+            tree.nodes[index].height = -1;
+            tree.free_list = index;
+        }
+
+        static void fix_node(bvh& tree, s32 index)
+        {
+            bvh_node& node = tree.nodes[index];
+            bvh_node& l = tree.nodes[node.left];
+            bvh_node& r = tree.nodes[node.right];
+
+            merge(l, r, node);
+            node.height = 1 + max(l.height, r.height);
+        }
+
+        // avl style rotation, promotes the taller grandchild when children heights differ by more than 1
+        static s32 balance(bvh& tree, s32 ia)
+        {
+            bvh_node* nodes = tree.nodes;
+            bvh_node& a = nodes[ia];
+
+            if (is_leaf(a) || a.height < 2)
+                return ia;
+
+            s32       ib = a.left;
+            s32       ic = a.right;
+            bvh_node& b = nodes[ib];
+            bvh_node& c = nodes[ic];
+
+            s32 bal = c.height - b.height;
+
+            // rotate c up
+            if (bal > 1)
+            {
+                s32       if_ = c.left;
+                s32       ig = c.right;
+                bvh_node& f = nodes[if_];
+                bvh_node& g = nodes[ig];
+
+                c.left = ia;
+                c.parent = a.parent;
+                a.parent = ic;
+
+                if (c.parent != k_null_node)
+                {
+                    if (nodes[c.parent].left == ia)
+                        nodes[c.parent].left = ic;
+                    else
+                        nodes[c.parent].right = ic;
+                }
+                else
+                {
+                    tree.root = ic;
+                }
+
+                if (f.height > g.height)
+                {
+                    c.right = if_;
+                    a.right = ig;
+                    g.parent = ia;
+                }
+                else
+                {
+                    c.right = ig;
+                    a.right = if_;
+                    f.parent = ia;
+                }
+
+                fix_node(tree, ia);
+                fix_node(tree, ic);
+                return ic;
+            }
+
+            // rotate b up
+            if (bal < -1)
+            {
+                s32       id = b.left;
+                s32       ie = b.right;
+                bvh_node& d = nodes[id];
+                bvh_node& e = nodes[ie];
+
+                b.left = ia;
+                b.parent = a.parent;
+                a.parent = ib;
+
+                if (b.parent != k_null_node)
+                {
+                    if (nodes[b.parent].left == ia)
+                        nodes[b.parent].left = ib;
+                    else
+                        nodes[b.parent].right = ib;
+                }
+                else
+                {
+                    tree.root = ib;
+                }
+
+                if (d.height > e.height)
+                {
+                    b.right = id;
+                    a.left = ie;
+                    e.parent = ia;
+                }
+                else
+                {
+                    b.right = ie;
+                    a.left = id;
+                    d.parent = ia;
+                }
+
+                fix_node(tree, ia);
+                fix_node(tree, ib);
+                return ib;
+            }
+
+            return ia;
+        }
+
+        static void refit_to_root(bvh& tree, s32 index)
+        {
+            while (index != k_null_node)
+            {
+                index = balance(tree, index);
+                fix_node(tree, index);
+                index = tree.nodes[index].parent;
+            }
+        }
+
+        static void insert_leaf(bvh& tree, s32 leaf)
+        {
+            if (tree.root == k_null_node)
+            {
+                tree.root = leaf;
+                tree.nodes[leaf].parent = k_null_node;
+                return;
+            }
+
+            // find the cheapest sibling by surface area heuristic
+            const vec3f lmin = tree.nodes[leaf].min;
+            const vec3f lmax = tree.nodes[leaf].max;
+
+            s32 index = tree.root;
+            while (!is_leaf(tree.nodes[index]))
+            {
+                const bvh_node& node = tree.nodes[index];
+
+                f32 area = surface_area(node.min, node.max);
+                f32 combined_area = surface_area(vec3f::vmin(node.min, lmin), vec3f::vmax(node.max, lmax));
+
+                // cost of creating a new parent here, and of pushing the leaf further down
+                f32 cost = 2.0f * combined_area;
+                f32 inheritance_cost = 2.0f * (combined_area - area);
+
+                f32 child_cost[2];
+                s32 children[2] = {node.left, node.right};
+                for (u32 i = 0; i < 2; ++i)
+                {
+                    const bvh_node& child = tree.nodes[children[i]];
+                    f32 child_area = surface_area(vec3f::vmin(child.min, lmin), vec3f::vmax(child.max, lmax));
+
+                    if (!is_leaf(child))
+                        child_area -= surface_area(child.min, child.max);
+
+                    child_cost[i] = child_area + inheritance_cost;
+                }
+
+                if (cost < child_cost[0] && cost < child_cost[1])
+                    break;
+
+                index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+            }
+
+            s32 sibling = index;
+            s32 old_parent = tree.nodes[sibling].parent;
+            s32 new_parent = alloc_node(tree);
+
+            bvh_node& np = tree.nodes[new_parent];
+            np.parent = old_parent;
+            np.left = sibling;
+            np.right = leaf;
+            merge(tree.nodes[sibling], tree.nodes[leaf], np);
+            np.height = tree.nodes[sibling].height + 1;
+
+            if (old_parent != k_null_node)
+            {
+                if (tree.nodes[old_parent].left == sibling)
+                    tree.nodes[old_parent].left = new_parent;
+                else
+                    tree.nodes[old_parent].right = new_parent;
+            }
+            else
+            {
+                tree.root = new_parent;
+            }
+
+            tree.nodes[sibling].parent = new_parent;
+            tree.nodes[leaf].parent = new_parent;
+
+            refit_to_root(tree, tree.nodes[leaf].parent);
+        }
+
+        static void remove_leaf(bvh& tree, s32 leaf)
+        {
+            if (leaf == tree.root)
+            {
+                tree.root = k_null_node;
+                return;
+            }
+
+            s32 parent = tree.nodes[leaf].parent;
+            s32 grand_parent = tree.nodes[parent].parent;
+            s32 sibling = tree.nodes[parent].left == leaf ? tree.nodes[parent].right : tree.nodes[parent].left;
+
+            free_node(tree, parent);
+
+            if (grand_parent == k_null_node)
+            {
+                tree.root = sibling;
+                tree.nodes[sibling].parent = k_null_node;
+                return;
+            }
+
+            if (tree.nodes[grand_parent].left == parent)
+                tree.nodes[grand_parent].left = sibling;
+            else
+                tree.nodes[grand_parent].right = sibling;
+
+            tree.nodes[sibling].parent = grand_parent;
+
+            refit_to_root(tree, grand_parent);
+        }
+
+        static void remove_entity(bvh& tree, u32 entity)
+        {
+            s32 leaf = tree.entity_leaf[entity];
+            if (leaf == k_null_node)
+                return;
+
+            remove_leaf(tree, leaf);
+            free_node(tree, leaf);
+
+            tree.entity_leaf[entity] = k_null_node;
+            tree.num_leaves--;
+        }
+
+        void bvh_update(ecs_scene* scene)
+        {
+            bvh& tree = scene->entity_bvh;
+
+            if (tree.entity_capacity < scene->soa_size)
+            {
+                tree.entity_leaf = (s32*)pen::memory_realloc(tree.entity_leaf, scene->soa_size * sizeof(s32));
+
+                for (u32 i = tree.entity_capacity; i < scene->soa_size; ++i)
+                    tree.entity_leaf[i] = k_null_node;
+
+                tree.entity_capacity = scene->soa_size;
+            }
+
+            tree.reinserts = 0;
+
+            // only entities whose bounds or components changed since the last update, deletes change components.
+            // every entity is flagged when the scene is resized or the dirty state is reset
+            const dirty_state& ds = scene->dirty;
+            u32                num_dirty = sb_count(ds.bounds_entities);
+            for (u32 i = 0; i < num_dirty; ++i)
+            {
+                u32 n = ds.bounds_entities[i];
+
+                if (!(scene->entities[n] & CMP_ALLOCATED) || !is_cull_candidate(scene, n))
+                {
+                    remove_entity(tree, n);
+                    continue;
+                }
+
+                // leaves bound the box and the cull sphere, so a leaf test is never stricter than the sphere cull
+                const cmp_bounding_volume& bv = scene->bounding_volumes[n];
+
+                vec3f pos = bv.transformed_min_extents + (bv.transformed_max_extents - bv.transformed_min_extents) * 0.5f;
+                vec3f r = vec3f(max(bv.radius, 0.0f));
+                vec3f tmin = vec3f::vmin(bv.transformed_min_extents, pos - r);
+                vec3f tmax = vec3f::vmax(bv.transformed_max_extents, pos + r);
+
+                s32 leaf = tree.entity_leaf[n];
+                if (leaf != k_null_node)
+                {
+                    if (contains(tree.nodes[leaf], tmin, tmax))
+                        continue;
+
+                    remove_leaf(tree, leaf);
+                }
+                else
+                {
+                    leaf = alloc_node(tree);
+                    tree.entity_leaf[n] = leaf;
+                    tree.num_leaves++;
+                }
+
+                vec3f margin = (tmax - tmin) * k_fat_margin + vec3f(k_fat_min_margin);
+
+                bvh_node& node = tree.nodes[leaf];
+                node.min = tmin - margin;
+                node.max = tmax + margin;
+                node.entity = n;
+
+                insert_leaf(tree, leaf);
+                tree.reinserts++;
+            }
+
+            // entities past the end of the scene since the last update
+            for (u32 n = scene->num_entities; n < tree.synced_entities && n < tree.entity_capacity; ++n)
+                remove_entity(tree, n);
+
+            tree.synced_entities = scene->num_entities;
+        }
+
+        void bvh_clear(bvh& tree)
+        {
+            pen::memory_free(tree.nodes);
+            pen::memory_free(tree.entity_leaf);
+
+            tree = bvh();
+        }
+
+        static void append_leaves(const bvh& tree, s32 index, u32*& results)
+        {
+            s32 stack[k_max_stack];
+            u32 sp = 0;
+            stack[sp++] = index;
+
+            while (sp > 0)
+            {
+                const bvh_node& node = tree.nodes[stack[--sp]];
+
+                if (is_leaf(node))
+                {
+                    sb_push(results, node.entity);
+                    continue;
+                }
+
+                PEN_ASSERT(sp + 2 <= k_max_stack);
+                stack[sp++] = node.left;
+                stack[sp++] = node.right;
+            }
+        }
+
+        void bvh_query_frustum(const bvh& tree, const frustum& f, u32*& results)
+        {
+            if (tree.root == k_null_node)
+                return;
+
+            f32 plane_d[6];
+            for (u32 i = 0; i < 6; ++i)
+                plane_d[i] = dot(f.n[i], f.p[i]);
+
+            s32 stack[k_max_stack];
+            u32 sp = 0;
+            stack[sp++] = tree.root;
+
+            while (sp > 0)
+            {
+                s32             index = stack[--sp];
+                const bvh_node& node = tree.nodes[index];
+
+                vec3f centre = (node.min + node.max) * 0.5f;
+                vec3f extent = (node.max - node.min) * 0.5f;
+
+                // planes face outwards, test the nearest and furthest box corners along each normal
+                bool outside = false;
+                bool inside = true;
+                for (u32 i = 0; i < 6; ++i)
+                {
+                    const vec3f& n = f.n[i];
+
+                    f32 d = dot(n, centre) - plane_d[i];
+                    f32 r = fabs(n.x) * extent.x + fabs(n.y) * extent.y + fabs(n.z) * extent.z;
+
+                    if (d - r > 0.0f)
+                    {
+                        outside = true;
+                        break;
+                    }
+
+                    if (d + r > 0.0f)
+                        inside = false;
+                }
+
+                if (outside)
+                    continue;
+
+                if (inside || is_leaf(node))
+                {
+                    append_leaves(tree, index, results);
+                    continue;
+                }
+
+                PEN_ASSERT(sp + 2 <= k_max_stack);
+                stack[sp++] = node.left;
+                stack[sp++] = node.right;
+            }
+        }
+
+        void bvh_query_aabb(const bvh& tree, const vec3f& min, const vec3f& max, u32*& results)
+        {
+            if (tree.root == k_null_node)
+                return;
+
+            s32 stack[k_max_stack];
+            u32 sp = 0;
+            stack[sp++] = tree.root;
+
+            while (sp > 0)
+            {
+                const bvh_node& node = tree.nodes[stack[--sp]];
+
+                if (node.max.x < min.x || node.min.x > max.x || node.max.y < min.y || node.min.y > max.y ||
+                    node.max.z < min.z || node.min.z > max.z)
+                    continue;
+
+                if (is_leaf(node))
+                {
+                    sb_push(results, node.entity);
+                    continue;
+                }
+
+                PEN_ASSERT(sp + 2 <= k_max_stack);
+                stack[sp++] = node.left;
+                stack[sp++] = node.right;
+            }
+        }
+
+        void bvh_query_sphere(const bvh& tree, const vec3f& pos, f32 radius, u32*& results)
+        {
+            if (tree.root == k_null_node)
+                return;
+
+            f32 r2 = radius * radius;
+
+            s32 stack[k_max_stack];
+            u32 sp = 0;
+            stack[sp++] = tree.root;
+
+            while (sp > 0)
+            {
+                const bvh_node& node = tree.nodes[stack[--sp]];
+
+                // squared distance from the sphere centre to the closest point on the box
+                vec3f cp = vec3f::vmin(vec3f::vmax(pos, node.min), node.max);
+                vec3f v = cp - pos;
+                if (dot(v, v) > r2)
+                    continue;
+
+                if (is_leaf(node))
+                {
+                    sb_push(results, node.entity);
+                    continue;
+                }
+
+                PEN_ASSERT(sp + 2 <= k_max_stack);
+                stack[sp++] = node.left;
+                stack[sp++] = node.right;
+            }
+        }
+
+        void bvh_query_ray(const bvh& tree, const vec3f& r0, const vec3f& r1, u32*& results)
+        {
+            if (tree.root == k_null_node)
+                return;
+
+            vec3f rv = r1 - r0;
+            vec3f inv = vec3f(1.0f / rv.x, 1.0f / rv.y, 1.0f / rv.z);
+
+            s32 stack[k_max_stack];
+            u32 sp = 0;
+            stack[sp++] = tree.root;
+
+            while (sp > 0)
+            {
+                const bvh_node& node = tree.nodes[stack[--sp]];
+
+                // slab test clamped to the segment
+                f32 tmin = 0.0f;
+                f32 tmax = 1.0f;
+                for (u32 i = 0; i < 3; ++i)
+                {
+                    // parallel to the slab, 0 * inf would be nan. inside the slab for the whole segment or never
+                    if (rv[i] == 0.0f)
+                    {
+                        if (r0[i] < node.min[i] || r0[i] > node.max[i])
+                            tmax = -1.0f;
+
+                        continue;
+                    }
+
+                    f32 t1 = (node.min[i] - r0[i]) * inv[i];
+                    f32 t2 = (node.max[i] - r0[i]) * inv[i];
+
+                    tmin = max(tmin, min(t1, t2));
+                    tmax = min(tmax, max(t1, t2));
+                }
+
+                if (tmin > tmax)
+                    continue;
+
+                if (is_leaf(node))
+                {
+                    sb_push(results, node.entity);
+                    continue;
+                }
+
+                PEN_ASSERT(sp + 2 <= k_max_stack);
+                stack[sp++] = node.left;
+                stack[sp++] = node.right;
+            }
+        }
+    } // namespace ecs
+} // namespace put
@@ -0,0 +1,54 @@
+// ecs_bvh.h
+// Copyright 2014 - 2019 Alex Dixon.
+// License: https://github.com/polymonster/pmtech/blob/master/license.md
+
+// Dynamic aabb tree over entity bounding volumes. Leaves store fattened bounds and are only re-inserted when an entity
+// moves outside of them, so static entities cost nothing to maintain. Queries test against the fat bounds and append
+// candidate entity indices which callers can refine with exact tests.
+
+#pragma once
+
+#include "camera.h"
+#include "maths/maths.h"
+#include "types.h"
+
+namespace put
+{
+    namespace ecs
+    {
+        struct ecs_scene;
+
+        struct bvh_node
+        {
+            vec3f min;
+            vec3f max;
+            s32   parent; // next in free list when unused
+            s32   left;   // -1 for leaves
+            s32   right;
+            s32   height; // 0 for leaves
+            u32   entity;
+        };
+
+        struct bvh
+        {
+            bvh_node* nodes = nullptr;
+            s32*      entity_leaf = nullptr; // leaf node per entity, -1 when not in the tree
+            s32       root = -1;
+            s32       free_list = -1;
+            u32       capacity = 0;
+            u32       entity_capacity = 0;
+            u32       synced_entities = 0;
+            u32       num_leaves = 0;
+            u32       reinserts = 0; // leaves inserted or moved by the last bvh_update
+        };
+
+        void bvh_update(ecs_scene* scene); // sync leaves of entities with dirty bounds, called from update_scene
+        void bvh_clear(bvh& tree);
+
+        // append entities whose fat bounds pass the query to results (stretchy buffer), call sb_free when done
+        void bvh_query_frustum(const bvh& tree, const frustum& f, u32*& results);
+        void bvh_query_aabb(const bvh& tree, const vec3f& min, const vec3f& max, u32*& results);
+        void bvh_query_sphere(const bvh& tree, const vec3f& pos, f32 radius, u32*& results);
+        void bvh_query_ray(const bvh& tree, const vec3f& r0, const vec3f& r1, u32*& results); // segment r0 -> r1
+    } // namespace ecs
+} // namespace put
@@ -351,6 +351,10 @@ namespace put
 
             scene->master_instances[master].instance_buffer = pen::renderer_create_buffer(bcp);
 
+            // sub instances are drawn through the master
+            for (s32 i = 1; i < selection_size; ++i)
+                scene->entities[scene->selection_list[i]] |= CMP_SUB_INSTANCE;
+
             // todo - must ensure list is contiguous.
             dev_console_log("[instance] master instance: %i with %i sub instances", master, selection_size);
         }
@@ -588,8 +592,28 @@ namespace put
                         pm = SELECT_ADD;
                     }
 
-                    for (s32 node = 0; node < scene->num_entities; ++node)
+                    // candidates from the scene bvh, then the exact aabb test
+                    frustum select_frustum;
+                    for (s32 i = 0; i < 6; ++i)
                     {
+                        select_frustum.n[i] = n[i];
+                        select_frustum.p[i] = p[i];
+                    }
+
+                    static u32* candidates = nullptr;
+                    if (candidates)
+                        stb__sbn(candidates) = 0;
+
+                    bvh_query_frustum(scene->entity_bvh, select_frustum, candidates);
+
+                    u32 num_candidates = sb_count(candidates);
+                    for (u32 ci = 0; ci < num_candidates; ++ci)
+                    {
+                        u32 node = candidates[ci];
+
+                        if (node >= scene->num_entities)
+                            continue;
+
                         if (!(scene->entities[node] & CMP_ALLOCATED))
                             continue;
 
@@ -2324,7 +2348,7 @@ namespace put
                     if (changed)
                     {
                         s32 s = selected_index;
-                        scene->world_matrices[s] = mat4::create_identity();
+                        scene->entities[s] |= CMP_TRANSFORM;
                     }
                 }
                 else
@@ -210,6 +210,12 @@ namespace put
             instance->vertex_size = gr->vertex_size;
             instance->p_skin = gr->p_skin;
 
+            // geometry without lods draws its whole index buffer as lod 0
+            instance->num_lods = max(gr->num_lods, (u32)1);
+            instance->lods[0] = {0, gr->num_indices, 0.0f};
+            for (u32 l = 1; l < instance->num_lods; ++l)
+                instance->lods[l] = gr->lods[l];
+
             cmp_bounding_volume* bv = &scene->bounding_volumes[node_index];
 
             bv->min_extents = gr->min_extents;
@@ -227,6 +233,18 @@ namespace put
 
             if (scene->entities[node_index] & CMP_SKINNED)
                 instance->vertex_shader_class = ID_VERTEX_CLASS_SKINNED;
+
+            // quantized positions are unorm16 within the submesh extents
+            instance->position_offset = vec4f(gr->min_extents, 0.0f);
+            instance->position_scale = vec4f(gr->max_extents - gr->min_extents, 1.0f);
+
+            if (gr->vertex_format == PMM_VERTEX_QUANTIZED)
+            {
+                instance->vertex_shader_class = ID_VERTEX_CLASS_QUANTIZED;
+
+                if (scene->entities[node_index] & CMP_SKINNED)
+                    instance->vertex_shader_class = ID_VERTEX_CLASS_SKINNED_QUANTIZED;
+            }
         }
 
         void destroy_geometry(ecs_scene* scene, u32 node_index)
@@ -295,6 +313,10 @@ namespace put
             cmp_geometry& geom = scene->geometries[node_index];
             cmp_pre_skin& pre_skin = scene->pre_skin[node_index];
 
+            // stream out writes the float vertex_model layout, quantized meshes are skinned in the vertex shader
+            if (geom.vertex_shader_class == ID_VERTEX_CLASS_SKINNED_QUANTIZED)
+                return;
+
             u32 num_verts = geom.num_vertices;
 
             // stream out / transform feedback vertex buffer
@@ -560,13 +582,23 @@ namespace put
                 u32 num_collision_floats = *p_reader++;
                 u32 skinned = *p_reader++;
 
+                u32 vertex_format = PMM_VERTEX_FLOAT;
+                if (version >= 2)
+                    vertex_format = *p_reader++;
+
+                p_geometry->vertex_format = vertex_format;
+
                 u32 index_size = num_indices < 65535 ? 2 : 4;
 
                 u32 vertex_size = sizeof(vertex_model);
+                if (vertex_format == PMM_VERTEX_QUANTIZED)
+                    vertex_size = sizeof(vertex_model_quantized);
 
                 if (skinned)
                 {
                     vertex_size = sizeof(vertex_model_skinned);
+                    if (vertex_format == PMM_VERTEX_QUANTIZED)
+                        vertex_size = sizeof(vertex_model_skinned_quantized);
 
                     p_geometry->p_skin = (cmp_skin*)pen::memory_alloc(sizeof(cmp_skin));
 
@@ -638,24 +670,56 @@ namespace put
 
                 p_reader += bcp.buffer_size / sizeof(u32);
 
+                const c8* p_indices = (const c8*)p_reader;
+                p_reader = (u32*)((c8*)p_reader + index_size * num_indices);
+
+                p_reader += num_collision_floats;
+
+                // lod index ranges follow lod 0 in a single index buffer, they share its vertex buffer and index size
+                const c8* p_lod_indices[k_max_lods] = {p_indices};
+                p_geometry->lods[0] = {0, num_indices, 0.0f};
+                p_geometry->num_lods = 1;
+
+                u32 total_indices = num_indices;
+                if (version >= 3)
+                {
+                    u32 num_lods = *p_reader++;
+                    for (u32 l = 0; l < num_lods; ++l)
+                    {
+                        f32 error;
+                        memcpy(&error, p_reader++, sizeof(f32));
+                        u32 lod_indices = *p_reader++;
+
+                        if (p_geometry->num_lods < k_max_lods)
+                        {
+                            p_lod_indices[p_geometry->num_lods] = (const c8*)p_reader;
+                            p_geometry->lods[p_geometry->num_lods++] = {total_indices, lod_indices, error};
+                            total_indices += lod_indices;
+                        }
+
+                        p_reader = (u32*)((c8*)p_reader + index_size * lod_indices);
+                    }
+                }
+
+                // keep a cpu copy of index data
+                p_geometry->cpu_index_buffer = pen::memory_alloc(index_size * total_indices);
+                for (u32 l = 0; l < p_geometry->num_lods; ++l)
+                {
+                    const geometry_lod& lod = p_geometry->lods[l];
+                    memcpy((c8*)p_geometry->cpu_index_buffer + lod.start_index * index_size, p_lod_indices[l],
+                           lod.num_indices * index_size);
+                }
+
                 bcp.usage_flags = PEN_USAGE_DEFAULT;
                 bcp.bind_flags = PEN_BIND_INDEX_BUFFER;
                 bcp.cpu_access_flags = 0;
-                bcp.buffer_size = index_size * num_indices;
-                bcp.data = (void*)p_reader;
+                bcp.buffer_size = index_size * total_indices;
+                bcp.data = p_geometry->cpu_index_buffer;
 
                 p_geometry->num_indices = num_indices;
                 p_geometry->index_type = index_size == 2 ? PEN_FORMAT_R16_UINT : PEN_FORMAT_R32_UINT;
                 p_geometry->index_buffer = pen::renderer_create_buffer(bcp);
 
-                // keep a cpu copy of index data
-                p_geometry->cpu_index_buffer = pen::memory_alloc(bcp.buffer_size);
-                memcpy(p_geometry->cpu_index_buffer, bcp.data, bcp.buffer_size);
-
-                p_reader = (u32*)((c8*)p_reader + bcp.buffer_size);
-
-                p_reader += num_collision_floats;
-
                 s_geometry_resources.push_back(p_geometry);
             }
         }
@@ -702,12 +766,18 @@ namespace put
 
         void permutation_flags_from_vertex_class(u32& permutation, hash_id vertex_class)
         {
-            u32 clear_vertex = ~(PERMUTATION_SKINNED | PERMUTATION_INSTANCED);
+            u32 clear_vertex = ~(PERMUTATION_SKINNED | PERMUTATION_INSTANCED | PERMUTATION_QUANTIZED);
             permutation &= clear_vertex;
 
             if (vertex_class == ID_VERTEX_CLASS_SKINNED)
                 permutation |= PERMUTATION_SKINNED;
 
+            if (vertex_class == ID_VERTEX_CLASS_QUANTIZED)
+                permutation |= PERMUTATION_QUANTIZED;
+
+            if (vertex_class == ID_VERTEX_CLASS_SKINNED_QUANTIZED)
+                permutation |= PERMUTATION_SKINNED | PERMUTATION_QUANTIZED;
+
             if (vertex_class == ID_VERTEX_CLASS_INSTANCED)
                 permutation |= PERMUTATION_INSTANCED;
         }
@@ -862,6 +932,7 @@ namespace put
         }
 
         static std::vector<animation_resource> k_animations;
+        static const u32                       k_compressed_pma_version = 2;
 
         animation_resource* get_animation_resource(anim_handle h)
         {
@@ -871,6 +942,128 @@ namespace put
             return &k_animations[h];
         }
 
+        // compressed pma from build_scripts/models/compress_animations.py, quantized keys are kept as is and decoded
+        // by the sampler
+        static void load_compressed_pma(animation_resource& anim, const u32* p_u32reader)
+        {
+            enum e_compressed_tracks
+            {
+                TRACK_TRANSLATION = 1 << 0,
+                TRACK_ROTATION = 1 << 1,
+                TRACK_SCALE = 1 << 2
+            };
+
+            u32 num_channels = anim.num_channels;
+
+            soa_anim& soa = anim.soa;
+            soa.channels = new anim_channel[num_channels];
+            soa.num_channels = num_channels;
+
+            // sizes for the contiguous key arrays
+            const u32* p_channels = p_u32reader;
+            u32        num_keys = 0;
+            u32        num_packed = 0;
+            for (u32 c = 0; c < num_channels; ++c)
+            {
+                read_parsable_string(&p_u32reader);
+
+                u32 channel_keys = *p_u32reader++;
+                p_u32reader += 1 + channel_keys + 12;
+
+                u32 num_words = *p_u32reader++;
+                p_u32reader += num_words;
+
+                num_keys += channel_keys;
+                num_packed += num_words * 2;
+            }
+
+            soa.times = new f32[num_keys];
+            soa.qdata = new u16[num_packed];
+
+            num_keys = 0;
+            num_packed = 0;
+            p_u32reader = p_channels;
+            for (u32 c = 0; c < num_channels; ++c)
+            {
+                animation_channel& channel = anim.channels[c];
+                anim_channel&      sampler = soa.channels[c];
+
+                Str bone_name = read_parsable_string(&p_u32reader);
+                channel.target = PEN_HASH(bone_name.c_str());
+                channel.target_name = bone_name;
+
+                // no float data, the baked matrix path skips channels without matrices
+                channel.matrices = nullptr;
+                channel.interpolation = nullptr;
+                for (u32 o = 0; o < 3; ++o)
+                {
+                    channel.offset[o] = nullptr;
+                    channel.scale[o] = nullptr;
+                    channel.rotation[o] = nullptr;
+                }
+
+                u32 channel_keys = *p_u32reader++;
+                u32 tracks = *p_u32reader++;
+
+                channel.num_frames = channel_keys;
+                channel.times = &soa.times[num_keys];
+                memcpy(channel.times, p_u32reader, sizeof(f32) * channel_keys);
+                p_u32reader += channel_keys;
+
+                for (u32 t = 0; t < channel_keys; ++t)
+                    anim.length = fmax(channel.times[t], anim.length);
+
+                // ranges for translate xyz then scale xyz
+                const f32* ranges = (const f32*)p_u32reader;
+                p_u32reader += 12;
+
+                u32 elm = 0;
+                u32 packed = 0;
+
+                if (tracks & TRACK_TRANSLATION)
+                    for (u32 i = 0; i < 3; ++i)
+                    {
+                        sampler.range_min[elm] = ranges[i];
+                        sampler.range_scale[elm] = ranges[3 + i] / 65535.0f;
+                        sampler.element_offset[elm++] = A_OUT_TX + i;
+                        packed++;
+                    }
+
+                if (tracks & TRACK_SCALE)
+                    for (u32 i = 0; i < 3; ++i)
+                    {
+                        sampler.range_min[elm] = ranges[6 + i];
+                        sampler.range_scale[elm] = ranges[9 + i] / 65535.0f;
+                        sampler.element_offset[elm++] = A_OUT_SX + i;
+                        packed++;
+                    }
+
+                if (tracks & TRACK_ROTATION)
+                {
+                    for (u32 q = 0; q < 4; ++q)
+                        sampler.element_offset[elm++] = A_OUT_QUAT;
+
+                    packed += 3;
+                }
+
+                sampler.num_frames = channel_keys;
+                sampler.element_count = elm;
+                sampler.packed_count = packed;
+                sampler.flags = anim_flags::BAKED_QUATERNION | anim_flags::COMPRESSED;
+                sampler.key_offset = num_keys;
+                sampler.data_offset = num_packed;
+
+                u32 num_words = *p_u32reader++;
+                PEN_ASSERT(num_words * 2 >= channel_keys * packed);
+
+                memcpy(&soa.qdata[num_packed], p_u32reader, sizeof(u16) * channel_keys * packed);
+                p_u32reader += num_words;
+
+                num_keys += channel_keys;
+                num_packed += channel_keys * packed;
+            }
+        }
+
         anim_handle load_pma(const c8* filename)
         {
             Str pd = put::dev_ui::get_program_preference_filename("project_dir");
@@ -923,7 +1116,12 @@ namespace put
 
             new_animation.length = 0.0f;
 
-            u32 max_frames = 0;
+            if (version >= k_compressed_pma_version)
+            {
+                load_compressed_pma(new_animation, p_u32reader);
+                pen::memory_free(anim_file);
+                return (anim_handle)k_animations.size() - 1;
+            }
 
             for (s32 i = 0; i < num_channels; ++i)
             {
@@ -1091,27 +1289,19 @@ namespace put
                     f32* times = new_animation.channels[i].times;
                     new_animation.length = fmax(times[t], new_animation.length);
                 }
-
-                max_frames = std::max<u32>(new_animation.channels[i].num_frames, max_frames);
             }
 
             // free file mem
             pen::memory_free(anim_file);
 
             // bake animations into soa.
-
-            // allocate vertical arrays
             soa_anim& soa = new_animation.soa;
-            soa.data = new f32*[max_frames];
             soa.channels = new anim_channel[num_channels];
-            soa.info = new anim_info*[max_frames];
             soa.num_channels = num_channels;
 
-            // null ptrs
-            memset(soa.data, 0x0, max_frames * sizeof(f32*));
-            memset(soa.info, 0x0, max_frames * sizeof(f32*));
-
-            // push channels into horizontal contiguous arrays
+            // channel layouts and offsets into the contiguous key arrays
+            u32 num_keys = 0;
+            u32 num_floats = 0;
             for (s32 c = 0; c < num_channels; ++c)
             {
                 animation_channel& channel = new_animation.channels[c];
@@ -1144,48 +1334,47 @@ namespace put
                 }
 
                 soa.channels[c].element_count = elm;
+                soa.channels[c].key_offset = num_keys;
+                soa.channels[c].data_offset = num_floats;
+
+                num_keys += channel.num_frames;
+                num_floats += channel.num_frames * elm;
+            }
+
+            soa.times = new f32[num_keys];
+            soa.data = new f32[num_floats];
+
+            // push channels into contiguous arrays
+            for (s32 c = 0; c < num_channels; ++c)
+            {
+                animation_channel& channel = new_animation.channels[c];
+
+                f32* times = &soa.times[soa.channels[c].key_offset];
+                f32* data = &soa.data[soa.channels[c].data_offset];
 
                 for (u32 t = 0; t < channel.num_frames; ++t)
                 {
-                    u32 start_offset = sb_count(soa.data[t]);
+                    times[t] = channel.times[t];
 
                     // translate
                     for (u32 i = 0; i < 3; ++i)
                         if (channel.offset[i])
-                            sb_push(soa.data[t], channel.offset[i][t]);
+                            *data++ = channel.offset[i][t];
 
                     // scale
                     for (u32 i = 0; i < 3; ++i)
                         if (channel.scale[i])
-                            sb_push(soa.data[t], channel.scale[i][t]);
+                            *data++ = channel.scale[i][t];
 
                     // quat
                     for (u32 i = 0; i < 3; ++i)
                         if (channel.rotation[i])
                         {
-                            sb_push(soa.data[t], channel.rotation[i][t].x);
-                            sb_push(soa.data[t], channel.rotation[i][t].y);
-                            sb_push(soa.data[t], channel.rotation[i][t].z);
-                            sb_push(soa.data[t], channel.rotation[i][t].w);
+                            *data++ = channel.rotation[i][t].x;
+                            *data++ = channel.rotation[i][t].y;
+                            *data++ = channel.rotation[i][t].z;
+                            *data++ = channel.rotation[i][t].w;
                         }
-
-                    u32 end_offset = sb_count(soa.data[t]);
-
-                    soa.channels[c].element_count = end_offset - start_offset;
-
-                    anim_info ai;
-                    ai.offset = start_offset;
-                    ai.time = channel.times[t];
-                    sb_push(soa.info[t], ai);
-                }
-
-                // pad sparse info array
-                for (u32 t = channel.num_frames; t < max_frames; ++t)
-                {
-                    anim_info ai;
-                    ai.offset = -1;
-                    ai.time = 0.0f;
-                    sb_push(soa.info[t], ai);
                 }
             }
 
@@ -11,27 +11,30 @@ namespace put
     namespace ecs
     {
         // anim v2
-        struct anim_info
-        {
-            f32 time;
-            u32 interpolation;
-            u32 offset;
-        };
-
         struct anim_channel
         {
             u32 num_frames;
             u32 element_count;
             u32 element_offset[21];
             u32 flags = 0;
+            u32 key_offset;  // first key in soa_anim::times
+            u32 data_offset; // first element in soa_anim::data, keys are element_count floats apart
+
+            // COMPRESSED channels keep packed_count u16 per key in soa_anim::qdata and decode to element_count floats.
+            // translate and scale are range_min + q * range_scale, quaternions are 3 smallest components
+            u32 packed_count = 0;
+            f32 range_min[6];
+            f32 range_scale[6];
         };
 
+        // keys are stored channel major so sampling a channel reads contiguous memory
         struct soa_anim
         {
             u32           num_channels = 0;
             anim_channel* channels = nullptr;
-            anim_info**   info = nullptr; // [frame][samplers]
-            f32**         data = nullptr; // [frame][sampler offset]
+            f32*          times = nullptr; // [channel key_offset + frame]
+            f32*          data = nullptr;  // [channel data_offset + frame * element_count + element]
+            u16*          qdata = nullptr; // [channel data_offset + frame * packed_count + element]
         };
 
         namespace anim_flags
@@ -42,7 +45,8 @@ namespace put
                 APPLY_ROOT_MOTION = 1 << 1,
                 BAKED_QUATERNION = 1 << 2,
                 LOOPED = 1 << 3,
-                PAUSED = 1 << 4
+                PAUSED = 1 << 4,
+                COMPRESSED = 1 << 5
             };
         }
 
@@ -142,6 +146,12 @@ namespace put
             PMM_ALL = 7
         };
 
+        enum e_pmm_vertex_format : u32
+        {
+            PMM_VERTEX_FLOAT = 0,
+            PMM_VERTEX_QUANTIZED = 1 // see vertex_model_quantized
+        };
+
         struct animation_channel
         {
             u32     num_frames;
@@ -191,10 +201,14 @@ namespace put
             u32 index_type;
             u32 material_index;
             u32 vertex_size;
+            u32 vertex_format = PMM_VERTEX_FLOAT;
 
             vec3f min_extents;
             vec3f max_extents;
 
+            u32          num_lods = 0; // index ranges are concatenated in index_buffer, 0 when there is only one
+            geometry_lod lods[k_max_lods];
+
             void* cpu_index_buffer;
             void* cpu_position_buffer;
             void* cpu_vertex_buffer;
@@ -232,6 +246,28 @@ namespace put
             vertex_model_skinned(){};
         };
 
+        // 16 bit positions normalised to the submesh extents, split into low and high unorm8 elements, w of position_lo
+        // is the bitangent sign. normal and tangent are 16 bit octahedral, uvs stay f32 as there is no half vertex format
+        struct vertex_model_quantized
+        {
+            u8    position_lo[4];
+            u8    position_hi[4];
+            u8    normal[4];
+            u8    tangent[4];
+            vec4f uv12;
+        };
+
+        struct vertex_model_skinned_quantized
+        {
+            u8    position_lo[4];
+            u8    position_hi[4];
+            u8    normal[4];
+            u8    tangent[4];
+            vec4f uv12;
+            u8    blend_indices[4];
+            u8    blend_weights[4];
+        };
+
         struct vertex_position
         {
             f32 x, y, z, w;
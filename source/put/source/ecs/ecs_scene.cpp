@@ -20,6 +20,13 @@
 #include "ecs/ecs_scene.h"
 #include "ecs/ecs_utilities.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PUT_SIMD_CULL 1
+#else
+#define PUT_SIMD_CULL 0
+#endif
+
 using namespace put;
 
 extern pen::user_info pen_user_info;
@@ -109,6 +116,34 @@ namespace put
             initialise_free_list(scene);
         }
 
+        static void free_cull_volumes(cull_volumes& cv)
+        {
+            pen::memory_free_align(cv.entities);
+            pen::memory_free_align(cv.x);
+            pen::memory_free_align(cv.y);
+            pen::memory_free_align(cv.z);
+            pen::memory_free_align(cv.radius);
+
+            cv = cull_volumes();
+        }
+
+        static void free_dirty_state(dirty_state& ds)
+        {
+            pen::memory_free(ds.local_matrices);
+            pen::memory_free(ds.parents);
+            pen::memory_free(ds.entities);
+            pen::memory_free(ds.extents);
+            pen::memory_free(ds.draw_call_data);
+            pen::memory_free(ds.cbuffers);
+            pen::memory_free(ds.material_data);
+            pen::memory_free(ds.material_cbuffers);
+            pen::memory_free(ds.instance_buffers);
+            pen::memory_free(ds.flags);
+            sb_free(ds.bounds_entities);
+
+            ds = dirty_state();
+        }
+
         void free_scene_buffers(ecs_scene* scene, bool cmp_mem_only = 0)
         {
             // Remove entites for sub systems (physics, rendering, etc)
@@ -129,6 +164,10 @@ namespace put
                 cmp.data = nullptr;
             }
 
+            free_cull_volumes(scene->renderable_volumes);
+            bvh_clear(scene->entity_bvh);
+            free_dirty_state(scene->dirty);
+
             scene->soa_size = 0;
             scene->num_entities = 0;
         }
@@ -456,6 +495,10 @@ namespace put
 
                 vv.cb_view = cb_view;
 
+                // the shadow frustum is fit to the renderable extents so everything is inside, skip culling
+                vv.visible_entities = scene->renderable_volumes.entities;
+                vv.num_visible_entities = scene->renderable_volumes.count;
+
                 render_scene_view(vv);
             }
 
@@ -567,398 +610,1152 @@ namespace put
             }
         }
 
-        void render_scene_view(const scene_view& view)
+        enum e_draw_layer
         {
-            ecs_scene* scene = view.scene;
-
-            if (scene->view_flags & SV_HIDE)
-                return;
+            DRAW_LAYER_SINGLE = 0,
+            DRAW_LAYER_INSTANCED = 1
+        };
 
-            s32 draw_count = 0;
-            s32 cull_count = 0;
+        struct draw_packet
+        {
+            u64 key;
+            u32 entity;
+            u32 technique_index;
+            u32 lod;
+        };
 
-            for (u32 n = 0; n < scene->num_entities; ++n)
-            {
-                if (!(scene->entities[n] & CMP_GEOMETRY && scene->entities[n] & CMP_MATERIAL))
-                    continue;
+        struct draw_batch
+        {
+            u32 packet;          // first packet of the run
+            u32 num_instances;   // 0 for a regular draw
+            u32 technique_index; // instanced permutation when num_instances > 0
+        };
 
-                if (scene->entities[n] & CMP_SUB_INSTANCE)
-                    continue;
+        struct draw_packet_buffer
+        {
+            draw_packet*   packets = nullptr;
+            draw_packet*   scratch = nullptr;
+            draw_batch*    batches = nullptr;
+            cmp_draw_call* instance_data = nullptr;
+            u32*           visible = nullptr;
+            u32            capacity = 0;
+            u32            instance_buffer = PEN_INVALID_HANDLE;
+            u32            instance_buffer_capacity = 0;
+        };
 
-                if (scene->state_flags[n] & SF_HIDDEN)
-                    continue;
+        static const u32 k_min_dynamic_instances = 2;
+        static const u32 k_bvh_cull_threshold = 1024; // below this many renderables use the flat simd cull
 
-                // frustum cull
-                bool inside = true;
-                for (s32 i = 0; i < 6; ++i)
-                {
-                    frustum& camera_frustum = view.camera->camera_frustum;
+        // lod last selected for each entity by a view, hysteresis compares against the view's own previous choice
+        struct view_lods
+        {
+            const ecs_scene* scene = nullptr;
+            hash_id          id_view = 0;
+            u32              array_index = 0;
+            u8*              lods = nullptr;
+            u32              capacity = 0;
+        };
 
-                    vec3f& min = scene->bounding_volumes[n].transformed_min_extents;
-                    vec3f& max = scene->bounding_volumes[n].transformed_max_extents;
+        static draw_packet_buffer s_draw_packets;
+        static draw_sort_stats*   s_draw_sort_stats = nullptr;
+        static view_lods*         s_view_lods = nullptr;
 
-                    vec3f pos = min + (max - min) * 0.5f;
-                    f32   radius = scene->bounding_volumes[n].radius;
+        const dirty_stats& get_dirty_stats(const ecs_scene* scene)
+        {
+            return scene->dirty.stats;
+        }
 
-                    f32 d = maths::point_plane_distance(pos, camera_frustum.p[i], camera_frustum.n[i]);
+        const draw_sort_stats* get_draw_sort_stats(u32& count)
+        {
+            count = sb_count(s_draw_sort_stats);
+            return s_draw_sort_stats;
+        }
 
-                    if (d > radius)
-                    {
-                        inside = false;
-                        break;
-                    }
-                }
+        static draw_sort_stats& get_view_sort_stats(const scene_view& view)
+        {
+            u32 num_stats = sb_count(s_draw_sort_stats);
+            for (u32 i = 0; i < num_stats; ++i)
+            {
+                if (s_draw_sort_stats[i].id_view != view.id_name)
+                    continue;
 
-                if (!inside)
+                // cubemap and array views accumulate over all slices
+                if (view.array_index == 0)
                 {
-                    cull_count++;
-                    continue;
+                    s_draw_sort_stats[i] = draw_sort_stats();
+                    s_draw_sort_stats[i].id_view = view.id_name;
                 }
 
-                draw_count++;
+                return s_draw_sort_stats[i];
+            }
+
+            draw_sort_stats ds;
+            ds.id_view = view.id_name;
+            sb_push(s_draw_sort_stats, ds);
+            return sb_last(s_draw_sort_stats);
+        }
 
-                cmp_geometry* p_geom = &scene->geometries[n];
-                cmp_material* p_mat = &scene->materials[n];
-                u32           permutation = scene->material_permutation[n];
+        static u8* get_view_lods(const scene_view& view)
+        {
+            const ecs_scene* scene = view.scene;
 
-                // set shader / technique
-                if (!is_valid(view.pmfx_shader))
-                {
-                    // material shader / technique
-                    pmfx::set_technique(p_mat->shader, p_mat->technique_index);
-                }
-                else
+            view_lods* vl = nullptr;
+            u32        num_views = sb_count(s_view_lods);
+            for (u32 i = 0; i < num_views; ++i)
+            {
+                if (s_view_lods[i].scene == scene && s_view_lods[i].id_view == view.id_name &&
+                    s_view_lods[i].array_index == view.array_index)
                 {
-                    bool set = pmfx::set_technique_perm(view.pmfx_shader, view.technique, permutation);
-                    if (!set)
-                    {
-                        if (scene->entities[n] & CMP_MASTER_INSTANCE)
-                        {
-                            u32 num_instances = scene->master_instances[n].num_instances;
-                            n += num_instances;
-                        }
-                        PEN_ASSERT(0);
-                        continue;
-                    }
+                    vl = &s_view_lods[i];
+                    break;
                 }
+            }
 
-                // update skin
-                if (scene->entities[n] & CMP_SKINNED && !(scene->entities[n] & CMP_SUB_GEOMETRY))
-                {
-                    if (p_geom->p_skin->bone_cbuffer == PEN_INVALID_HANDLE)
-                    {
-                        pen::buffer_creation_params bcp;
-                        bcp.usage_flags = PEN_USAGE_DYNAMIC;
-                        bcp.bind_flags = PEN_BIND_CONSTANT_BUFFER;
-                        bcp.cpu_access_flags = PEN_CPU_ACCESS_WRITE;
-                        bcp.buffer_size = sizeof(mat4) * 85;
-                        bcp.data = nullptr;
+            if (!vl)
+            {
+                view_lods nvl;
+                nvl.scene = scene;
+                nvl.id_view = view.id_name;
+                nvl.array_index = view.array_index;
+                sb_push(s_view_lods, nvl);
+                vl = &sb_last(s_view_lods);
+            }
 
-                        p_geom->p_skin->bone_cbuffer = pen::renderer_create_buffer(bcp);
-                    }
+            if (vl->capacity < scene->soa_size)
+            {
+                vl->lods = (u8*)pen::memory_realloc(vl->lods, scene->soa_size);
+                memset(vl->lods + vl->capacity, 0x0, scene->soa_size - vl->capacity);
+                vl->capacity = scene->soa_size;
+            }
 
-                    static mat4 bb[85];
-                    s32         joints_offset = scene->anim_controller[n].joints_offset;
-                    for (s32 i = 0; i < p_geom->p_skin->num_joints; ++i)
-                        bb[i] = scene->world_matrices[joints_offset + i] * p_geom->p_skin->joint_bind_matrices[i];
+            return vl->lods;
+        }
 
-                    pen::renderer_update_buffer(p_geom->p_skin->bone_cbuffer, bb, sizeof(bb));
-                    pen::renderer_set_constant_buffer(p_geom->p_skin->bone_cbuffer, 2, pen::CBUFFER_BIND_VS);
-                }
+        // 64 bit key, msb first: | layer 4 | technique 16 | material 12 | geometry 16 | depth 16 |
+        // handles are truncated, a collision only costs a redundant bind because submit compares the real handles.
+        inline u64 draw_key(u32 layer, u32 technique, u32 material, u32 geometry, f32 depth_sq)
+        {
+            // positive floats order the same as their bit patterns, the top 16 bits are plenty for front to back
+            u32 depth_bits;
+            memcpy(&depth_bits, &depth_sq, sizeof(u32));
 
-                // set material cbs
-                u32 mcb = scene->materials[n].material_cbuffer;
-                if (is_valid(mcb))
-                {
-                    pen::renderer_set_constant_buffer(mcb, 7, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
-                }
+            return ((u64)(layer & 0xf) << 60) | ((u64)(technique & 0xffff) << 44) | ((u64)(material & 0xfff) << 32) |
+                   ((u64)(geometry & 0xffff) << 16) | (u64)(depth_bits >> 16);
+        }
 
-                pen::renderer_set_constant_buffer(scene->cbuffer[n], 1, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
+        // lsd radix sort 8 bits per pass, passes where every key shares the same byte are skipped.
+        // returns whichever of src or dst holds the sorted result.
+        static draw_packet* radix_sort_draw_packets(draw_packet* src, draw_packet* dst, u32 count)
+        {
+            if (count < 2)
+                return src;
 
-                // set ib / vb
-                if (scene->entities[n] & CMP_MASTER_INSTANCE)
-                {
-                    u32 vbs[2] = {p_geom->vertex_buffer, scene->master_instances[n].instance_buffer};
-                    u32 strides[2] = {p_geom->vertex_size, scene->master_instances[n].instance_stride};
-                    u32 offsets[2] = {0};
+            for (u32 shift = 0; shift < 64; shift += 8)
+            {
+                u32 histogram[256] = {0};
+                for (u32 i = 0; i < count; ++i)
+                    histogram[(src[i].key >> shift) & 0xff]++;
 
-                    pen::renderer_set_vertex_buffers(vbs, 2, 0, strides, offsets);
-                }
-                else
+                if (histogram[(src[0].key >> shift) & 0xff] == count)
+                    continue;
+
+                u32 offset = 0;
+                for (u32 b = 0; b < 256; ++b)
                 {
-                    pen::renderer_set_vertex_buffer(p_geom->vertex_buffer, 0, p_geom->vertex_size, 0);
+                    u32 c = histogram[b];
+                    histogram[b] = offset;
+                    offset += c;
                 }
 
-                pen::renderer_set_index_buffer(p_geom->index_buffer, p_geom->index_type, 0);
+                for (u32 i = 0; i < count; ++i)
+                    dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
 
-                // set textures
-                if (p_mat)
-                {
-                    cmp_samplers& samplers = scene->samplers[n];
-                    for (u32 s = 0; s < MAX_TECHNIQUE_SAMPLER_BINDINGS; ++s)
-                    {
-                        if (!samplers.sb[s].handle)
-                            continue;
-                        
-                        pen::renderer_set_texture(samplers.sb[s].handle, samplers.sb[s].sampler_state,
-                                                  samplers.sb[s].sampler_unit, pen::TEXTURE_BIND_PS);
-                    }
-                }
+                std::swap(src, dst);
+            }
 
-                // view
-                pen::renderer_set_constant_buffer(view.cb_view, 0, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
+            return src;
+        }
 
-                // fwd lights
-                if (view.render_flags & RENDER_FORWARD_LIT)
-                {
-                    pen::renderer_set_constant_buffer(scene->forward_light_buffer, 3, pen::CBUFFER_BIND_PS);
-                    pen::renderer_set_constant_buffer(scene->shadow_map_buffer, 4, pen::CBUFFER_BIND_PS);
-                    pen::renderer_set_constant_buffer(scene->area_light_buffer, 6, pen::CBUFFER_BIND_PS);
+        static void reserve_instance_buffer(u32 size_bytes)
+        {
+            if (size_bytes <= s_draw_packets.instance_buffer_capacity)
+                return;
+
+            if (is_valid(s_draw_packets.instance_buffer))
+                pen::renderer_release_buffer(s_draw_packets.instance_buffer);
+
+            u32 capacity = max(size_bytes, s_draw_packets.instance_buffer_capacity * 2);
+
+            pen::buffer_creation_params bcp;
+            bcp.usage_flags = PEN_USAGE_DYNAMIC;
+            bcp.bind_flags = PEN_BIND_VERTEX_BUFFER;
+            bcp.cpu_access_flags = PEN_CPU_ACCESS_WRITE;
+            bcp.buffer_size = capacity;
+            bcp.data = nullptr;
 
-                    // ltc lookups
-                    static u32 ltc_mat = put::load_texture("data/textures/ltc/ltc_mat.dds");
-                    static u32 ltc_mag = put::load_texture("data/textures/ltc/ltc_amp.dds");
+            s_draw_packets.instance_buffer = pen::renderer_create_buffer(bcp);
+            s_draw_packets.instance_buffer_capacity = capacity;
+        }
+
+        static bool can_dynamic_instance(ecs_scene* scene, u32 n)
+        {
+            if (scene->entities[n] & (CMP_SKINNED | CMP_MASTER_INSTANCE))
+                return false;
+
+            return scene->geometries[n].vertex_shader_class == ID_VERTEX_CLASS_BASIC;
+        }
+
+        static bool same_instance_batch(ecs_scene* scene, u32 a, u32 b)
+        {
+            if (scene->id_material[a] != scene->id_material[b])
+                return false;
+
+            if (scene->material_permutation[a] != scene->material_permutation[b])
+                return false;
 
-					static hash_id id_clamp_linear = PEN_HASH("clamp_linear");
-                    u32 clamp_linear = pmfx::get_render_state(id_clamp_linear, pmfx::RS_SAMPLER);
+            const cmp_geometry& ga = scene->geometries[a];
+            const cmp_geometry& gb = scene->geometries[b];
+            if (ga.vertex_buffer != gb.vertex_buffer || ga.index_buffer != gb.index_buffer || ga.num_indices != gb.num_indices)
+                return false;
+
+            const cmp_material& ma = scene->materials[a];
+            const cmp_material& mb = scene->materials[b];
+            if (ma.shader != mb.shader || ma.material_cbuffer_size != mb.material_cbuffer_size)
+                return false;
+
+            // material cbuffers are per entity, only the first of a batch is bound so the constants must match
+            u32 cbuffer_size = min(ma.material_cbuffer_size, (u32)sizeof(cmp_material_data));
+            if (memcmp(&scene->material_data[a], &scene->material_data[b], cbuffer_size) != 0)
+                return false;
+
+            return memcmp(&scene->samplers[a], &scene->samplers[b], sizeof(cmp_samplers)) == 0;
+        }
+
+        // sorted packets with identical geometry, material and permutation are adjacent, runs of them become a
+        // single instanced draw using the instanced permutation of the same technique.
+        static u32 build_draw_batches(ecs_scene* scene, const scene_view& view, const draw_packet* packets, u32 num_packets)
+        {
+            draw_batch* batches = s_draw_packets.batches;
+            u32         num_batches = 0;
+
+            for (u32 p = 0; p < num_packets;)
+            {
+                u32 n = packets[p].entity;
+                u32 end = p + 1;
 
-                    pen::renderer_set_texture(ltc_mat, clamp_linear, 13, pen::TEXTURE_BIND_PS);
-                    pen::renderer_set_texture(ltc_mag, clamp_linear, 12, pen::TEXTURE_BIND_PS);
+                if (can_dynamic_instance(scene, n))
+                {
+                    while (end < num_packets && packets[end].technique_index == packets[p].technique_index &&
+                           packets[end].lod == packets[p].lod && can_dynamic_instance(scene, packets[end].entity) &&
+                           same_instance_batch(scene, n, packets[end].entity))
+                        ++end;
                 }
 
-                // sdf shadows
-                pen::renderer_set_constant_buffer(scene->sdf_shadow_buffer, 5, pen::CBUFFER_BIND_PS);
-                for (u32 n = 0; n < scene->num_entities; ++n)
+                u32 instanced_technique = PEN_INVALID_HANDLE;
+                if (end - p >= k_min_dynamic_instances)
                 {
-                    if (scene->entities[n] & CMP_SDF_SHADOW)
+                    u32     shader = scene->materials[n].shader;
+                    hash_id id_technique = scene->material_resources[n].id_technique;
+                    if (is_valid(view.pmfx_shader))
                     {
-                        cmp_shadow& shadow = scene->shadows[n];
-
-                        if (is_valid(shadow.texture_handle))
-                            pen::renderer_set_texture(shadow.texture_handle, shadow.sampler_state, SDF_SHADOW_UNIT,
-                                                      pen::TEXTURE_BIND_PS);
+                        shader = view.pmfx_shader;
+                        id_technique = view.technique;
                     }
-                }
 
-                // draw
+                    u32 permutation = scene->material_permutation[n] | PERMUTATION_INSTANCED;
+                    instanced_technique = pmfx::get_technique_index_perm(shader, id_technique, permutation);
+                }
 
-                // instances
-                if (scene->entities[n] & CMP_MASTER_INSTANCE)
+                if (is_valid(instanced_technique))
                 {
-                    u32 num_instances = scene->master_instances[n].num_instances;
-                    pen::renderer_draw_indexed_instanced(num_instances, 0, scene->geometries[n].num_indices, 0, 0,
-                                                         PEN_PT_TRIANGLELIST);
-                    n += num_instances;
+                    draw_batch& b = batches[num_batches++];
+                    b.packet = p;
+                    b.num_instances = end - p;
+                    b.technique_index = instanced_technique;
+                    p = end;
                     continue;
                 }
 
-                // single
-                pen::renderer_draw_indexed(scene->geometries[n].num_indices, 0, 0, PEN_PT_TRIANGLELIST);
+                // no instanced permutation available, draw each packet of the run individually
+                for (; p < end; ++p)
+                {
+                    draw_batch& b = batches[num_batches++];
+                    b.packet = p;
+                    b.num_instances = 0;
+                    b.technique_index = packets[p].technique_index;
+                }
             }
+
+            return num_batches;
         }
 
-        void update_animations(ecs_scene* scene, f32 dt)
+        static void update_cull_volumes(ecs_scene* scene)
         {
-            //dt = 16.66;
-            //pen::timer* timer = pen::timer_create("anim_v2");
-            //pen::timer_start(timer);
+            cull_volumes& cv = scene->renderable_volumes;
+
+            // capacity is kept a multiple of the simd width so the cull loop never needs a remainder
+            u32 required = (scene->num_entities + 3) & ~3;
+            if (cv.capacity < required)
+            {
+                free_cull_volumes(cv);
+
+                u32 size_bytes = required * sizeof(f32);
+                cv.entities = (u32*)pen::memory_alloc_align(size_bytes, 16);
+                cv.x = (f32*)pen::memory_alloc_align(size_bytes, 16);
+                cv.y = (f32*)pen::memory_alloc_align(size_bytes, 16);
+                cv.z = (f32*)pen::memory_alloc_align(size_bytes, 16);
+                cv.radius = (f32*)pen::memory_alloc_align(size_bytes, 16);
+                cv.capacity = required;
+            }
 
+            u32 count = 0;
             for (u32 n = 0; n < scene->num_entities; ++n)
             {
-                if (!(scene->entities[n] & CMP_ANIM_CONTROLLER))
+                if (!is_cull_candidate(scene, n))
+                    continue;
+
+                if (scene->state_flags[n] & SF_HIDDEN)
                     continue;
 
-                cmp_anim_controller_v2 controller = scene->anim_controller_v2[n];
+                const cmp_bounding_volume& bv = scene->bounding_volumes[n];
+                vec3f pos = bv.transformed_min_extents + (bv.transformed_max_extents - bv.transformed_min_extents) * 0.5f;
 
-                u32 num_anims = sb_count(controller.anim_instances);
-                for (u32 ai = 0; ai < num_anims; ++ai)
-                {
-                    anim_instance& instance = controller.anim_instances[ai];
+                cv.entities[count] = n;
+                cv.x[count] = pos.x;
+                cv.y[count] = pos.y;
+                cv.z[count] = pos.z;
+                cv.radius[count] = bv.radius;
+                ++count;
+            }
 
-                    if (instance.flags & anim_flags::PAUSED)
-                        continue;
+            // pad to a full simd lane with volumes which are always outside
+            for (u32 i = count; i < ((count + 3) & ~3); ++i)
+            {
+                cv.entities[i] = PEN_INVALID_HANDLE;
+                cv.x[i] = cv.y[i] = cv.z[i] = 0.0f;
+                cv.radius[i] = -FLT_MAX;
+            }
 
-                    soa_anim& soa = instance.soa;
-                    u32       num_channels = soa.num_channels;
-                    f32       anim_t = instance.time;
+            cv.count = count;
+        }
 
-                    bool looped = false;
+        static u32 frustum_cull_bvh(const ecs_scene* scene, const frustum& f, const f32* plane_d, u32* visible)
+        {
+            static u32* candidates = nullptr;
+            if (candidates)
+                stb__sbn(candidates) = 0;
 
-                    // roll on time
-                    instance.time += dt;
-                    if (instance.time >= instance.length)
-                    {
-                        instance.time = 0.0f;
-                        looped = true;
-                    }
+            bvh_query_frustum(scene->entity_bvh, f, candidates);
 
-                    if (instance.flags & anim_flags::LOOPED)
-                    {
-                        instance.flags &= ~anim_flags::LOOPED;
-                        looped = true;
-                    }
+            // leaves are fat bounds, refine with the same sphere test as the flat cull
+            u32 num_visible = 0;
+            u32 num_candidates = sb_count(candidates);
+            for (u32 c = 0; c < num_candidates; ++c)
+            {
+                u32 n = candidates[c];
 
-                    u32 num_joints = sb_count(instance.joints);
+                // the tree only holds cull candidates, hidden is state which does not dirty the bounds
+                if (scene->state_flags[n] & SF_HIDDEN)
+                    continue;
 
-                    // reset rotations
-                    for (u32 j = 0; j < num_joints; ++j)
-                        instance.targets[j].q = quat(0.0f, 0.0f, 0.0f);
+                const cmp_bounding_volume& bv = scene->bounding_volumes[n];
+                vec3f pos = bv.transformed_min_extents + (bv.transformed_max_extents - bv.transformed_min_extents) * 0.5f;
 
-                    for (s32 c = 0; c < num_channels; ++c)
+                bool inside = true;
+                for (u32 i = 0; i < 6; ++i)
+                {
+                    if (dot(f.n[i], pos) - plane_d[i] > bv.radius)
                     {
-                        anim_sampler& sampler = instance.samplers[c];
-                        anim_channel& channel = soa.channels[c];
+                        inside = false;
+                        break;
+                    }
+                }
 
-                        if (sampler.joint == PEN_INVALID_HANDLE)
-                            continue;
+                if (inside)
+                    visible[num_visible++] = n;
+            }
 
-                        // find the frame we are on..
-                        for (; sampler.pos < channel.num_frames; sampler.pos++)
-                            if (anim_t <= soa.info[sampler.pos][c].time)
-                            {
-                                sampler.pos -= 1;
-                                break;
-                            }
+            return num_visible;
+        }
 
-                        //reset flag
-                        sampler.flags &= ~anim_flags::LOOPED;
+        u32 frustum_cull(const ecs_scene* scene, const frustum& f, u32* visible)
+        {
+            // large worlds only visit the parts of the tree near the frustum
+            if (scene->renderable_volumes.count >= k_bvh_cull_threshold)
+            {
+                f32 plane_d[6];
+                for (u32 i = 0; i < 6; ++i)
+                    plane_d[i] = dot(f.n[i], f.p[i]);
 
-                        if (sampler.pos >= channel.num_frames || looped)
-                        {
-                            sampler.pos = 0;
-                            sampler.flags = anim_flags::LOOPED;
-                        }
+                return frustum_cull_bvh(scene, f, plane_d, visible);
+            }
 
-                        u32 next = (sampler.pos + 1) % channel.num_frames;
+            return frustum_cull_volumes(scene->renderable_volumes, f, visible);
+        }
 
-                        // get anim data
-                        anim_info& info1 = soa.info[sampler.pos][c];
-                        anim_info& info2 = soa.info[next][c];
+        u32 frustum_cull_volumes(const cull_volumes& cv, const frustum& f, u32* visible)
+        {
+            // planes as n.xyz, d so the distance is a single dot - d
+            f32 plane_d[6];
+            for (u32 i = 0; i < 6; ++i)
+                plane_d[i] = dot(f.n[i], f.p[i]);
 
-                        f32* d1 = &soa.data[sampler.pos][info1.offset];
-                        f32* d2 = &soa.data[next][info2.offset];
+            u32 num_visible = 0;
 
-                        f32 a = (anim_t - info1.time);
-                        f32 b = (info2.time - info1.time);
+#if PUT_SIMD_CULL
+            __m128 nx[6], ny[6], nz[6], nd[6];
+            for (u32 i = 0; i < 6; ++i)
+            {
+                nx[i] = _mm_set1_ps(f.n[i].x);
+                ny[i] = _mm_set1_ps(f.n[i].y);
+                nz[i] = _mm_set1_ps(f.n[i].z);
+                nd[i] = _mm_set1_ps(plane_d[i]);
+            }
 
-                        f32 it = min(max(a / b, 0.0f), 1.0f);
+            for (u32 e = 0; e < cv.count; e += 4)
+            {
+                __m128 x = _mm_load_ps(cv.x + e);
+                __m128 y = _mm_load_ps(cv.y + e);
+                __m128 z = _mm_load_ps(cv.z + e);
+                __m128 r = _mm_load_ps(cv.radius + e);
 
-                        sampler.prev_t = sampler.cur_t;
-                        sampler.cur_t = it;
+                __m128 outside = _mm_setzero_ps();
+                for (u32 i = 0; i < 6; ++i)
+                {
+                    __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx[i]), _mm_mul_ps(y, ny[i])), _mm_mul_ps(z, nz[i]));
+                    d = _mm_sub_ps(d, nd[i]);
+                    outside = _mm_or_ps(outside, _mm_cmpgt_ps(d, r));
+                }
 
-                        for (u32 e = 0; e < channel.element_count; ++e)
-                        {
-                            u32 eo = channel.element_offset[e];
-
-                            // slerp quats
-                            if (eo == A_OUT_QUAT)
-                            {
-                                quat q1;
-                                quat q2;
-
-                                memcpy(&q1.v[0], &d1[e], 16);
-                                memcpy(&q2.v[0], &d2[e], 16);
-
-                                quat ql = slerp(q1, q2, it);
-
-                                instance.targets[sampler.joint].q = ql * instance.targets[sampler.joint].q;
-                                instance.targets[sampler.joint].flags |= channel.flags;
-                                e += 3;
-                            }
-                            else
-                            {
-                                // lerp translation / scale
-                                f32 lf = (1 - it) * d1[e] + it * d2[e];
-                                instance.targets[sampler.joint].t[eo] = lf;
-                            }
-                        }
+                u32 inside_mask = ~_mm_movemask_ps(outside) & 0xf;
+                for (u32 l = 0; l < 4; ++l)
+                    if (inside_mask & (1 << l))
+                        visible[num_visible++] = cv.entities[e + l];
+            }
+#else
+            for (u32 e = 0; e < cv.count; ++e)
+            {
+                bool inside = true;
+                for (u32 i = 0; i < 6; ++i)
+                {
+                    f32 d = f.n[i].x * cv.x[e] + f.n[i].y * cv.y[e] + f.n[i].z * cv.z[e] - plane_d[i];
+                    if (d > cv.radius[e])
+                    {
+                        inside = false;
+                        break;
                     }
+                }
 
-                    // bake anim target into a cmp transform for joint
-                    u32 tj = PEN_INVALID_HANDLE;
-                    for (u32 j = 0; j < num_joints; ++j)
-                    {
-                        u32 jnode = controller.joint_indices[j];
+                if (inside)
+                    visible[num_visible++] = cv.entities[e];
+            }
+#endif
 
-                        if (scene->entities[jnode] & CMP_ANIM_TRAJECTORY)
-                        {
-                            tj = j;
-                            continue;
-                        }
+            return num_visible;
+        }
 
-                        f32* f = &instance.targets[j].t[0];
+        // coarsest lod whose error projects to no more than lod_pixel_error pixels. switching to a coarser lod than the
+        // one this view picked last frame must clear the threshold by lod_hysteresis so entities near a boundary don't
+        // flicker between lods. each view keeps its own history so shadow and probe views don't reset the main view.
+        static u32 select_lod(ecs_scene* scene, u32 n, const scene_view& view, const vec3f& pos, u8* prev_lods)
+        {
+            cmp_geometry& geom = scene->geometries[n];
+            if (geom.num_lods <= 1 || scene->entities[n] & CMP_MASTER_INSTANCE || !view.viewport)
+                return 0;
+
+            // lod errors are in object space, scale them by the ratio of world to object bounds.
+            // bv.radius is already transformed, the object radius comes from the untransformed extents
+            const cmp_bounding_volume& bv = scene->bounding_volumes[n];
+            f32 world_radius = bv.radius;
+            f32 object_radius = mag(bv.max_extents - bv.min_extents) * 0.5f;
+            f32 scale = object_radius > 0.0f ? world_radius / object_radius : 1.0f;
+
+            // proj[1][1] is 1 / tan(fov / 2) for perspective and 2 / height for ortho (shadow maps)
+            const camera* cam = view.camera;
+            f32 pixels_per_unit = view.viewport->height * 0.5f * cam->proj.get_row(1).y;
+            if (!(cam->flags & CF_ORTHO))
+                pixels_per_unit /= max(mag(pos - cam->pos) - world_radius, cam->near_plane);
+
+            pixels_per_unit *= scale;
+
+            u32 prev = min((u32)prev_lods[n], geom.num_lods - 1);
+            u32 lod = 0;
+            for (u32 l = geom.num_lods - 1; l > 0; --l)
+            {
+                f32 threshold = scene->lod_pixel_error;
+                if (l > prev)
+                    threshold *= 1.0f - scene->lod_hysteresis;
+
+                if (geom.lods[l].error * pixels_per_unit <= threshold)
+                {
+                    lod = l;
+                    break;
+                }
+            }
 
-                        instance.joints[j].translation = vec3f(f[A_OUT_TX], f[A_OUT_TY], f[A_OUT_TZ]);
-                        instance.joints[j].scale = vec3f(f[A_OUT_SX], f[A_OUT_SY], f[A_OUT_SZ]);
+            prev_lods[n] = (u8)lod;
+            return lod;
+        }
 
-                        if (instance.targets[j].flags & anim_flags::BAKED_QUATERNION)
-                            instance.joints[j].rotation = instance.targets[j].q;
-                        else
-                            instance.joints[j].rotation = scene->initial_transform[jnode].rotation * instance.targets[j].q;
-                    }
+        void render_scene_view(const scene_view& view)
+        {
+            ecs_scene* scene = view.scene;
 
-                    // root motion.. todo rotation
-                    if (tj != PEN_INVALID_HANDLE)
-                    {
-                        f32*  f = &instance.targets[tj].t[0];
-                        vec3f tt = vec3f(f[0], f[1], f[2]);
+            if (scene->view_flags & SV_HIDE)
+                return;
 
-                        if (instance.samplers[0].flags & anim_flags::LOOPED)
-                        {
-                            // inherit prev root motion
-                            instance.root_translation = tt;
-                        }
-                        else
-                        {
-                            instance.root_delta = tt - instance.root_translation;
-                            instance.root_translation = tt;
-                        }
-                    }
-                }
+            draw_sort_stats& stats = get_view_sort_stats(view);
 
-                // for active controller.anim_instances, make trans, quat, scale
-                //      blend tree
-                if (num_anims > 0)
-                {
-                    anim_instance& a = controller.anim_instances[controller.blend.anim_a];
-                    anim_instance& b = controller.anim_instances[controller.blend.anim_b];
-                    f32            t = controller.blend.ratio;
+            f32 sort_start = pen::get_time_us();
 
-                    u32 num_joints = sb_count(a.joints);
-                    for (u32 j = 0; j < num_joints; ++j)
-                    {
-                        u32 jnode = controller.joint_indices[j];
+            if (s_draw_packets.capacity < scene->soa_size)
+            {
+                u32 size_bytes = sizeof(draw_packet) * scene->soa_size;
+                s_draw_packets.packets = (draw_packet*)pen::memory_realloc(s_draw_packets.packets, size_bytes);
+                s_draw_packets.scratch = (draw_packet*)pen::memory_realloc(s_draw_packets.scratch, size_bytes);
 
-                        cmp_transform& tc = scene->transforms[jnode];
-                        cmp_transform& ta = a.joints[j];
-                        cmp_transform& tb = b.joints[j];
+                size_bytes = sizeof(draw_batch) * scene->soa_size;
+                s_draw_packets.batches = (draw_batch*)pen::memory_realloc(s_draw_packets.batches, size_bytes);
 
-                        if (scene->entities[jnode] & CMP_ANIM_TRAJECTORY)
-                        {
-                            vec3f lerp_delta = lerp(a.root_delta, b.root_delta, t);
+                size_bytes = sizeof(cmp_draw_call) * scene->soa_size;
+                s_draw_packets.instance_data = (cmp_draw_call*)pen::memory_realloc(s_draw_packets.instance_data, size_bytes);
 
-                            mat4 rot_mat;
-                            quat q = scene->initial_transform[jnode].rotation;
-                            q.get_matrix(rot_mat);
+                size_bytes = sizeof(u32) * scene->soa_size;
+                s_draw_packets.visible = (u32*)pen::memory_realloc(s_draw_packets.visible, size_bytes);
 
-                            vec3f transform_translation = rot_mat.transform_vector(lerp_delta);
+                s_draw_packets.capacity = scene->soa_size;
+            }
 
-                            // apply root motion to the root controller, so we bring along the meshes
-                            scene->transforms[n].rotation = q;
-                            scene->transforms[n].translation += transform_translation;
-                            scene->entities[n] |= CMP_TRANSFORM;
+            // visible entities, either pre culled by the caller or culled here against the view camera
+            const u32* visible = view.visible_entities;
+            u32        num_visible = view.num_visible_entities;
+            if (!visible)
+            {
+                num_visible = frustum_cull(scene, view.camera->camera_frustum, s_draw_packets.visible);
+                visible = s_draw_packets.visible;
+            }
 
-                            continue;
-                        }
+            stats.culled += scene->renderable_volumes.count - min(num_visible, scene->renderable_volumes.count);
 
-                        tc.translation = lerp(ta.translation, tb.translation, t);
-                        tc.rotation = slerp2(ta.rotation, tb.rotation, t);
-                        tc.scale = lerp(ta.scale, tb.scale, t);
+            // build packets
+            u32         num_packets = 0;
+            const vec3f camera_pos = view.camera->pos;
+            u8*         lods = get_view_lods(view);
 
-                        scene->entities[jnode] |= CMP_TRANSFORM;
-                    }
-                }
-            }
+            for (u32 v = 0; v < num_visible; ++v)
+            {
+                u32 n = visible[v];
+
+                // cull volumes are built in update_scene, entities may have changed since
+                if (n >= scene->num_entities)
+                    continue;
+
+                if (!(scene->entities[n] & CMP_GEOMETRY && scene->entities[n] & CMP_MATERIAL))
+                    continue;
+
+                // caller supplied visibility lists may contain sub instances, they are drawn by the master
+                if (scene->entities[n] & CMP_SUB_INSTANCE)
+                    continue;
+
+                if (scene->state_flags[n] & SF_HIDDEN)
+                    continue;
+
+                vec3f& min = scene->bounding_volumes[n].transformed_min_extents;
+                vec3f& max = scene->bounding_volumes[n].transformed_max_extents;
+                vec3f  pos = min + (max - min) * 0.5f;
+
+                cmp_material& mat = scene->materials[n];
+
+                // shader / technique
+                u32 shader = mat.shader;
+                u32 technique_index = mat.technique_index;
+                if (is_valid(view.pmfx_shader))
+                {
+                    shader = view.pmfx_shader;
+                    technique_index =
+                        pmfx::get_technique_index_perm(view.pmfx_shader, view.technique, scene->material_permutation[n]);
+
+                    if (!is_valid(technique_index))
+                    {
+                        PEN_ASSERT(0);
+                        continue;
+                    }
+                }
+
+                u32   layer = scene->entities[n] & CMP_MASTER_INSTANCE ? DRAW_LAYER_INSTANCED : DRAW_LAYER_SINGLE;
+                vec3f to_camera = pos - camera_pos;
+
+                draw_packet& dp = s_draw_packets.packets[num_packets++];
+                dp.entity = n;
+                dp.technique_index = technique_index;
+                dp.lod = select_lod(scene, n, view, pos, lods);
+                dp.key = draw_key(layer, (shader << 8) | technique_index, (u32)scene->id_material[n],
+                                  scene->geometries[n].vertex_buffer, dot(to_camera, to_camera));
+            }
+
+            draw_packet* packets = radix_sort_draw_packets(s_draw_packets.packets, s_draw_packets.scratch, num_packets);
+
+            // group runs of packets which can be drawn with a single instanced draw
+            u32 num_batches = build_draw_batches(scene, view, packets, num_packets);
+
+            stats.sort_us += pen::get_time_us() - sort_start;
+            stats.draw_packets += num_packets;
+
+            if (num_packets == 0)
+                return;
+
+            // per view constants, bound once for all packets
+            u32 view_binds = 2;
+            pen::renderer_set_constant_buffer(view.cb_view, 0, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
+
+            // fwd lights
+            if (view.render_flags & RENDER_FORWARD_LIT)
+            {
+                pen::renderer_set_constant_buffer(scene->forward_light_buffer, 3, pen::CBUFFER_BIND_PS);
+                pen::renderer_set_constant_buffer(scene->shadow_map_buffer, 4, pen::CBUFFER_BIND_PS);
+                pen::renderer_set_constant_buffer(scene->area_light_buffer, 6, pen::CBUFFER_BIND_PS);
+
+                // ltc lookups
+                static u32 ltc_mat = put::load_texture("data/textures/ltc/ltc_mat.dds");
+                static u32 ltc_mag = put::load_texture("data/textures/ltc/ltc_amp.dds");
+
+                static hash_id id_clamp_linear = PEN_HASH("clamp_linear");
+                u32            clamp_linear = pmfx::get_render_state(id_clamp_linear, pmfx::RS_SAMPLER);
+
+                pen::renderer_set_texture(ltc_mat, clamp_linear, 13, pen::TEXTURE_BIND_PS);
+                pen::renderer_set_texture(ltc_mag, clamp_linear, 12, pen::TEXTURE_BIND_PS);
+                view_binds += 5;
+            }
+
+            // sdf shadows
+            pen::renderer_set_constant_buffer(scene->sdf_shadow_buffer, 5, pen::CBUFFER_BIND_PS);
+            for (u32 n = 0; n < scene->num_entities; ++n)
+            {
+                if (scene->entities[n] & CMP_SDF_SHADOW)
+                {
+                    cmp_shadow& shadow = scene->shadows[n];
+
+                    if (is_valid(shadow.texture_handle))
+                    {
+                        pen::renderer_set_texture(shadow.texture_handle, shadow.sampler_state, SDF_SHADOW_UNIT,
+                                                  pen::TEXTURE_BIND_PS);
+                        view_binds++;
+                    }
+                }
+            }
+
+            // draw call data of every instanced batch in the view is packed into the transient instance buffer with a
+            // single update, each batch then binds the buffer at its own offset. backends limit the number of updates
+            // a dynamic buffer can take in a frame and gl would stall on a buffer still in use by the previous batch
+            u32 num_instances = 0;
+            for (u32 b = 0; b < num_batches; ++b)
+            {
+                const draw_batch& batch = s_draw_packets.batches[b];
+                for (u32 i = 0; i < batch.num_instances; ++i)
+                    s_draw_packets.instance_data[num_instances++] =
+                        scene->draw_call_data[packets[batch.packet + i].entity];
+            }
+
+            if (num_instances)
+            {
+                u32 instance_bytes = num_instances * sizeof(cmp_draw_call);
+                reserve_instance_buffer(instance_bytes);
+                pen::renderer_update_buffer(s_draw_packets.instance_buffer, s_draw_packets.instance_data, instance_bytes);
+            }
+
+            // submit sorted batches, only binding state which differs from the previous batch
+            u32 instance_offset = 0;
+            u32 cur_shader = PEN_INVALID_HANDLE;
+            u32 cur_technique = PEN_INVALID_HANDLE;
+            u32 cur_mcb = PEN_INVALID_HANDLE;
+            u32 cur_vb = PEN_INVALID_HANDLE;
+            u32 cur_ib = PEN_INVALID_HANDLE;
+
+            // bound textures are tracked per pixel shader sampler unit, different binding slots can share a unit
+            sampler_binding cur_units[MAX_SAMPLER_BINDINGS];
+
+            u32 unsorted_binds = 0;
+            u32 sorted_binds = view_binds;
+
+            for (u32 b = 0; b < num_batches; ++b)
+            {
+                const draw_batch& batch = s_draw_packets.batches[b];
+
+                u32                 n = packets[batch.packet].entity;
+                cmp_geometry*       p_geom = &scene->geometries[n];
+                cmp_material*       p_mat = &scene->materials[n];
+                const geometry_lod& lod = p_geom->lods[packets[batch.packet].lod];
+
+                // number of entities which would have been drawn one by one
+                u32 batch_entities = max(batch.num_instances, (u32)1);
+
+                // set shader / technique
+                u32 shader = is_valid(view.pmfx_shader) ? view.pmfx_shader : p_mat->shader;
+                u32 technique_index = batch.technique_index;
+
+                unsorted_binds += batch_entities;
+                if (shader != cur_shader || technique_index != cur_technique)
+                {
+                    pmfx::set_technique(shader, technique_index);
+                    cur_shader = shader;
+                    cur_technique = technique_index;
+                    sorted_binds++;
+                }
+
+                // update skin
+                if (scene->entities[n] & CMP_SKINNED && !(scene->entities[n] & CMP_SUB_GEOMETRY))
+                {
+                    if (p_geom->p_skin->bone_cbuffer == PEN_INVALID_HANDLE)
+                    {
+                        pen::buffer_creation_params bcp;
+                        bcp.usage_flags = PEN_USAGE_DYNAMIC;
+                        bcp.bind_flags = PEN_BIND_CONSTANT_BUFFER;
+                        bcp.cpu_access_flags = PEN_CPU_ACCESS_WRITE;
+                        bcp.buffer_size = sizeof(mat4) * 85;
+                        bcp.data = nullptr;
+
+                        p_geom->p_skin->bone_cbuffer = pen::renderer_create_buffer(bcp);
+                    }
+
+                    static mat4 bb[85];
+                    s32         joints_offset = scene->anim_controller[n].joints_offset;
+                    for (s32 i = 0; i < p_geom->p_skin->num_joints; ++i)
+                        bb[i] = scene->world_matrices[joints_offset + i] * p_geom->p_skin->joint_bind_matrices[i];
+
+                    pen::renderer_update_buffer(p_geom->p_skin->bone_cbuffer, bb, sizeof(bb));
+                    pen::renderer_set_constant_buffer(p_geom->p_skin->bone_cbuffer, 2, pen::CBUFFER_BIND_VS);
+                }
+
+                // set material cbs
+                u32 mcb = p_mat->material_cbuffer;
+                if (is_valid(mcb))
+                {
+                    unsorted_binds += batch_entities;
+                    if (mcb != cur_mcb)
+                    {
+                        pen::renderer_set_constant_buffer(mcb, 7, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
+                        cur_mcb = mcb;
+                        sorted_binds++;
+                    }
+                }
+
+                pen::renderer_set_constant_buffer(scene->cbuffer[n], 1, pen::CBUFFER_BIND_PS | pen::CBUFFER_BIND_VS);
+
+                // set ib / vb
+                unsorted_binds += 2 * batch_entities;
+                if (batch.num_instances)
+                {
+                    u32 vbs[2] = {p_geom->vertex_buffer, s_draw_packets.instance_buffer};
+                    u32 strides[2] = {p_geom->vertex_size, sizeof(cmp_draw_call)};
+                    u32 offsets[2] = {0, instance_offset * (u32)sizeof(cmp_draw_call)};
+                    instance_offset += batch.num_instances;
+
+                    pen::renderer_set_vertex_buffers(vbs, 2, 0, strides, offsets);
+                    cur_vb = PEN_INVALID_HANDLE;
+                    sorted_binds++;
+                }
+                else if (scene->entities[n] & CMP_MASTER_INSTANCE)
+                {
+                    u32 vbs[2] = {p_geom->vertex_buffer, scene->master_instances[n].instance_buffer};
+                    u32 strides[2] = {p_geom->vertex_size, scene->master_instances[n].instance_stride};
+                    u32 offsets[2] = {0};
+
+                    pen::renderer_set_vertex_buffers(vbs, 2, 0, strides, offsets);
+                    cur_vb = PEN_INVALID_HANDLE;
+                    sorted_binds++;
+                }
+                else if (p_geom->vertex_buffer != cur_vb)
+                {
+                    pen::renderer_set_vertex_buffer(p_geom->vertex_buffer, 0, p_geom->vertex_size, 0);
+                    cur_vb = p_geom->vertex_buffer;
+                    sorted_binds++;
+                }
+
+                if (p_geom->index_buffer != cur_ib)
+                {
+                    pen::renderer_set_index_buffer(p_geom->index_buffer, p_geom->index_type, 0);
+                    cur_ib = p_geom->index_buffer;
+                    sorted_binds++;
+                }
+
+                // set textures
+                cmp_samplers& samplers = scene->samplers[n];
+                for (u32 s = 0; s < MAX_TECHNIQUE_SAMPLER_BINDINGS; ++s)
+                {
+                    const sampler_binding& sb = samplers.sb[s];
+                    if (!sb.handle)
+                        continue;
+
+                    unsorted_binds += batch_entities;
+
+                    if (sb.sampler_unit < MAX_SAMPLER_BINDINGS)
+                    {
+                        sampler_binding& cur = cur_units[sb.sampler_unit];
+                        if (sb.handle == cur.handle && sb.sampler_state == cur.sampler_state)
+                            continue;
+
+                        cur = sb;
+                    }
+
+                    pen::renderer_set_texture(sb.handle, sb.sampler_state, sb.sampler_unit, pen::TEXTURE_BIND_PS);
+                    sorted_binds++;
+                }
+
+                // per view constants were previously rebound for every draw
+                unsorted_binds += view_binds * batch_entities;
+
+                stats.draw_calls++;
+
+                u32 lod_triangles = lod.num_indices / 3;
+                stats.triangles += lod_triangles * batch_entities;
+                stats.triangles_saved += (p_geom->num_indices / 3 - lod_triangles) * batch_entities;
+
+                // dynamic instances
+                if (batch.num_instances)
+                {
+                    pen::renderer_draw_indexed_instanced(batch.num_instances, 0, lod.num_indices, lod.start_index, 0,
+                                                         PEN_PT_TRIANGLELIST);
+                    stats.instanced_entities += batch.num_instances;
+                    continue;
+                }
+
+                // authored instances
+                if (scene->entities[n] & CMP_MASTER_INSTANCE)
+                {
+                    u32 num_instances = scene->master_instances[n].num_instances;
+                    pen::renderer_draw_indexed_instanced(num_instances, 0, p_geom->num_indices, 0, 0,
+                                                         PEN_PT_TRIANGLELIST);
+                    continue;
+                }
+
+                // single
+                pen::renderer_draw_indexed(lod.num_indices, lod.start_index, 0, PEN_PT_TRIANGLELIST);
+            }
+
+            stats.state_changes += sorted_binds;
+            stats.state_changes_saved += unsorted_binds - min(unsorted_binds, sorted_binds);
+        }
+
+        // last key at or before t, clamped to the first key. cursor is the key found on the previous update, forward
+        // playback lands on it or the next key so only seeks and backwards time need the binary search
+        u32 find_anim_key(const f32* times, u32 num_frames, u32 cursor, f32 t)
+        {
+            u32 lo = 0;
+            u32 hi = num_frames;
+
+            if (cursor < num_frames && times[cursor] <= t)
+            {
+                if (cursor + 1 >= num_frames || t < times[cursor + 1])
+                    return cursor;
+
+                if (cursor + 2 >= num_frames || t < times[cursor + 2])
+                    return cursor + 1;
+
+                lo = cursor + 2;
+            }
+
+            while (lo < hi)
+            {
+                u32 mid = lo + (hi - lo) / 2;
+                if (times[mid] <= t)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            return lo > 0 ? lo - 1 : 0;
+        }
+
+        // expand a compressed key into the same element layout as uncompressed soa data
+        void decode_anim_key(const anim_channel& channel, const u16* q, f32* out)
+        {
+            static const f32 k_inv_sqrt2 = 0.70710678f;
+
+            u32 e = 0;
+            while (e < channel.element_count)
+            {
+                if (channel.element_offset[e] == A_OUT_QUAT)
+                {
+                    // smallest three, rebuild the dropped component from unit length
+                    u32 largest = (q[0] >> 15) | ((q[1] >> 15) << 1);
+                    f32 sum = 0.0f;
+                    u32 s = 0;
+
+                    for (u32 i = 0; i < 4; ++i)
+                    {
+                        if (i == largest)
+                            continue;
+
+                        f32 c = ((f32)(q[s++] & 0x7fff) / 32767.0f * 2.0f - 1.0f) * k_inv_sqrt2;
+                        out[e + i] = c;
+                        sum += c * c;
+                    }
+
+                    out[e + largest] = sqrt(max(1.0f - sum, 0.0f));
+
+                    q += 3;
+                    e += 4;
+                }
+                else
+                {
+                    out[e] = channel.range_min[e] + (f32)(*q++) * channel.range_scale[e];
+                    e++;
+                }
+            }
+        }
+
+        // samples, blends and writes joint transforms for a single controller, only touches the controller entity and its
+        // own joints so controllers can be updated concurrently
+        static void update_anim_controller(ecs_scene* scene, u32 n, f32 dt)
+        {
+            cmp_anim_controller_v2 controller = scene->anim_controller_v2[n];
+
+            u32 num_anims = sb_count(controller.anim_instances);
+            for (u32 ai = 0; ai < num_anims; ++ai)
+            {
+                anim_instance& instance = controller.anim_instances[ai];
+
+                if (instance.flags & anim_flags::PAUSED)
+                    continue;
+
+                soa_anim& soa = instance.soa;
+                u32       num_channels = soa.num_channels;
+                f32       anim_t = instance.time;
+
+                bool looped = false;
+
+                // roll on time
+                instance.time += dt;
+                if (instance.time >= instance.length)
+                {
+                    instance.time = 0.0f;
+                    looped = true;
+                }
+
+                if (instance.flags & anim_flags::LOOPED)
+                {
+                    instance.flags &= ~anim_flags::LOOPED;
+                    looped = true;
+                }
+
+                u32 num_joints = sb_count(instance.joints);
+
+                // reset rotations
+                for (u32 j = 0; j < num_joints; ++j)
+                    instance.targets[j].q = quat(0.0f, 0.0f, 0.0f);
+
+                for (s32 c = 0; c < num_channels; ++c)
+                {
+                    anim_sampler& sampler = instance.samplers[c];
+                    anim_channel& channel = soa.channels[c];
+
+                    if (sampler.joint == PEN_INVALID_HANDLE || channel.num_frames == 0)
+                        continue;
+
+                    const f32* times = &soa.times[channel.key_offset];
+
+                    //reset flag
+                    sampler.flags &= ~anim_flags::LOOPED;
+
+                    // find the frame we are on.. before the first or past the last key of a channel shorter than
+                    // the clip snaps to the first key and flags the sampler as looped
+                    if (looped || anim_t <= times[0] || anim_t > times[channel.num_frames - 1])
+                    {
+                        sampler.pos = 0;
+                        sampler.flags = anim_flags::LOOPED;
+                    }
+                    else
+                    {
+                        sampler.pos = find_anim_key(times, channel.num_frames, sampler.pos, anim_t);
+                    }
+
+                    u32 next = (sampler.pos + 1) % channel.num_frames;
+
+                    // get anim data
+                    const f32* d1;
+                    const f32* d2;
+
+                    f32 k1[21];
+                    f32 k2[21];
+
+                    bool compressed = channel.flags & anim_flags::COMPRESSED;
+                    if (compressed)
+                    {
+                        const u16* qdata = &soa.qdata[channel.data_offset];
+                        decode_anim_key(channel, &qdata[sampler.pos * channel.packed_count], k1);
+                        decode_anim_key(channel, &qdata[next * channel.packed_count], k2);
+
+                        d1 = k1;
+                        d2 = k2;
+                    }
+                    else
+                    {
+                        const f32* data = &soa.data[channel.data_offset];
+                        d1 = &data[sampler.pos * channel.element_count];
+                        d2 = &data[next * channel.element_count];
+                    }
+
+                    f32 a = (anim_t - times[sampler.pos]);
+                    f32 b = (times[next] - times[sampler.pos]);
+
+                    f32 it = min(max(a / b, 0.0f), 1.0f);
+
+                    sampler.prev_t = sampler.cur_t;
+                    sampler.cur_t = it;
+
+                    for (u32 e = 0; e < channel.element_count; ++e)
+                    {
+                        u32 eo = channel.element_offset[e];
+
+                        // slerp quats
+                        if (eo == A_OUT_QUAT)
+                        {
+                            quat q1;
+                            quat q2;
+
+                            memcpy(&q1.v[0], &d1[e], 16);
+                            memcpy(&q2.v[0], &d2[e], 16);
+
+                            // smallest three keeps the largest component positive so neighbouring keys can be flipped
+                            f32 qd = q1.v[0] * q2.v[0] + q1.v[1] * q2.v[1] + q1.v[2] * q2.v[2] + q1.v[3] * q2.v[3];
+                            if (compressed && qd < 0.0f)
+                                for (u32 i = 0; i < 4; ++i)
+                                    q2.v[i] = -q2.v[i];
+
+                            quat ql = slerp(q1, q2, it);
+
+                            instance.targets[sampler.joint].q = ql * instance.targets[sampler.joint].q;
+                            instance.targets[sampler.joint].flags |= channel.flags;
+                            e += 3;
+                        }
+                        else
+                        {
+                            // lerp translation / scale
+                            f32 lf = (1 - it) * d1[e] + it * d2[e];
+                            instance.targets[sampler.joint].t[eo] = lf;
+                        }
+                    }
+                }
+
+                // bake anim target into a cmp transform for joint
+                u32 tj = PEN_INVALID_HANDLE;
+                for (u32 j = 0; j < num_joints; ++j)
+                {
+                    u32 jnode = controller.joint_indices[j];
+
+                    if (scene->entities[jnode] & CMP_ANIM_TRAJECTORY)
+                    {
+                        tj = j;
+                        continue;
+                    }
+
+                    f32* f = &instance.targets[j].t[0];
+
+                    instance.joints[j].translation = vec3f(f[A_OUT_TX], f[A_OUT_TY], f[A_OUT_TZ]);
+                    instance.joints[j].scale = vec3f(f[A_OUT_SX], f[A_OUT_SY], f[A_OUT_SZ]);
+
+                    if (instance.targets[j].flags & anim_flags::BAKED_QUATERNION)
+                        instance.joints[j].rotation = instance.targets[j].q;
+                    else
+                        instance.joints[j].rotation = scene->initial_transform[jnode].rotation * instance.targets[j].q;
+                }
+
+                // root motion.. todo rotation
+                if (tj != PEN_INVALID_HANDLE)
+                {
+                    f32*  f = &instance.targets[tj].t[0];
+                    vec3f tt = vec3f(f[0], f[1], f[2]);
+
+                    if (instance.samplers[0].flags & anim_flags::LOOPED)
+                    {
+                        // inherit prev root motion
+                        instance.root_translation = tt;
+                    }
+                    else
+                    {
+                        instance.root_delta = tt - instance.root_translation;
+                        instance.root_translation = tt;
+                    }
+                }
+            }
+
+            // for active controller.anim_instances, make trans, quat, scale
+            //      blend tree
+            if (num_anims > 0)
+            {
+                anim_instance& a = controller.anim_instances[controller.blend.anim_a];
+                anim_instance& b = controller.anim_instances[controller.blend.anim_b];
+                f32            t = controller.blend.ratio;
+
+                u32 num_joints = sb_count(a.joints);
+                for (u32 j = 0; j < num_joints; ++j)
+                {
+                    u32 jnode = controller.joint_indices[j];
+
+                    cmp_transform& tc = scene->transforms[jnode];
+                    cmp_transform& ta = a.joints[j];
+                    cmp_transform& tb = b.joints[j];
+
+                    if (scene->entities[jnode] & CMP_ANIM_TRAJECTORY)
+                    {
+                        vec3f lerp_delta = lerp(a.root_delta, b.root_delta, t);
+
+                        mat4 rot_mat;
+                        quat q = scene->initial_transform[jnode].rotation;
+                        q.get_matrix(rot_mat);
+
+                        vec3f transform_translation = rot_mat.transform_vector(lerp_delta);
+
+                        // apply root motion to the root controller, so we bring along the meshes
+                        scene->transforms[n].rotation = q;
+                        scene->transforms[n].translation += transform_translation;
+                        scene->entities[n] |= CMP_TRANSFORM;
+
+                        continue;
+                    }
+
+                    tc.translation = lerp(ta.translation, tb.translation, t);
+                    tc.rotation = slerp2(ta.rotation, tb.rotation, t);
+                    tc.scale = lerp(ta.scale, tb.scale, t);
+
+                    scene->entities[jnode] |= CMP_TRANSFORM;
+                }
+            }
+        }
+
+        struct anim_pass
+        {
+            ecs_scene* scene;
+            const u32* controllers;
+            f32        dt;
+        };
+
+        static u32*      s_anim_controllers = nullptr;
+        static const u32 k_anim_grain = 4;
+
+        static void parallel_anim_controllers(u32 start, u32 end, void* user_data)
+        {
+            anim_pass* ap = (anim_pass*)user_data;
+            for (u32 i = start; i < end; ++i)
+                update_anim_controller(ap->scene, ap->controllers[i], ap->dt);
+        }
+
+        void update_animations(ecs_scene* scene, f32 dt)
+        {
+            //dt = 16.66;
+            //pen::timer* timer = pen::timer_create("anim_v2");
+            //pen::timer_start(timer);
+
+            if (s_anim_controllers)
+                stb__sbn(s_anim_controllers) = 0;
+
+            for (u32 n = 0; n < scene->num_entities; ++n)
+                if (scene->entities[n] & CMP_ANIM_CONTROLLER)
+                    sb_push(s_anim_controllers, n);
+
+            // joints are written straight into scene transforms here, before update_transforms builds the hierarchy
+            anim_pass ap = {scene, s_anim_controllers, dt};
+            pen::parallel_for(sb_count(s_anim_controllers), k_anim_grain, parallel_anim_controllers, &ap);
 
             //f32 ms = pen::timer_elapsed_ms(timer);
             //PEN_LOG("anim_v2 : %f", ms);
@@ -1000,10 +1797,12 @@ namespace put
                     if (num_frames <= 0)
                         continue;
 
-                    s32 t = 0;
-                    for (t = 0; t < num_frames; ++t)
-                        if (controller.current_time < anim->channels[c].times[t])
-                            break;
+                    // first key after the current time, processed_frame from the last update is the search hint
+                    const f32* times = anim->channels[c].times;
+                    s32        prev = anim->channels[c].processed_frame;
+                    u32        cursor = prev > 0 ? prev - 1 : 0;
+                    u32        k = find_anim_key(times, num_frames, cursor, controller.current_time);
+                    s32        t = times[k] <= controller.current_time ? k + 1 : 0;
 
                     bool new_frame = false;
                     if (anim->channels[c].processed_frame != t)
@@ -1066,54 +1865,424 @@ namespace put
             bool       bdt = dev_ui::get_program_preference("dynamic_timestep").as_bool(true);
             f32        ft = dev_ui::get_program_preference("fixed_timestep").as_f32(fft);
 
-            if (!bdt)
+            if (!bdt)
+            {
+                dt = ft;
+            }
+
+            for (auto& si : s_scenes)
+            {
+                update_scene(si.scene, dt);
+            }
+        }
+
+        std::vector<ecs_scene_instance>* get_scenes()
+        {
+            return &s_scenes;
+        }
+
+        // hierarchy grouped by depth for the parallel transform update, entities at the same depth are independent
+        struct transform_levels
+        {
+            u32* depth = nullptr;
+            u32* level_entities = nullptr; // entities ordered by depth
+            u32* level_offsets = nullptr;  // start of each level in level_entities, num_levels + 1 entries
+            u32* child_offsets = nullptr;  // children of each entity in children, num_entities + 1 entries
+            u32* children = nullptr;
+            u8*  compose = nullptr; // 0 when the world matrix is left untouched this frame
+            u32  num_levels = 0;
+            u32  capacity = 0;
+        };
+
+        struct transform_pass
+        {
+            ecs_scene*        scene;
+            transform_levels* levels;
+            const u32*        entities;
+            u8                reset_flags; // DIRTY_ALL when the cached state was reset
+        };
+
+        static transform_levels          s_transform_levels;
+        static const physics::rb_output* s_rb_output; // physics front buffer snapshot for the current update
+        static const u32                 k_transform_grain = 256;
+
+        static const vec3f k_bounds_corners[] = {vec3f(0.0f, 0.0f, 0.0f),
+
+                                                 vec3f(1.0f, 0.0f, 0.0f), vec3f(0.0f, 1.0f, 0.0f), vec3f(0.0f, 0.0f, 1.0f),
+
+                                                 vec3f(1.0f, 1.0f, 0.0f), vec3f(0.0f, 1.0f, 1.0f), vec3f(1.0f, 0.0f, 1.0f),
+
+                                                 vec3f(1.0f, 1.0f, 1.0f)};
+
+        // returns false when the world matrix should be left as is
+        static bool update_local_matrix(ecs_scene* scene, u32 n)
+        {
+            // controlled transform
+            if (scene->entities[n] & CMP_TRANSFORM)
+            {
+                cmp_transform& t = scene->transforms[n];
+
+                // generate matrix from transform
+                mat4 rot_mat;
+                t.rotation.get_matrix(rot_mat);
+
+                mat4 translation_mat = mat::create_translation(t.translation);
+
+                mat4 scale_mat = mat::create_scale(t.scale);
+
+                scene->local_matrices[n] = translation_mat * rot_mat * scale_mat;
+
+                // local matrix will be baked
+                scene->entities[n] &= ~CMP_TRANSFORM;
+            }
+            else if (scene->entities[n] & CMP_PHYSICS)
+            {
+                const physics::rb_output& po = *s_rb_output;
+
+                u32 h = scene->physics_handles[n];
+                if (h >= po.capacity || po.frames[h] == 0)
+                    return false;
+
+                // body has not moved since the last sync
+                if (po.frames[h] <= scene->dirty.physics_frame)
+                    return true;
+
+                cmp_transform& t = scene->transforms[n];
+                cmp_transform& pt = scene->physics_offset[n];
+
+                mat4 scale_mat = mat::create_scale(t.scale);
+
+                t.translation = po.translations[h];
+                t.rotation = po.rotations[h];
+
+                mat4 rot_mat;
+                t.rotation.get_matrix(rot_mat);
+
+                mat4 translation_mat = mat::create_translation(t.translation - pt.translation);
+
+                scene->local_matrices[n] = translation_mat * rot_mat * scale_mat;
+            }
+
+            return true;
+        }
+
+        static void update_world_matrix(ecs_scene* scene, u32 n)
+        {
+            // heirarchical scene transform
+            u32 parent = scene->parents[n];
+            if (parent == n)
+                scene->world_matrices[n] = scene->local_matrices[n];
+            else
+                scene->world_matrices[n] = scene->world_matrices[parent] * scene->local_matrices[n];
+        }
+
+        static void update_transformed_bounds(ecs_scene* scene, u32 n)
+        {
+            vec3f min = scene->bounding_volumes[n].min_extents;
+            vec3f max = scene->bounding_volumes[n].max_extents - min;
+
+            vec3f& tmin = scene->bounding_volumes[n].transformed_min_extents;
+            vec3f& tmax = scene->bounding_volumes[n].transformed_max_extents;
+
+            if (scene->entities[n] & CMP_BONE)
+            {
+                tmin = tmax = scene->world_matrices[n].get_translation();
+                return;
+            }
+
+            tmax = -vec3f::flt_max();
+            tmin = vec3f::flt_max();
+
+            for (s32 c = 0; c < 8; ++c)
+            {
+                vec3f p = scene->world_matrices[n].transform_vector(min + max * k_bounds_corners[c]);
+
+                tmax = vec3f::vmax(tmax, p);
+                tmin = vec3f::vmin(tmin, p);
+            }
+
+            f32& trad = scene->bounding_volumes[n].radius;
+            trad = mag(tmax - tmin) * 0.5f;
+        }
+
+        // returns true when the cached state was reset and every entity must be treated as dirty
+        static bool reserve_dirty_state(ecs_scene* scene)
+        {
+            dirty_state& ds = scene->dirty;
+            u32          num = scene->num_entities;
+            bool         reset = ds.num_entities != num;
+
+            if (ds.capacity < num)
+            {
+                ds.local_matrices = (mat4*)pen::memory_realloc(ds.local_matrices, sizeof(mat4) * num);
+                ds.parents = (u32*)pen::memory_realloc(ds.parents, sizeof(u32) * num);
+                ds.entities = (u64*)pen::memory_realloc(ds.entities, sizeof(u64) * num);
+                ds.extents = (vec3f*)pen::memory_realloc(ds.extents, sizeof(vec3f) * num * 2);
+                ds.draw_call_data = (cmp_draw_call*)pen::memory_realloc(ds.draw_call_data, sizeof(cmp_draw_call) * num);
+                ds.cbuffers = (u32*)pen::memory_realloc(ds.cbuffers, sizeof(u32) * num);
+                ds.material_data =
+                    (cmp_material_data*)pen::memory_realloc(ds.material_data, sizeof(cmp_material_data) * num);
+                ds.material_cbuffers = (u32*)pen::memory_realloc(ds.material_cbuffers, sizeof(u32) * num);
+                ds.instance_buffers = (u32*)pen::memory_realloc(ds.instance_buffers, sizeof(u32) * num);
+                ds.flags = (u8*)pen::memory_realloc(ds.flags, num);
+                ds.capacity = num;
+                reset = true;
+            }
+
+            if (reset)
+                ds.physics_frame = 0;
+
+            if (ds.bounds_entities)
+                stb__sbn(ds.bounds_entities) = 0;
+
+            ds.num_entities = num;
+            ds.stats = dirty_stats();
+            ds.stats.entities = num;
+
+            return reset;
+        }
+
+        // updates the local matrix and compares against the state from the last update to flag what changed, returns
+        // false when the world matrix should be left as is
+        static bool update_local_state(ecs_scene* scene, u32 n, u8 reset_flags)
+        {
+            dirty_state& ds = scene->dirty;
+            u8           flags = reset_flags;
+
+            bool compose = update_local_matrix(scene, n);
+
+            // local matrices are also written directly by loaders, anims and set_parent so compare rather than
+            // relying on CMP_TRANSFORM. ds.parents keeps the old parent until propagate_dirty_bounds has dirtied it
+            if (memcmp(&ds.local_matrices[n], &scene->local_matrices[n], sizeof(mat4)) != 0 ||
+                ds.parents[n] != scene->parents[n])
+            {
+                ds.local_matrices[n] = scene->local_matrices[n];
+                flags |= DIRTY_LOCAL;
+            }
+
+            u64 cmp_flags = scene->entities[n] & ~(u64)CMP_TRANSFORM;
+            if (ds.entities[n] != cmp_flags)
+            {
+                ds.entities[n] = cmp_flags;
+                flags |= DIRTY_LOCAL | DIRTY_BOUNDS;
+            }
+
+            const cmp_bounding_volume& bv = scene->bounding_volumes[n];
+            vec3f*                     ext = &ds.extents[n * 2];
+            if (memcmp(&ext[0], &bv.min_extents, sizeof(vec3f)) != 0 || memcmp(&ext[1], &bv.max_extents, sizeof(vec3f)) != 0)
+            {
+                ext[0] = bv.min_extents;
+                ext[1] = bv.max_extents;
+                flags |= DIRTY_BOUNDS;
+            }
+
+            ds.flags[n] = flags;
+            return compose;
+        }
+
+        // parents are always updated first, so a world matrix only needs composing if the local or parent changed
+        static void update_world_state(ecs_scene* scene, u32 n)
+        {
+            u8* flags = scene->dirty.flags;
+
+            u32 parent = scene->parents[n];
+            if (!(flags[n] & DIRTY_LOCAL) && (parent == n || !(flags[parent] & DIRTY_WORLD)))
+                return;
+
+            update_world_matrix(scene, n);
+            flags[n] |= DIRTY_WORLD | DIRTY_BOUNDS;
+        }
+
+        // parent extents include their children, so dirty bounds propagate towards the root
+        static void propagate_dirty_bounds(ecs_scene* scene)
+        {
+            dirty_state& ds = scene->dirty;
+
+            for (s32 n = scene->num_entities - 1; n >= 0; --n)
+            {
+                if (ds.flags[n] & DIRTY_WORLD)
+                    ++ds.stats.transforms;
+
+                // a deleted or reparented child no longer contributes to the extents of its old parent
+                u32 old_parent = ds.parents[n];
+                if (old_parent != scene->parents[n])
+                {
+                    if (old_parent < scene->num_entities && old_parent != (u32)n)
+                    {
+                        // an old parent after its child has already been visited
+                        if (old_parent > (u32)n && !(ds.flags[old_parent] & DIRTY_BOUNDS))
+                            sb_push(ds.bounds_entities, old_parent);
+
+                        ds.flags[old_parent] |= DIRTY_BOUNDS;
+                    }
+
+                    ds.parents[n] = scene->parents[n];
+                }
+
+                if (!(ds.flags[n] & DIRTY_BOUNDS))
+                    continue;
+
+                ++ds.stats.bounds;
+                sb_push(ds.bounds_entities, (u32)n);
+
+                u32 p = scene->parents[n];
+                if (n > 0 && p != n && scene->entities[n] & CMP_ALLOCATED)
+                    ds.flags[p] |= DIRTY_BOUNDS;
+            }
+        }
+
+        static void expand_parent_extents(ecs_scene* scene, u32 p, u32 n)
+        {
+            vec3f& parent_tmin = scene->bounding_volumes[p].transformed_min_extents;
+            vec3f& parent_tmax = scene->bounding_volumes[p].transformed_max_extents;
+
+            vec3f& tmin = scene->bounding_volumes[n].transformed_min_extents;
+            vec3f& tmax = scene->bounding_volumes[n].transformed_max_extents;
+
+            if (scene->entities[p] & CMP_ANIM_CONTROLLER)
+            {
+                vec3f pad = vec3f(0.0f);
+
+                parent_tmin = vec3f::vmin(parent_tmin, tmin - pad);
+                parent_tmax = vec3f::vmax(parent_tmax, tmax + pad);
+            }
+            else
+            {
+                parent_tmin = vec3f::vmin(parent_tmin, tmin);
+                parent_tmax = vec3f::vmax(parent_tmax, tmax);
+            }
+        }
+
+        // groups entities by depth and builds child lists, returns false if any parent is stored after its child in
+        // which case the parallel passes could read a parent before it is written and the serial path is used instead.
+        static bool build_transform_levels(ecs_scene* scene, transform_levels& tl)
+        {
+            u32 num = scene->num_entities;
+
+            if (tl.capacity < num + 1)
+            {
+                u32 size_bytes = sizeof(u32) * (num + 1);
+                tl.depth = (u32*)pen::memory_realloc(tl.depth, size_bytes);
+                tl.level_entities = (u32*)pen::memory_realloc(tl.level_entities, size_bytes);
+                tl.level_offsets = (u32*)pen::memory_realloc(tl.level_offsets, size_bytes + sizeof(u32));
+                tl.child_offsets = (u32*)pen::memory_realloc(tl.child_offsets, size_bytes + sizeof(u32));
+                tl.children = (u32*)pen::memory_realloc(tl.children, size_bytes);
+                tl.compose = (u8*)pen::memory_realloc(tl.compose, num + 1);
+                tl.capacity = num + 1;
+            }
+
+            // depth, counted per level
+            tl.num_levels = 0;
+            pen::memory_zero(tl.level_offsets, sizeof(u32) * (num + 2));
+            pen::memory_zero(tl.child_offsets, sizeof(u32) * (num + 2));
+
+            for (u32 n = 0; n < num; ++n)
+            {
+                u32 parent = scene->parents[n];
+                if (parent > n)
+                    return false;
+
+                tl.depth[n] = parent == n ? 0 : tl.depth[parent] + 1;
+                tl.level_offsets[tl.depth[n] + 1]++;
+                tl.num_levels = max(tl.num_levels, tl.depth[n] + 1);
+
+                // children matching the serial reverse extents pass
+                if (n > 0 && parent != n && scene->entities[n] & CMP_ALLOCATED)
+                    tl.child_offsets[parent + 1]++;
+            }
+
+            for (u32 l = 0; l < tl.num_levels; ++l)
+                tl.level_offsets[l + 1] += tl.level_offsets[l];
+
+            for (u32 n = 0; n < num; ++n)
+                tl.child_offsets[n + 1] += tl.child_offsets[n];
+
+            // scatter using the offsets as cursors
+            for (u32 n = 0; n < num; ++n)
             {
-                dt = ft;
+                u32 d = tl.depth[n];
+                tl.level_entities[tl.level_offsets[d]++] = n;
             }
 
-            for (auto& si : s_scenes)
+            for (u32 n = 0; n < num; ++n)
             {
-                update_scene(si.scene, dt);
+                u32 parent = scene->parents[n];
+                if (n > 0 && parent != n && scene->entities[n] & CMP_ALLOCATED)
+                    tl.children[tl.child_offsets[parent]++] = n;
             }
+
+            // scatter advanced each offset to the start of the next range, shift back
+            for (u32 l = tl.num_levels; l > 0; --l)
+                tl.level_offsets[l] = tl.level_offsets[l - 1];
+            tl.level_offsets[0] = 0;
+
+            for (u32 n = num; n > 0; --n)
+                tl.child_offsets[n] = tl.child_offsets[n - 1];
+            tl.child_offsets[0] = 0;
+
+            return true;
         }
 
-        std::vector<ecs_scene_instance>* get_scenes()
+        static void parallel_local_matrices(u32 start, u32 end, void* user_data)
         {
-            return &s_scenes;
+            transform_pass* tp = (transform_pass*)user_data;
+            for (u32 n = start; n < end; ++n)
+                tp->levels->compose[n] = update_local_state(tp->scene, n, tp->reset_flags) ? 1 : 0;
         }
 
-        void update_scene(ecs_scene* scene, f32 dt)
+        static void parallel_world_matrices(u32 start, u32 end, void* user_data)
         {
-            // static anim time to pass into draw calls etc..
-            f32 anim_time = pen::get_time_ms() / 1000.0;
-
-            u32 num_controllers = sb_count(scene->controllers);
-            u32 num_extensions = sb_count(scene->extensions);
-
-            // pre update controllers
-            for (u32 c = 0; c < num_controllers; ++c)
-                if (scene->controllers[c].update_func)
-                    scene->controllers[c].update_func(scene->controllers[c], scene, dt);
-
-            if (scene->flags & PAUSE_UPDATE)
+            transform_pass* tp = (transform_pass*)user_data;
+            for (u32 i = start; i < end; ++i)
             {
-                physics::set_paused(1);
+                u32 n = tp->entities[i];
+                if (tp->levels->compose[n])
+                    update_world_state(tp->scene, n);
             }
-            else
+        }
+
+        static void parallel_transformed_bounds(u32 start, u32 end, void* user_data)
+        {
+            transform_pass* tp = (transform_pass*)user_data;
+            const u8* flags = tp->scene->dirty.flags;
+            for (u32 n = start; n < end; ++n)
+                if (flags[n] & DIRTY_BOUNDS)
+                    update_transformed_bounds(tp->scene, n);
+        }
+
+        static void parallel_parent_extents(u32 start, u32 end, void* user_data)
+        {
+            transform_pass* tp = (transform_pass*)user_data;
+            for (u32 i = start; i < end; ++i)
             {
-                physics::set_paused(0);
-                update_animations(scene, dt);
+                u32 p = tp->entities[i];
+                if (!(tp->scene->dirty.flags[p] & DIRTY_BOUNDS))
+                    continue;
+
+                for (u32 c = tp->levels->child_offsets[p]; c < tp->levels->child_offsets[p + 1]; ++c)
+                    expand_parent_extents(tp->scene, p, tp->levels->children[c]);
             }
+        }
 
-            // extension component update
-            for (u32 e = 0; e < num_extensions; ++e)
-                if (scene->extensions[e].update_func)
-                    scene->extensions[e].update_func(scene->extensions[e], scene, dt);
+        static void update_renderable_extents(ecs_scene* scene)
+        {
+            scene->renderable_extents.min = vec3f::flt_max();
+            scene->renderable_extents.max = -vec3f::flt_max();
 
-            static pen::timer* timer = pen::timer_create();
-            pen::timer_start(timer);
+            for (u32 n = 0; n < scene->num_entities; ++n)
+            {
+                if (scene->entities[n] & CMP_BONE || !(scene->entities[n] & CMP_GEOMETRY))
+                    continue;
+
+                const cmp_bounding_volume& bv = scene->bounding_volumes[n];
+                scene->renderable_extents.min = vec3f::vmin(bv.transformed_min_extents, scene->renderable_extents.min);
+                scene->renderable_extents.max = vec3f::vmax(bv.transformed_max_extents, scene->renderable_extents.max);
+            }
+        }
 
-            // scene node transform
+        static void update_transforms(ecs_scene* scene)
+        {
+            // flag and physics command work stays serial so commands are issued in entity order
             for (u32 n = 0; n < scene->num_entities; ++n)
             {
                 // force physics entity to sync and ignore controlled transform
@@ -1123,143 +2292,133 @@ namespace put
                     scene->entities[n] &= ~CMP_TRANSFORM;
                 }
 
-                // controlled transform
-                if (scene->entities[n] & CMP_TRANSFORM)
+                if (!(scene->entities[n] & CMP_TRANSFORM) || !(scene->entities[n] & CMP_PHYSICS))
+                    continue;
+
+                if (scene->physics_data[n].type == PHYSICS_TYPE_RIGID_BODY)
                 {
                     cmp_transform& t = scene->transforms[n];
+                    cmp_transform& pt = scene->physics_offset[n];
+                    physics::set_transform(scene->physics_handles[n], t.translation + pt.translation, t.rotation);
+                    physics::set_v3(scene->physics_handles[n], vec3f::zero(), physics::CMD_SET_ANGULAR_VELOCITY);
+                    physics::set_v3(scene->physics_handles[n], vec3f::zero(), physics::CMD_SET_LINEAR_VELOCITY);
+                }
+            }
 
-                    // generate matrix from transform
-                    mat4 rot_mat;
-                    t.rotation.get_matrix(rot_mat);
-
-                    mat4 translation_mat = mat::create_translation(t.translation);
+            u8 reset_flags = reserve_dirty_state(scene) ? DIRTY_ALL : 0;
 
-                    mat4 scale_mat = mat::create_scale(t.scale);
+            s_rb_output = &physics::get_rb_output();
+            u32 physics_frame = s_rb_output->frame;
 
-                    scene->local_matrices[n] = translation_mat * rot_mat * scale_mat;
+            transform_levels& tl = s_transform_levels;
 
-                    if (scene->entities[n] & CMP_PHYSICS)
+            if (!build_transform_levels(scene, tl))
+            {
+                // parents may come after children here, so world matrices are always composed and compared instead
+                // and all bounds are rebuilt
+                u8* flags = scene->dirty.flags;
+                for (u32 n = 0; n < scene->num_entities; ++n)
+                {
+                    if (update_local_state(scene, n, reset_flags))
                     {
-                        if (scene->physics_data[n].type == PHYSICS_TYPE_RIGID_BODY)
-                        {
-                            cmp_transform& pt = scene->physics_offset[n];
-                            physics::set_transform(scene->physics_handles[n], t.translation + pt.translation, t.rotation);
-                            physics::set_v3(scene->physics_handles[n], vec3f::zero(), physics::CMD_SET_ANGULAR_VELOCITY);
-                            physics::set_v3(scene->physics_handles[n], vec3f::zero(), physics::CMD_SET_LINEAR_VELOCITY);
-                        }
+                        mat4 prev = scene->world_matrices[n];
+                        update_world_matrix(scene, n);
+
+                        if (flags[n] & DIRTY_LOCAL || memcmp(&prev, &scene->world_matrices[n], sizeof(mat4)) != 0)
+                            flags[n] |= DIRTY_WORLD;
                     }
 
-                    // local matrix will be baked
-                    scene->entities[n] &= ~CMP_TRANSFORM;
+                    flags[n] |= DIRTY_BOUNDS;
                 }
-                else if (scene->entities[n] & CMP_PHYSICS)
-                {
-                    if (!physics::has_rb_matrix(n))
-                        continue;
 
-                    cmp_transform& t = scene->transforms[n];
-                    cmp_transform& pt = scene->physics_offset[n];
+                propagate_dirty_bounds(scene);
 
-                    mat4 scale_mat = mat::create_scale(t.scale);
+                for (u32 n = 0; n < scene->num_entities; ++n)
+                    update_transformed_bounds(scene, n);
 
-                    vec3f os = t.scale;
-                    t = physics::get_rb_transform(scene->physics_handles[n]);
-                    t.scale = os;
+                update_renderable_extents(scene);
 
-                    mat4 rot_mat;
-                    t.rotation.get_matrix(rot_mat);
+                // reverse iterate over scene and expand parents extents by children
+                for (s32 n = scene->num_entities - 1; n > 0; --n)
+                {
+                    if (!(scene->entities[n] & CMP_ALLOCATED))
+                        continue;
 
-                    mat4 translation_mat = mat::create_translation(t.translation - pt.translation);
+                    u32 p = scene->parents[n];
+                    if (p == n)
+                        continue;
 
-                    scene->local_matrices[n] = translation_mat * rot_mat * scale_mat;
+                    expand_parent_extents(scene, p, n);
                 }
 
-                // heirarchical scene transform
-                u32 parent = scene->parents[n];
-                if (parent == n)
-                    scene->world_matrices[n] = scene->local_matrices[n];
-                else
-                    scene->world_matrices[n] = scene->world_matrices[parent] * scene->local_matrices[n];
+                scene->dirty.physics_frame = physics_frame;
+                return;
             }
 
-            // bounding volume transform
-            static vec3f corners[] = {vec3f(0.0f, 0.0f, 0.0f),
-
-                                      vec3f(1.0f, 0.0f, 0.0f), vec3f(0.0f, 1.0f, 0.0f), vec3f(0.0f, 0.0f, 1.0f),
-
-                                      vec3f(1.0f, 1.0f, 0.0f), vec3f(0.0f, 1.0f, 1.0f), vec3f(1.0f, 0.0f, 1.0f),
-
-                                      vec3f(1.0f, 1.0f, 1.0f)};
+            transform_pass tp = {scene, &tl, nullptr, reset_flags};
 
-            scene->renderable_extents.min = vec3f::flt_max();
-            scene->renderable_extents.max = -vec3f::flt_max();
+            // local matrices are independent, world matrices go level by level from the roots down
+            pen::parallel_for(scene->num_entities, k_transform_grain, parallel_local_matrices, &tp);
+            scene->dirty.physics_frame = physics_frame;
 
-            // transform extents by transform
-            for (s32 n = 0; n < scene->num_entities; ++n)
+            for (u32 l = 0; l < tl.num_levels; ++l)
             {
-                vec3f min = scene->bounding_volumes[n].min_extents;
-                vec3f max = scene->bounding_volumes[n].max_extents - min;
+                tp.entities = &tl.level_entities[tl.level_offsets[l]];
+                pen::parallel_for(tl.level_offsets[l + 1] - tl.level_offsets[l], k_transform_grain,
+                                  parallel_world_matrices, &tp);
+            }
 
-                vec3f& tmin = scene->bounding_volumes[n].transformed_min_extents;
-                vec3f& tmax = scene->bounding_volumes[n].transformed_max_extents;
+            propagate_dirty_bounds(scene);
 
-                if (scene->entities[n] & CMP_BONE)
-                {
-                    tmin = tmax = scene->world_matrices[n].get_translation();
-                    continue;
-                }
+            pen::parallel_for(scene->num_entities, k_transform_grain, parallel_transformed_bounds, &tp);
 
-                tmax = -vec3f::flt_max();
-                tmin = vec3f::flt_max();
+            update_renderable_extents(scene);
 
-                for (s32 c = 0; c < 8; ++c)
-                {
-                    vec3f p = scene->world_matrices[n].transform_vector(min + max * corners[c]);
+            // expand parents by children from the deepest level up, each parent only writes its own extents
+            for (u32 l = tl.num_levels; l > 0; --l)
+            {
+                tp.entities = &tl.level_entities[tl.level_offsets[l - 1]];
+                pen::parallel_for(tl.level_offsets[l] - tl.level_offsets[l - 1], k_transform_grain,
+                                  parallel_parent_extents, &tp);
+            }
+        }
 
-                    tmax = vec3f::vmax(tmax, p);
-                    tmin = vec3f::vmin(tmin, p);
-                }
+        void update_scene(ecs_scene* scene, f32 dt)
+        {
+            // static anim time to pass into draw calls etc..
+            f32 anim_time = pen::get_time_ms() / 1000.0;
 
-                f32& trad = scene->bounding_volumes[n].radius;
-                trad = mag(tmax - tmin) * 0.5f;
+            u32 num_controllers = sb_count(scene->controllers);
+            u32 num_extensions = sb_count(scene->extensions);
 
-                if (!(scene->entities[n] & CMP_GEOMETRY))
-                    continue;
+            // pre update controllers
+            for (u32 c = 0; c < num_controllers; ++c)
+                if (scene->controllers[c].update_func)
+                    scene->controllers[c].update_func(scene->controllers[c], scene, dt);
 
-                // also set scene extents
-                scene->renderable_extents.min = vec3f::vmin(tmin, scene->renderable_extents.min);
-                scene->renderable_extents.max = vec3f::vmax(tmax, scene->renderable_extents.max);
+            if (scene->flags & PAUSE_UPDATE)
+            {
+                physics::set_paused(1);
             }
-
-            // reverse iterate over scene and expand parents extents by children
-            for (s32 n = scene->num_entities - 1; n > 0; --n)
+            else
             {
-                if (!(scene->entities[n] & CMP_ALLOCATED))
-                    continue;
-
-                u32 p = scene->parents[n];
-                if (p == n)
-                    continue;
+                physics::set_paused(0);
+                update_animations(scene, dt);
+            }
 
-                vec3f& parent_tmin = scene->bounding_volumes[p].transformed_min_extents;
-                vec3f& parent_tmax = scene->bounding_volumes[p].transformed_max_extents;
+            // extension component update
+            for (u32 e = 0; e < num_extensions; ++e)
+                if (scene->extensions[e].update_func)
+                    scene->extensions[e].update_func(scene->extensions[e], scene, dt);
 
-                vec3f& tmin = scene->bounding_volumes[n].transformed_min_extents;
-                vec3f& tmax = scene->bounding_volumes[n].transformed_max_extents;
+            static pen::timer* timer = pen::timer_create();
+            pen::timer_start(timer);
 
-                if (scene->entities[p] & CMP_ANIM_CONTROLLER)
-                {
-                    vec3f pad = vec3f(0.0f);
+            // scene node transform and bounds
+            update_transforms(scene);
 
-                    parent_tmin = vec3f::vmin(parent_tmin, tmin - pad);
-                    parent_tmax = vec3f::vmax(parent_tmax, tmax + pad);
-                }
-                else
-                {
-                    parent_tmin = vec3f::vmin(parent_tmin, tmin);
-                    parent_tmax = vec3f::vmax(parent_tmax, tmax);
-                }
-            }
+            bvh_update(scene);
+            update_cull_volumes(scene);
 
             // Forward light buffer
             static forward_light_buffer light_buffer;
@@ -1538,41 +2697,77 @@ namespace put
                 }
             }
 
-            // update draw call data
+            // update draw call data, only uploaded when it differs from what was last written
+            dirty_state& ds = scene->dirty;
             for (s32 n = 0; n < scene->num_entities; ++n)
             {
-                if (scene->entities[n] & CMP_MATERIAL)
+                // per node material cbuffer, material data is edited in place by the editor and user code
+                const cmp_material& mat = scene->materials[n];
+                if (scene->entities[n] & CMP_MATERIAL && is_valid(mat.material_cbuffer))
                 {
-                    // per node material cbuffer
-                    if (is_valid(scene->materials[n].material_cbuffer))
-                        pen::renderer_update_buffer(scene->materials[n].material_cbuffer, &scene->material_data[n].data[0],
-                                                    scene->materials[n].material_cbuffer_size);
+                    u32 size = min(mat.material_cbuffer_size, (u32)sizeof(cmp_material_data));
+                    if (memcmp(&ds.material_data[n], &scene->material_data[n], size) != 0)
+                    {
+                        memcpy(&ds.material_data[n], &scene->material_data[n], size);
+                        ds.flags[n] |= DIRTY_MATERIAL;
+                    }
+
+                    if (ds.flags[n] & DIRTY_MATERIAL || ds.material_cbuffers[n] != mat.material_cbuffer)
+                    {
+                        ds.material_cbuffers[n] = mat.material_cbuffer;
+                        ++ds.stats.material_cbuffer_updates;
+
+                        pen::renderer_update_buffer(mat.material_cbuffer, &scene->material_data[n].data[0],
+                                                    mat.material_cbuffer_size);
+                    }
                 }
 
-                scene->draw_call_data[n].world_matrix = scene->world_matrices[n];
+                cmp_draw_call& dc = scene->draw_call_data[n];
+
+                dc.world_matrix = scene->world_matrices[n];
 
                 // store node index in v1.x
-                scene->draw_call_data[n].v1.x = (f32)n;
+                dc.v1.x = (f32)n;
 
-                if (is_invalid_or_null(scene->cbuffer[n]))
-                    continue;
+                dc.position_offset = scene->geometries[n].position_offset;
+                dc.position_scale = scene->geometries[n].position_scale;
 
-                if (scene->entities[n] & CMP_SUB_INSTANCE)
-                    continue;
+                bool cbuffer = !is_invalid_or_null(scene->cbuffer[n]) && !(scene->entities[n] & CMP_SUB_INSTANCE);
+
+                if (cbuffer)
+                {
+                    // skinned meshes have the world matrix baked into the bones
+                    if (scene->entities[n] & CMP_SKINNED || scene->entities[n] & CMP_PRE_SKINNED)
+                        dc.world_matrix = mat4::create_identity();
+
+                    if (ds.flags[n] & DIRTY_WORLD)
+                    {
+                        mat4 invt = scene->world_matrices[n];
+
+                        invt = invt.transposed();
+                        invt = mat::inverse4x4(invt);
 
-                // skinned meshes have the world matrix baked into the bones
-                if (scene->entities[n] & CMP_SKINNED || scene->entities[n] & CMP_PRE_SKINNED)
-                    scene->draw_call_data[n].world_matrix = mat4::create_identity();
+                        dc.world_matrix_inv_transpose = invt;
+                    }
+                }
+
+                // v1 and v2 may also be written by user code
+                if (memcmp(&ds.draw_call_data[n], &dc, sizeof(cmp_draw_call)) != 0)
+                {
+                    ds.draw_call_data[n] = dc;
+                    ds.flags[n] |= DIRTY_DRAW_CALL;
+                }
 
-                mat4 invt = scene->world_matrices[n];
+                if (!cbuffer)
+                    continue;
 
-                invt = invt.transposed();
-                invt = mat::inverse4x4(invt);
+                if (!(ds.flags[n] & DIRTY_DRAW_CALL) && ds.cbuffers[n] == scene->cbuffer[n])
+                    continue;
 
-                scene->draw_call_data[n].world_matrix_inv_transpose = invt;
+                ds.cbuffers[n] = scene->cbuffer[n];
+                ++ds.stats.cbuffer_updates;
 
-                // todo mark dirty?
-                pen::renderer_update_buffer(scene->cbuffer[n], &scene->draw_call_data[n], sizeof(cmp_draw_call));
+                pen::renderer_update_buffer(scene->cbuffer[n], &dc, sizeof(cmp_draw_call));
             }
 
             // update instance buffers
@@ -1583,48 +2778,230 @@ namespace put
 
                 cmp_master_instance& master = scene->master_instances[n];
 
+                bool dirty = ds.instance_buffers[n] != master.instance_buffer;
+                for (u32 i = 1; i <= master.num_instances && !dirty; ++i)
+                    dirty = ds.flags[n + i] & DIRTY_DRAW_CALL;
+
+                if (!dirty)
+                {
+                    n += master.num_instances;
+                    continue;
+                }
+
+                ds.instance_buffers[n] = master.instance_buffer;
+                ++ds.stats.instance_buffer_updates;
+
                 u32 instance_data_size = master.num_instances * master.instance_stride;
                 pen::renderer_update_buffer(master.instance_buffer, &scene->draw_call_data[n + 1], instance_data_size);
 
-                // stride over sub instances
-                n += scene->master_instances[n].num_instances;
-            }
+                // stride over sub instances
+                n += scene->master_instances[n].num_instances;
+            }
+
+            // update physics running 1 frame behind to allow the sets to take effect
+            physics::step(dt);
+            physics::physics_consume_command_buffer();
+
+            // controllers post update
+            for (u32 c = 0; c < num_controllers; ++c)
+                if (scene->controllers[c].post_update_func)
+                    scene->controllers[c].post_update_func(scene->controllers[c], scene, dt);
+        }
+
+        // version 10 aligns the component arrays and stores the string table as offsets into one block of chars,
+        // body references to strings are string table indices instead of hashes
+        static const u32 k_scene_data_alignment = 16;
+
+        struct scene_header
+        {
+            s32 header_size = sizeof(*this);
+            s32 version = ecs_scene::k_version;
+            u32 num_nodes = 0;
+            s32 num_components = 0;
+            s32 num_lookup_strings = 0;
+            s32 num_extensions = 0;
+            s32 num_base_components = 0;
+            u32 string_data_size = 0; // version 10
+            u32 data_alignment = 0;   // version 10
+            s32 reserved_1[23] = {0};
+            u32 view_flags = 0;
+            s32 selected_index = 0;
+            s32 reserved_2[30] = {0};
+        };
+
+        struct scene_writer
+        {
+            u8* data = nullptr;
+        };
+
+        struct scene_reader
+        {
+            const u8* data = nullptr;
+            u32       size = 0;
+            u32       pos = 0;
+            s32       version = 0;
+        };
+
+        void scene_write(scene_writer& sw, const void* src, u32 size)
+        {
+            if (size == 0)
+                return;
+
+            memcpy(sb_add(sw.data, size), src, size);
+        }
+
+        void scene_align(scene_writer& sw, u32 alignment)
+        {
+            u32 pad = (alignment - (sb_count(sw.data) % alignment)) % alignment;
+            if (pad)
+                memset(sb_add(sw.data, pad), 0x0, pad);
+        }
+
+        void scene_read(scene_reader& sr, void* dst, u32 size)
+        {
+            if (size > sr.size - sr.pos)
+            {
+                // truncated file, zero what is missing
+                memset(dst, 0x0, size);
+                sr.pos = sr.size;
+                return;
+            }
+
+            memcpy(dst, sr.data + sr.pos, size);
+            sr.pos += size;
+        }
+
+        void scene_skip(scene_reader& sr, u32 size)
+        {
+            sr.pos += min(size, sr.size - sr.pos);
+        }
+
+        void scene_align(scene_reader& sr, u32 alignment)
+        {
+            if (alignment == 0)
+                return;
+
+            scene_skip(sr, (alignment - (sr.pos % alignment)) % alignment);
+        }
+
+        Str read_parsable_string(scene_reader& sr)
+        {
+            u32 len = 0;
+            scene_read(sr, &len, sizeof(u32));
+
+            len = min(len, sr.size - sr.pos);
+
+            Str name;
+            for (u32 i = 0; i < len; ++i)
+                name.append((c8)sr.data[sr.pos + i]);
+
+            sr.pos += len;
+            return name;
+        }
+
+        struct lookup_string
+        {
+            hash_id id;
+            u32     offset; // into s_lookup_string_data, null terminated
+        };
+        static lookup_string* s_lookup_strings = nullptr;
+        static c8*            s_lookup_string_data = nullptr;
+        static u32*           s_lookup_string_slots = nullptr; // open addressed on id, string index + 1
+        static u32            s_lookup_string_capacity = 0;
+
+        void clear_lookup_strings()
+        {
+            sb_free(s_lookup_strings);
+            sb_free(s_lookup_string_data);
+            pen::memory_free(s_lookup_string_slots);
+
+            s_lookup_strings = nullptr;
+            s_lookup_string_data = nullptr;
+            s_lookup_string_slots = nullptr;
+            s_lookup_string_capacity = 0;
+        }
+
+        u32 find_lookup_string(hash_id id)
+        {
+            if (s_lookup_string_capacity == 0)
+                return PEN_INVALID_HANDLE;
+
+            u32 mask = s_lookup_string_capacity - 1;
+            for (u32 i = id & mask;; i = (i + 1) & mask)
+            {
+                u32 slot = s_lookup_string_slots[i];
+                if (slot == 0)
+                    return PEN_INVALID_HANDLE;
+
+                if (s_lookup_strings[slot - 1].id == id)
+                    return slot - 1;
+            }
+        }
+
+        void insert_lookup_string_slot(u32 index)
+        {
+            u32 mask = s_lookup_string_capacity - 1;
+            u32 i = s_lookup_strings[index].id & mask;
+            while (s_lookup_string_slots[i])
+                i = (i + 1) & mask;
+
+            s_lookup_string_slots[i] = index + 1;
+        }
+
+        void reserve_lookup_strings(u32 count)
+        {
+            // keep the table at most half full
+            if (count * 2 <= s_lookup_string_capacity)
+                return;
+
+            u32 capacity = max(s_lookup_string_capacity, (u32)64);
+            while (capacity < count * 2)
+                capacity *= 2;
+
+            pen::memory_free(s_lookup_string_slots);
+            s_lookup_string_slots = (u32*)pen::memory_alloc(capacity * sizeof(u32));
+            memset(s_lookup_string_slots, 0x0, capacity * sizeof(u32));
+            s_lookup_string_capacity = capacity;
+
+            u32 num_strings = sb_count(s_lookup_strings);
+            for (u32 i = 0; i < num_strings; ++i)
+                insert_lookup_string_slot(i);
+        }
+
+        u32 add_lookup_string(const c8* string, hash_id id)
+        {
+            u32 index = find_lookup_string(id);
+            if (index != PEN_INVALID_HANDLE)
+                return index;
+
+            index = sb_count(s_lookup_strings);
+            reserve_lookup_strings(index + 1);
+
+            u32 len = pen::string_length(string) + 1;
 
-            // update physics running 1 frame behind to allow the sets to take effect
-            physics::step();
-            physics::physics_consume_command_buffer();
+            lookup_string ls = {id, (u32)sb_count(s_lookup_string_data)};
+            memcpy(sb_add(s_lookup_string_data, len), string, len);
+            sb_push(s_lookup_strings, ls);
 
-            // controllers post update
-            for (u32 c = 0; c < num_controllers; ++c)
-                if (scene->controllers[c].post_update_func)
-                    scene->controllers[c].post_update_func(scene->controllers[c], scene, dt);
+            insert_lookup_string_slot(index);
+            return index;
         }
 
-        struct scene_header
+        const c8* lookup_string_name(u32 index)
         {
-            s32 header_size = sizeof(*this);
-            s32 version = ecs_scene::k_version;
-            u32 num_nodes = 0;
-            s32 num_components = 0;
-            s32 num_lookup_strings = 0;
-            s32 num_extensions = 0;
-            s32 num_base_components = 0;
-            s32 reserved_1[25] = {0};
-            u32 view_flags = 0;
-            s32 selected_index = 0;
-            s32 reserved_2[30] = {0};
-        };
+            if (index >= sb_count(s_lookup_strings))
+                return "";
 
-        struct lookup_string
-        {
-            Str     name;
-            hash_id id;
-        };
-        static lookup_string* s_lookup_strings = nullptr;
+            u32 offset = s_lookup_strings[index].offset;
+            if (offset >= sb_count(s_lookup_string_data))
+                return "";
+
+            return &s_lookup_string_data[offset];
+        }
 
-        void write_lookup_string(const char* string, std::ofstream& ofs, const c8* strip_project_dir = nullptr)
+        void write_lookup_string(const char* string, scene_writer& sw, const c8* strip_project_dir = nullptr)
         {
-            hash_id id = 0;
+            u32 index = PEN_INVALID_HANDLE;
 
             Str stripped = string;
             if (strip_project_dir)
@@ -1633,57 +3010,39 @@ namespace put
                 string = stripped.c_str();
             }
 
-            if (!string)
-            {
-                ofs.write((const c8*)&id, sizeof(hash_id));
-                return;
-            }
-
-            id = PEN_HASH(string);
-            ofs.write((const c8*)&id, sizeof(hash_id));
-
-            u32 num_strings = sb_count(s_lookup_strings);
-            for (u32 i = 0; i < num_strings; ++i)
-            {
-                if (id == s_lookup_strings[i].id)
-                {
-                    return;
-                }
-            }
+            if (string)
+                index = add_lookup_string(string, PEN_HASH(string));
 
-            lookup_string ls = {string, id};
-            sb_push(s_lookup_strings, ls);
+            scene_write(sw, &index, sizeof(u32));
         }
 
-        Str read_lookup_string(std::ifstream& ifs)
+        u32 read_lookup_string_index(scene_reader& sr)
         {
-            hash_id id;
-            ifs.read((c8*)&id, sizeof(hash_id));
+            u32 ref = PEN_INVALID_HANDLE;
+            scene_read(sr, &ref, sizeof(u32));
 
-            u32 num_strings = sb_count(s_lookup_strings);
-            for (u32 i = 0; i < num_strings; ++i)
-            {
-                if (s_lookup_strings[i].id == id)
-                {
-                    return s_lookup_strings[i].name;
-                }
-            }
+            // version 9 and earlier reference strings by hash
+            if (sr.version < 10)
+                return find_lookup_string(ref);
 
-            return "";
+            return ref;
         }
 
-        hash_id rehash_lookup_string(hash_id id)
+        Str read_lookup_string(scene_reader& sr)
         {
-            u32 num_strings = sb_count(s_lookup_strings);
-            for (u32 i = 0; i < num_strings; ++i)
-            {
-                if (s_lookup_strings[i].id == id)
-                {
-                    return PEN_HASH(s_lookup_strings[i].name);
-                }
-            }
+            return lookup_string_name(read_lookup_string_index(sr));
+        }
+
+        hash_id rehash_lookup_string(scene_reader& sr, u32 ref)
+        {
+            u32 index = ref;
+            if (sr.version < 10)
+                index = find_lookup_string(ref);
+
+            if (index >= sb_count(s_lookup_strings))
+                return 0;
 
-            return 0;
+            return PEN_HASH(lookup_string_name(index));
         }
 
         void save_sub_scene(ecs_scene* scene, u32 root)
@@ -1735,16 +3094,30 @@ namespace put
         {
             Str project_dir = dev_ui::get_program_preference_filename("project_dir", pen_user_info.working_directory);
 
-            std::ofstream ofs(filename, std::ofstream::binary);
+            clear_lookup_strings();
 
-            sb_free(s_lookup_strings);
-            s_lookup_strings = nullptr;
+            // body is built first, the header and string table are only complete once it is written
+            scene_writer body;
 
-            // write basic components
+            // write basic components, each array starts aligned so it can be copied straight into the soa
             for (u32 i = 0; i < scene->num_components; ++i)
             {
                 generic_cmp_array& cmp = scene->get_component_array(i);
-                ofs.write((const c8*)cmp.data, cmp.size * scene->num_entities);
+                u32                array_size = cmp.size * scene->num_entities;
+
+                // names go through the string table, the raw Str is only a heap pointer
+                if (cmp.data == scene->names.data || cmp.data == scene->geometry_names.data ||
+                    cmp.data == scene->material_names.data)
+                {
+                    if (array_size)
+                        memset(sb_add(body.data, array_size), 0x0, array_size);
+                }
+                else
+                {
+                    scene_write(body, cmp.data, array_size);
+                }
+
+                scene_align(body, k_scene_data_alignment);
             }
 
             // specialisations ------------------------------------------------------------------------------
@@ -1752,9 +3125,9 @@ namespace put
             // names
             for (s32 n = 0; n < scene->num_entities; ++n)
             {
-                write_lookup_string(scene->names[n].c_str(), ofs);
-                write_lookup_string(scene->geometry_names[n].c_str(), ofs);
-                write_lookup_string(scene->material_names[n].c_str(), ofs);
+                write_lookup_string(scene->names[n].c_str(), body);
+                write_lookup_string(scene->geometry_names[n].c_str(), body);
+                write_lookup_string(scene->material_names[n].c_str(), body);
             }
 
             // geometry
@@ -1765,10 +3138,10 @@ namespace put
 
                 geometry_resource* gr = get_geometry_resource(scene->id_geometry[n]);
 
-                ofs.write((const c8*)&gr->submesh_index, sizeof(u32));
+                scene_write(body, &gr->submesh_index, sizeof(u32));
 
-                write_lookup_string(gr->filename.c_str(), ofs, project_dir.c_str());
-                write_lookup_string(gr->geometry_name.c_str(), ofs, project_dir.c_str());
+                write_lookup_string(gr->filename.c_str(), body, project_dir.c_str());
+                write_lookup_string(gr->geometry_name.c_str(), body, project_dir.c_str());
             }
 
             // animations
@@ -1779,12 +3152,12 @@ namespace put
                 if (scene->anim_controller[n].handles)
                     size = sb_count(scene->anim_controller[n].handles);
 
-                ofs.write((const c8*)&size, sizeof(s32));
+                scene_write(body, &size, sizeof(s32));
 
                 for (s32 i = 0; i < size; ++i)
                 {
                     auto* anim = get_animation_resource(scene->anim_controller[n].handles[i]);
-                    write_lookup_string(anim->name.c_str(), ofs, project_dir.c_str());
+                    write_lookup_string(anim->name.c_str(), body, project_dir.c_str());
                 }
             }
 
@@ -1800,9 +3173,9 @@ namespace put
                 const char* shader_name = pmfx::get_shader_name(mat.shader);
                 const char* technique_name = pmfx::get_technique_name(mat.shader, mat_res.id_technique);
 
-                write_lookup_string(mat_res.material_name.c_str(), ofs);
-                write_lookup_string(shader_name, ofs);
-                write_lookup_string(technique_name, ofs);
+                write_lookup_string(mat_res.material_name.c_str(), body);
+                write_lookup_string(shader_name, body);
+                write_lookup_string(technique_name, body);
             }
 
             // shadow
@@ -1813,7 +3186,7 @@ namespace put
 
                 cmp_shadow& shadow = scene->shadows[n];
 
-                write_lookup_string(put::get_texture_filename(shadow.texture_handle).c_str(), ofs, project_dir.c_str());
+                write_lookup_string(put::get_texture_filename(shadow.texture_handle).c_str(), body, project_dir.c_str());
             }
 
             // sampler bindings
@@ -1826,95 +3199,83 @@ namespace put
 
                 for (u32 i = 0; i < MAX_TECHNIQUE_SAMPLER_BINDINGS; ++i)
                 {
-                    write_lookup_string(put::get_texture_filename(samplers.sb[i].handle).c_str(), ofs, project_dir.c_str());
-                    write_lookup_string(pmfx::get_render_state_name(samplers.sb[i].sampler_state).c_str(), ofs,
+                    write_lookup_string(put::get_texture_filename(samplers.sb[i].handle).c_str(), body, project_dir.c_str());
+                    write_lookup_string(pmfx::get_render_state_name(samplers.sb[i].sampler_state).c_str(), body,
                                         project_dir.c_str());
                 }
             }
 
-            // cameras
-            camera** cams = pmfx::get_cameras();
-            u32      num_cams = sb_count(cams);
-            for (u32 i = 0; i < num_cams; ++i)
-            {
-                write_lookup_string(cams[i]->name.c_str(), ofs);
-            }
-
             // call extensions specific save
             u32 num_extensions = sb_count(scene->extensions);
             for (u32 i = 0; i < num_extensions; ++i)
                 if (scene->extensions[i].save_func)
                     scene->extensions[i].save_func(scene->extensions[i], scene);
 
-            ofs.close();
-
-            std::ifstream infile(filename, std::ifstream::binary);
-
-            // get size of file
-            infile.seekg(0, infile.end);
-            u32 scene_data_size = infile.tellg();
-            infile.seekg(0);
-
-            // allocate memory for file content
-            c8* scene_data = new c8[scene_data_size];
-
-            // read content of infile
-            infile.read(scene_data, scene_data_size);
-
-            ofs = std::ofstream(filename, std::ofstream::binary);
+            scene_writer head;
 
-            // header
+            // header, patched once the string table is complete
             scene_header sh;
             sh.num_nodes = scene->num_entities;
             sh.view_flags = scene->view_flags;
             sh.selected_index = scene->selected_index;
             sh.num_components = scene->num_components;
             sh.num_base_components = scene->num_base_components;
-            sh.num_lookup_strings = sb_count(s_lookup_strings);
-            sh.num_extensions = sb_count(scene->extensions);
-            ofs.write((const c8*)&sh, sizeof(scene_header));
+            sh.num_extensions = num_extensions;
+            sh.data_alignment = k_scene_data_alignment;
+            scene_write(head, &sh, sizeof(scene_header));
 
             // component sizes
             for (u32 c = 0; c < sh.num_components; ++c)
             {
-                ofs.write((const c8*)&scene->get_component_array(c).size, sizeof(u32));
+                scene_write(head, &scene->get_component_array(c).size, sizeof(u32));
             }
 
             // extensions
             for (u32 i = 0; i < sh.num_extensions; ++i)
             {
                 u32 co = get_extension_component_offset(scene, i);
-                write_lookup_string(scene->extensions[i].name.c_str(), ofs);
-                ofs.write((const c8*)&co, sizeof(u32));
-                ofs.write((const c8*)&scene->extensions[i].num_components, sizeof(u32));
+                write_lookup_string(scene->extensions[i].name.c_str(), head);
+                scene_write(head, &co, sizeof(u32));
+                scene_write(head, &scene->extensions[i].num_components, sizeof(u32));
             }
 
+            sh.num_lookup_strings = sb_count(s_lookup_strings);
+            sh.string_data_size = sb_count(s_lookup_string_data);
+            memcpy(head.data, &sh, sizeof(scene_header));
+
             // string lookups
-            for (u32 l = 0; l < sh.num_lookup_strings; ++l)
-            {
-                write_parsable_string(s_lookup_strings[l].name.c_str(), ofs);
-                ofs.write((const c8*)&s_lookup_strings[l].id, sizeof(hash_id));
-            }
+            scene_write(head, s_lookup_strings, sh.num_lookup_strings * sizeof(lookup_string));
+            scene_write(head, s_lookup_string_data, sh.string_data_size);
 
             // write camera info
-            ofs.write((const c8*)&num_cams, sizeof(u32));
+            camera** cams = pmfx::get_cameras();
+            u32      num_cams = sb_count(cams);
+
+            scene_write(head, &num_cams, sizeof(u32));
             for (u32 i = 0; i < num_cams; ++i)
             {
                 hash_id id_cam = PEN_HASH(cams[i]->name);
-                ofs.write((const c8*)&id_cam, sizeof(hash_id));
-                ofs.write((const c8*)&cams[i]->pos, sizeof(vec3f));
-                ofs.write((const c8*)&cams[i]->focus, sizeof(vec3f));
-                ofs.write((const c8*)&cams[i]->rot, sizeof(vec2f));
-                ofs.write((const c8*)&cams[i]->fov, sizeof(f32));
-                ofs.write((const c8*)&cams[i]->aspect, sizeof(f32));
-                ofs.write((const c8*)&cams[i]->near_plane, sizeof(f32));
-                ofs.write((const c8*)&cams[i]->far_plane, sizeof(f32));
-                ofs.write((const c8*)&cams[i]->zoom, sizeof(f32));
+                scene_write(head, &id_cam, sizeof(hash_id));
+                scene_write(head, &cams[i]->pos, sizeof(vec3f));
+                scene_write(head, &cams[i]->focus, sizeof(vec3f));
+                scene_write(head, &cams[i]->rot, sizeof(vec2f));
+                scene_write(head, &cams[i]->fov, sizeof(f32));
+                scene_write(head, &cams[i]->aspect, sizeof(f32));
+                scene_write(head, &cams[i]->near_plane, sizeof(f32));
+                scene_write(head, &cams[i]->far_plane, sizeof(f32));
+                scene_write(head, &cams[i]->zoom, sizeof(f32));
             }
 
+            scene_align(head, k_scene_data_alignment);
+
             // write scene data
-            ofs.write(scene_data, scene_data_size);
+            std::ofstream ofs(filename, std::ofstream::binary);
+            ofs.write((const c8*)head.data, sb_count(head.data));
+            ofs.write((const c8*)body.data, sb_count(body.data));
             ofs.close();
+
+            sb_free(head.data);
+            sb_free(body.data);
         }
 
         void load_scene(const c8* filename, ecs_scene* scene, bool merge)
@@ -1923,11 +3284,26 @@ namespace put
             bool error = false;
             Str  project_dir = dev_ui::get_program_preference_filename("project_dir", pen_user_info.working_directory);
 
-            std::ifstream ifs(filename, std::ofstream::binary);
+            // whole file is read in one go and parsed from memory
+            void* scene_file = nullptr;
+            u32   scene_file_size = 0;
+
+            pen_error err = pen::filesystem_read_file_to_buffer(filename, &scene_file, scene_file_size);
+            if (err != PEN_ERR_OK || scene_file_size < sizeof(scene_header))
+            {
+                dev_ui::log_level(dev_ui::CONSOLE_ERROR, "[error] load scene - failed to find file: %s", filename);
+                pen::memory_free(scene_file);
+                return;
+            }
+
+            scene_reader sr;
+            sr.data = (const u8*)scene_file;
+            sr.size = scene_file_size;
 
             // header
             scene_header sh;
-            ifs.read((c8*)&sh, sizeof(scene_header));
+            scene_read(sr, &sh, sizeof(scene_header));
+            sr.version = sh.version;
 
             if (!merge)
             {
@@ -1939,6 +3315,10 @@ namespace put
             if (sh.version < 9)
                 sh.num_base_components = sh.num_components;
 
+            // version 10 adds alignment
+            if (sh.version < 10)
+                sh.data_alignment = 0;
+
             // unpack header
             s32 num_nodes = sh.num_nodes;
 
@@ -1968,7 +3348,7 @@ namespace put
             for (u32 i = 0; i < sh.num_components; ++i)
             {
                 u32 size;
-                ifs.read((c8*)&size, sizeof(u32));
+                scene_read(sr, &size, sizeof(u32));
                 sb_push(component_sizes, size);
             }
 
@@ -1984,50 +3364,64 @@ namespace put
             for (u32 i = 0; i < sh.num_extensions; ++i)
             {
                 ext_components ext;
-                ifs.read((c8*)&ext.id, sizeof(hash_id));
-                ifs.read((c8*)&ext.start_cmp, sizeof(u32));
-                ifs.read((c8*)&ext.num_cmp, sizeof(u32));
+                scene_read(sr, &ext.id, sizeof(hash_id));
+                scene_read(sr, &ext.start_cmp, sizeof(u32));
+                scene_read(sr, &ext.num_cmp, sizeof(u32));
 
                 sb_push(exts, ext);
             }
 
             // read string lookups
-            sb_free(s_lookup_strings);
-            s_lookup_strings = nullptr;
+            clear_lookup_strings();
 
-            for (u32 n = 0; n < sh.num_lookup_strings; ++n)
+            if (sh.version >= 10)
+            {
+                u32 table_size = sh.num_lookup_strings * sizeof(lookup_string);
+                if (table_size)
+                    scene_read(sr, sb_add(s_lookup_strings, sh.num_lookup_strings), table_size);
+
+                if (sh.string_data_size)
+                {
+                    scene_read(sr, sb_add(s_lookup_string_data, sh.string_data_size), sh.string_data_size);
+                    s_lookup_string_data[sh.string_data_size - 1] = '\0';
+                }
+            }
+            else
             {
-                lookup_string ls;
-                ls.name = read_parsable_string(ifs);
-                ifs.read((c8*)&ls.id, sizeof(hash_id));
+                for (u32 n = 0; n < sh.num_lookup_strings; ++n)
+                {
+                    Str     name = read_parsable_string(sr);
+                    hash_id id;
+                    scene_read(sr, &id, sizeof(hash_id));
 
-                sb_push(s_lookup_strings, ls);
+                    add_lookup_string(name.c_str(), id);
+                }
             }
 
             // rehash extension ids
             for (u32 i = 0; i < sh.num_extensions; ++i)
             {
-                exts[i].id = rehash_lookup_string(exts[i].id);
+                exts[i].id = rehash_lookup_string(sr, exts[i].id);
             }
 
             // read cameras
             u32 num_cams;
-            ifs.read((c8*)&num_cams, sizeof(u32));
+            scene_read(sr, &num_cams, sizeof(u32));
 
             for (u32 i = 0; i < num_cams; ++i)
             {
                 camera  cam;
                 hash_id id_cam;
 
-                ifs.read((c8*)&id_cam, sizeof(hash_id));
-                ifs.read((c8*)&cam.pos, sizeof(vec3f));
-                ifs.read((c8*)&cam.focus, sizeof(vec3f));
-                ifs.read((c8*)&cam.rot, sizeof(vec2f));
-                ifs.read((c8*)&cam.fov, sizeof(f32));
-                ifs.read((c8*)&cam.aspect, sizeof(f32));
-                ifs.read((c8*)&cam.near_plane, sizeof(f32));
-                ifs.read((c8*)&cam.far_plane, sizeof(f32));
-                ifs.read((c8*)&cam.zoom, sizeof(f32));
+                scene_read(sr, &id_cam, sizeof(hash_id));
+                scene_read(sr, &cam.pos, sizeof(vec3f));
+                scene_read(sr, &cam.focus, sizeof(vec3f));
+                scene_read(sr, &cam.rot, sizeof(vec2f));
+                scene_read(sr, &cam.fov, sizeof(f32));
+                scene_read(sr, &cam.aspect, sizeof(f32));
+                scene_read(sr, &cam.near_plane, sizeof(f32));
+                scene_read(sr, &cam.far_plane, sizeof(f32));
+                scene_read(sr, &cam.zoom, sizeof(f32));
 
                 // find camera and set
                 camera* _cam = pmfx::get_camera(id_cam);
@@ -2044,6 +3438,8 @@ namespace put
                 }
             }
 
+            scene_align(sr, sh.data_alignment);
+
             // read all components
             for (u32 i = 0; i < sh.num_components; ++i)
             {
@@ -2076,22 +3472,18 @@ namespace put
                     {
                         // read whole array
                         c8* data_offset = (c8*)cmp.data + zero_offset * cmp.size;
-                        ifs.read(data_offset, cmp.size * num_nodes);
+                        scene_read(sr, data_offset, cmp.size * num_nodes);
                         read = true;
                     }
                 }
 
                 if (!read)
                 {
-                    // read the old size
-                    u32 array_size = component_sizes[i] * num_nodes;
-                    c8* old = (c8*)pen::memory_alloc(array_size);
-                    ifs.read(old, array_size);
-
-                    // here any fuxup can be applied old into cmp.data
-
-                    pen::memory_free(old);
+                    // the old array is in place at sr.data + sr.pos, here any fuxup can be applied old into cmp.data
+                    scene_skip(sr, component_sizes[i] * num_nodes);
                 }
+
+                scene_align(sr, sh.data_alignment);
             }
 
             // fixup parents for scene import / merge
@@ -2105,106 +3497,59 @@ namespace put
                 memset(&scene->geometry_names[n], 0x0, sizeof(Str));
                 memset(&scene->material_names[n], 0x0, sizeof(Str));
 
-                scene->names[n] = read_lookup_string(ifs);
-                scene->geometry_names[n] = read_lookup_string(ifs);
-                scene->material_names[n] = read_lookup_string(ifs);
+                scene->names[n] = read_lookup_string(sr);
+                scene->geometry_names[n] = read_lookup_string(sr);
+                scene->material_names[n] = read_lookup_string(sr);
             }
 
-            // geometry
-            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
-            {
-                if (scene->entities[n] & CMP_GEOMETRY)
-                {
-                    u32 submesh;
-                    ifs.read((c8*)&submesh, sizeof(u32));
-
-                    Str filename = project_dir;
-                    Str name = read_lookup_string(ifs).c_str();
-                    Str geometry_name = read_lookup_string(ifs);
-
-                    hash_id        name_hash = PEN_HASH(name.c_str());
-                    static hash_id primitive_id = PEN_HASH("primitive");
-
-                    filename.append(name.c_str());
-
-                    geometry_resource* gr = nullptr;
+            // references are read up front and resolved once per unique resource, string indices are unique so a
+            // single table of handles serves pmm, pma and texture files without aliasing
+            u32  num_strings = sb_count(s_lookup_strings);
+            u32* resource_handles = nullptr;
+            if (num_strings)
+                memset(sb_add(resource_handles, num_strings), 0xff, num_strings * sizeof(u32));
 
-                    if (name_hash != primitive_id)
-                    {
-                        dev_console_log("[scene load] %s", name.c_str());
-                        load_pmm(filename.c_str(), nullptr, PMM_GEOMETRY);
-
-                        pen::hash_murmur hm;
-                        hm.begin(0);
-                        hm.add(filename.c_str(), filename.length());
-                        hm.add(geometry_name.c_str(), geometry_name.length());
-                        hm.add(submesh);
-                        hash_id geom_hash = hm.end();
-
-                        gr = get_geometry_resource(geom_hash);
-
-                        scene->id_geometry[n] = geom_hash;
-                    }
-                    else
-                    {
-                        hash_id geom_hash = PEN_HASH(geometry_name.c_str());
-                        gr = get_geometry_resource(geom_hash);
-                    }
+            struct geometry_ref
+            {
+                u32 node;
+                u32 submesh;
+                u32 file;
+                u32 name;
+            };
+            geometry_ref* geometry_refs = nullptr;
 
-                    if (gr)
-                    {
-                        instantiate_geometry(gr, scene, n);
-                        instantiate_model_cbuffer(scene, n);
+            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
+            {
+                if (!(scene->entities[n] & CMP_GEOMETRY))
+                    continue;
 
-                        if (gr->p_skin)
-                            instantiate_anim_controller(scene, n);
-                    }
-                    else
-                    {
-                        dev_ui::log_level(dev_ui::CONSOLE_ERROR, "[error] geometry - cannot find pmm file: %s",
-                                          filename.c_str());
+                geometry_ref ref;
+                ref.node = n;
+                scene_read(sr, &ref.submesh, sizeof(u32));
+                ref.file = read_lookup_string_index(sr);
+                ref.name = read_lookup_string_index(sr);
 
-                        scene->entities[n] &= ~CMP_GEOMETRY;
-                        error = true;
-                    }
-                }
+                sb_push(geometry_refs, ref);
             }
 
-            // instantiate physics
-            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
-                if (scene->entities[n] & CMP_PHYSICS)
-                    instantiate_rigid_body(scene, n);
-
-            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
-                if (scene->entities[n] & CMP_CONSTRAINT)
-                    instantiate_constraint(scene, n);
+            struct anim_ref
+            {
+                u32 node;
+                u32 name;
+            };
+            anim_ref* anim_refs = nullptr;
 
-            // animations
             for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
             {
                 s32 size;
-                ifs.read((c8*)&size, sizeof(s32));
+                scene_read(sr, &size, sizeof(s32));
                 scene->anim_controller[n].handles = nullptr;
 
                 for (s32 i = 0; i < size; ++i)
                 {
-                    Str anim_name = project_dir;
-                    anim_name.append(read_lookup_string(ifs).c_str());
-
-                    anim_handle h = load_pma(anim_name.c_str());
-
-                    if (!is_valid(h))
-                    {
-                        dev_ui::log_level(dev_ui::CONSOLE_ERROR, "[error] animation - cannot find pma file: %s",
-                                          anim_name.c_str());
-                        error = true;
-                    }
-
-                    bind_animation_to_rig(scene, h, n);
+                    anim_ref ref = {(u32)n, read_lookup_string_index(sr)};
+                    sb_push(anim_refs, ref);
                 }
-
-                if (scene->anim_controller[n].current_animation > sb_count(scene->anim_controller[n].handles))
-                    scene->anim_controller[n].current_animation = PEN_INVALID_HANDLE;
             }
 
             // materials
@@ -2221,30 +3566,34 @@ namespace put
                 memset(&mat_res.shader_name, 0x0, sizeof(Str));
                 mat.material_cbuffer = PEN_INVALID_HANDLE;
 
-                Str material_name = read_lookup_string(ifs);
-                Str shader = read_lookup_string(ifs);
-                Str technique = read_lookup_string(ifs);
+                const c8* material_name = lookup_string_name(read_lookup_string_index(sr));
+                const c8* shader = lookup_string_name(read_lookup_string_index(sr));
+                const c8* technique = lookup_string_name(read_lookup_string_index(sr));
 
                 mat_res.material_name = material_name;
-                mat_res.id_shader = PEN_HASH(shader.c_str());
-                mat_res.id_technique = PEN_HASH(technique.c_str());
+                mat_res.id_shader = PEN_HASH(shader);
+                mat_res.id_technique = PEN_HASH(technique);
                 mat_res.shader_name = shader;
             }
 
-            // sdf shadow
+            struct shadow_ref
+            {
+                u32 node;
+                u32 file;
+            };
+            shadow_ref* shadow_refs = nullptr;
+
             for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
             {
                 if (!(scene->entities[n] & CMP_SDF_SHADOW))
                     continue;
 
-                Str sdf_shadow_volume_file = read_lookup_string(ifs);
-                sdf_shadow_volume_file = pen::str_replace_string(sdf_shadow_volume_file, ".dds", ".pmv");
-
-                dev_console_log("[scene load] %s", sdf_shadow_volume_file.c_str());
-                instantiate_sdf_shadow(sdf_shadow_volume_file.c_str(), scene, n);
+                shadow_ref ref = {(u32)n, read_lookup_string_index(sr)};
+                sb_push(shadow_refs, ref);
             }
 
             // sampler binding textures
+            static hash_id id_wrap_linear = PEN_HASH("wrap_linear");
             for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
             {
                 if (!(scene->entities[n] & CMP_SAMPLERS))
@@ -2254,26 +3603,161 @@ namespace put
 
                 for (u32 i = 0; i < MAX_TECHNIQUE_SAMPLER_BINDINGS; ++i)
                 {
-                    Str texture_name = read_lookup_string(ifs);
+                    u32 texture = read_lookup_string_index(sr);
 
-                    if (!texture_name.empty())
+                    if (texture < num_strings && lookup_string_name(texture)[0])
                     {
-                        samplers.sb[i].handle = put::load_texture(texture_name.c_str());
-                        samplers.sb[i].sampler_state = pmfx::get_render_state(PEN_HASH("wrap_linear"), pmfx::RS_SAMPLER);
+                        if (resource_handles[texture] == PEN_INVALID_HANDLE)
+                            resource_handles[texture] = put::load_texture_async(lookup_string_name(texture));
+
+                        samplers.sb[i].handle = resource_handles[texture];
+                        samplers.sb[i].sampler_state = pmfx::get_render_state(id_wrap_linear, pmfx::RS_SAMPLER);
                     }
 
-                    Str sampler_state_name = read_lookup_string(ifs);
+                    const c8* sampler_state_name = lookup_string_name(read_lookup_string_index(sr));
 
-                    if (!sampler_state_name.empty())
+                    if (sampler_state_name[0])
                     {
                         samplers.sb[i].sampler_state = pmfx::get_render_state(PEN_HASH(sampler_state_name), pmfx::RS_SAMPLER);
                     }
                 }
             }
 
-            // read cams strings
-            for (u32 i = 0; i < num_cams; ++i)
-                read_lookup_string(ifs);
+            // version 9 and earlier write cams strings
+            if (sh.version < 10)
+                for (u32 i = 0; i < num_cams; ++i)
+                    read_lookup_string_index(sr);
+
+            // each pmm file is loaded once
+            static hash_id primitive_id = PEN_HASH("primitive");
+
+            u32 num_geometry_refs = sb_count(geometry_refs);
+            for (u32 i = 0; i < num_geometry_refs; ++i)
+            {
+                u32 file = geometry_refs[i].file;
+                if (file >= num_strings || resource_handles[file] != PEN_INVALID_HANDLE)
+                    continue;
+
+                const c8* name = lookup_string_name(file);
+                if (PEN_HASH(name) != primitive_id)
+                {
+                    Str pmm_filename = project_dir;
+                    pmm_filename.append(name);
+
+                    dev_console_log("[scene load] %s", name);
+                    load_pmm(pmm_filename.c_str(), nullptr, PMM_GEOMETRY);
+                }
+
+                resource_handles[file] = 0;
+            }
+
+            // geometry
+            for (u32 i = 0; i < num_geometry_refs; ++i)
+            {
+                const geometry_ref& ref = geometry_refs[i];
+                u32                 n = ref.node;
+
+                Str       filename = project_dir;
+                const c8* name = lookup_string_name(ref.file);
+                const c8* geometry_name = lookup_string_name(ref.name);
+
+                filename.append(name);
+
+                geometry_resource* gr = nullptr;
+
+                if (PEN_HASH(name) != primitive_id)
+                {
+                    pen::hash_murmur hm;
+                    hm.begin(0);
+                    hm.add(filename.c_str(), filename.length());
+                    hm.add(geometry_name, pen::string_length(geometry_name));
+                    hm.add(ref.submesh);
+                    hash_id geom_hash = hm.end();
+
+                    gr = get_geometry_resource(geom_hash);
+
+                    scene->id_geometry[n] = geom_hash;
+                }
+                else
+                {
+                    hash_id geom_hash = PEN_HASH(geometry_name);
+                    gr = get_geometry_resource(geom_hash);
+                }
+
+                if (gr)
+                {
+                    instantiate_geometry(gr, scene, n);
+                    instantiate_model_cbuffer(scene, n);
+
+                    if (gr->p_skin)
+                        instantiate_anim_controller(scene, n);
+                }
+                else
+                {
+                    dev_ui::log_level(dev_ui::CONSOLE_ERROR, "[error] geometry - cannot find pmm file: %s",
+                                      filename.c_str());
+
+                    scene->entities[n] &= ~CMP_GEOMETRY;
+                    error = true;
+                }
+            }
+
+            // instantiate physics
+            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
+                if (scene->entities[n] & CMP_PHYSICS)
+                    instantiate_rigid_body(scene, n);
+
+            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
+                if (scene->entities[n] & CMP_CONSTRAINT)
+                    instantiate_constraint(scene, n);
+
+            // animations, each pma file is loaded once
+            u32 num_anim_refs = sb_count(anim_refs);
+            for (u32 i = 0; i < num_anim_refs; ++i)
+            {
+                const anim_ref& ref = anim_refs[i];
+
+                anim_handle h = PEN_INVALID_HANDLE;
+                if (ref.name < num_strings && resource_handles[ref.name] != PEN_INVALID_HANDLE)
+                {
+                    h = resource_handles[ref.name];
+                }
+                else
+                {
+                    Str anim_name = project_dir;
+                    anim_name.append(lookup_string_name(ref.name));
+
+                    h = load_pma(anim_name.c_str());
+
+                    if (!is_valid(h))
+                    {
+                        dev_ui::log_level(dev_ui::CONSOLE_ERROR, "[error] animation - cannot find pma file: %s",
+                                          anim_name.c_str());
+                        error = true;
+                    }
+                    else if (ref.name < num_strings)
+                    {
+                        resource_handles[ref.name] = h;
+                    }
+                }
+
+                bind_animation_to_rig(scene, h, ref.node);
+            }
+
+            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
+                if (scene->anim_controller[n].current_animation > sb_count(scene->anim_controller[n].handles))
+                    scene->anim_controller[n].current_animation = PEN_INVALID_HANDLE;
+
+            // sdf shadow
+            u32 num_shadow_refs = sb_count(shadow_refs);
+            for (u32 i = 0; i < num_shadow_refs; ++i)
+            {
+                Str sdf_shadow_volume_file = lookup_string_name(shadow_refs[i].file);
+                sdf_shadow_volume_file = pen::str_replace_string(sdf_shadow_volume_file, ".dds", ".pmv");
+
+                dev_console_log("[scene load] %s", sdf_shadow_volume_file.c_str());
+                instantiate_sdf_shadow(sdf_shadow_volume_file.c_str(), scene, shadow_refs[i].node);
+            }
 
             // read extensions
             for (u32 i = 0; i < sh.num_extensions; ++i)
@@ -2282,6 +3766,17 @@ namespace put
 
             bake_material_handles();
 
+            // older files did not flag the range of a master instance, sub instances are drawn through the master
+            for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
+            {
+                if (!(scene->entities[n] & CMP_MASTER_INSTANCE))
+                    continue;
+
+                u32 end_node = std::min<u32>(n + scene->master_instances[n].num_instances + 1, scene->num_entities);
+                for (u32 i = n + 1; i < end_node; ++i)
+                    scene->entities[i] |= CMP_SUB_INSTANCE;
+            }
+
             // light geom
             for (s32 n = zero_offset; n < zero_offset + num_nodes; ++n)
             {
@@ -2301,13 +3796,16 @@ namespace put
                 update_view_flags(scene, error);
             }
 
-            ifs.close();
-
             initialise_free_list(scene);
 
             // cleanup
             sb_free(component_sizes);
             sb_free(exts);
+            sb_free(resource_handles);
+            sb_free(geometry_refs);
+            sb_free(anim_refs);
+            sb_free(shadow_refs);
+            pen::memory_free(scene_file);
         }
     } // namespace ecs
 } // namespace put
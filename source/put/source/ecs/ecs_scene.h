@@ -6,6 +6,7 @@
 
 #include "camera.h"
 #include "data_struct.h"
+#include "ecs/ecs_bvh.h"
 #include "loader.h"
 #include "maths/maths.h"
 #include "maths/quat.h"
@@ -24,6 +25,7 @@ namespace put
     namespace ecs
     {
         struct anim_instance;
+        struct anim_channel;
         struct ecs_scene;
 
         enum e_scene_view_flags : u32
@@ -40,6 +42,16 @@ namespace put
             PAUSE_UPDATE = 1 << 2
         };
 
+        enum e_dirty_flags : u8
+        {
+            DIRTY_LOCAL = 1 << 0,
+            DIRTY_WORLD = 1 << 1,
+            DIRTY_BOUNDS = 1 << 2,
+            DIRTY_DRAW_CALL = 1 << 3,
+            DIRTY_MATERIAL = 1 << 4,
+            DIRTY_ALL = 0xff
+        };
+
         enum e_component_flags : u32
         {
             CMP_ALLOCATED = (1 << 0),
@@ -141,6 +153,8 @@ namespace put
             vec4f v1; // generic data 1
             vec4f v2; // generic data 2
             mat4  world_matrix_inv_transpose;
+            vec4f position_offset; // dequantize PMM_VERTEX_QUANTIZED positions
+            vec4f position_scale;
         };
 
         struct cmp_skin
@@ -207,23 +221,79 @@ namespace put
             f32   radius;
         };
 
+        // centre and radius of renderable entities in soa layout for batched frustum culling, rebuilt by update_scene
+        struct cull_volumes
+        {
+            u32* entities = nullptr;
+            f32* x = nullptr;
+            f32* y = nullptr;
+            f32* z = nullptr;
+            f32* radius = nullptr;
+            u32  count = 0;
+            u32  capacity = 0;
+        };
+
+        struct dirty_stats
+        {
+            u32 entities = 0;
+            u32 transforms = 0; // world matrices recomputed
+            u32 bounds = 0;     // transformed bounds recomputed, including parents expanded by dirty children
+            u32 cbuffer_updates = 0;
+            u32 material_cbuffer_updates = 0;
+            u32 instance_buffer_updates = 0;
+        };
+
+        // entity state at the last update_scene, compared each frame so unchanged entities skip matrix, bounds and
+        // cbuffer work. dirty flags from the last update are kept in flags.
+        struct dirty_state
+        {
+            mat4*              local_matrices = nullptr;
+            u32*               parents = nullptr;
+            u64*               entities = nullptr;       // component flags without CMP_TRANSFORM
+            vec3f*             extents = nullptr;        // min, max pairs from bounding_volumes
+            cmp_draw_call*     draw_call_data = nullptr; // last written to the cbuffer or instance buffer
+            u32*               cbuffers = nullptr;
+            cmp_material_data* material_data = nullptr; // last written to the material cbuffer
+            u32*               material_cbuffers = nullptr;
+            u32*               instance_buffers = nullptr;
+            u8*                flags = nullptr;           // e_dirty_flags
+            u32*               bounds_entities = nullptr; // stretchy buffer of entities flagged DIRTY_BOUNDS, any order
+            u32                physics_frame = 0; // physics output frame the local matrices were last synced with
+            u32                num_entities = 0;
+            u32                capacity = 0;
+            dirty_stats        stats;
+        };
+
         struct extents
         {
             vec3f min;
             vec3f max;
         };
 
+        static const u32 k_max_lods = 4;
+
+        struct geometry_lod
+        {
+            u32 start_index;
+            u32 num_indices;
+            f32 error; // object space distance from the lod 0 surface
+        };
+
         struct cmp_geometry
         {
-            u32       position_buffer;
-            u32       vertex_buffer;
-            u32       index_buffer;
-            u32       num_indices;
-            u32       num_vertices;
-            u32       index_type;
-            u32       vertex_size;
-            cmp_skin* p_skin;
-            hash_id   vertex_shader_class;
+            u32          position_buffer;
+            u32          vertex_buffer;
+            u32          index_buffer;
+            u32          num_indices;
+            u32          num_vertices;
+            u32          index_type;
+            u32          vertex_size;
+            cmp_skin*    p_skin;
+            hash_id      vertex_shader_class;
+            vec4f        position_offset;
+            vec4f        position_scale;
+            u32          num_lods;
+            geometry_lod lods[k_max_lods];
         };
 
         struct cmp_pre_skin
@@ -406,7 +476,7 @@ namespace put
 
         struct ecs_scene
         {
-            static const u32 k_version = 9;
+            static const u32 k_version = 10;
 
             ecs_scene()
             {
@@ -472,7 +542,12 @@ namespace put
             s32             selected_index = -1;
             u32             flags = 0;
             u32             view_flags = 0;
+            f32             lod_pixel_error = 1.0f; // lods are chosen so their error projects to at most this many pixels
+            f32             lod_hysteresis = 0.1f;  // fraction the error must drop below the threshold to switch down
             extents         renderable_extents;
+            cull_volumes    renderable_volumes;
+            bvh             entity_bvh;
+            dirty_state     dirty;
             u32*            selection_list = nullptr;
             u32             version = k_version;
             Str             filename = "";
@@ -480,6 +555,20 @@ namespace put
             generic_cmp_array& get_component_array(u32 index);
         };
 
+        struct draw_sort_stats
+        {
+            hash_id id_view = 0;
+            u32     draw_packets = 0;
+            u32     culled = 0;
+            u32     draw_calls = 0;
+            u32     instanced_entities = 0;  // entities merged into dynamic instanced draws
+            u32     state_changes = 0;       // technique, material, vb / ib and sampler binds issued
+            u32     state_changes_saved = 0; // binds skipped compared to submitting each entity in index order
+            u32     triangles = 0;
+            u32     triangles_saved = 0; // triangles removed by lod selection
+            f32     sort_us = 0.0f;          // cull, packet build and radix sort
+        };
+
         struct ecs_scene_instance
         {
             u32        id_name;
@@ -500,6 +589,13 @@ namespace put
         void render_shadow_views(const scene_view& view);
         void render_area_light_textures(const scene_view& view);
 
+        const draw_sort_stats* get_draw_sort_stats(u32& count); // per view stats from the last render_scene_view
+        const dirty_stats& get_dirty_stats(const ecs_scene* scene); // counts from the last update_scene
+        u32 frustum_cull(const ecs_scene* scene, const frustum& f, u32* visible); // visible must fit renderable_volumes.count
+        u32 frustum_cull_volumes(const cull_volumes& cv, const frustum& f, u32* visible); // flat simd cull, no bvh
+        u32 find_anim_key(const f32* times, u32 num_frames, u32 cursor, f32 t); // last key at or before t from cursor
+        void decode_anim_key(const anim_channel& channel, const u16* q, f32* out); // COMPRESSED key to element_count f32
+
         void clear_scene(ecs_scene* scene);
         void default_scene(ecs_scene* scene);
 
@@ -570,6 +666,14 @@ namespace put
             return offset;
         }
 
+        // culled and drawn on their own, shared by the flat cull volumes and the bvh. sub instances are drawn through
+        // their master, load_scene flags the range of masters from older files
+        inline bool is_cull_candidate(const ecs_scene* scene, u32 n)
+        {
+            u64 flags = scene->entities[n];
+            return flags & CMP_GEOMETRY && flags & CMP_MATERIAL && !(flags & CMP_SUB_INSTANCE);
+        }
+
         inline generic_cmp_array& ecs_scene::get_component_array(u32 index)
         {
             if (index >= num_base_components)
@@ -420,6 +420,15 @@ namespace put
             if (scene->entities[master] & CMP_MASTER_INSTANCE)
                 return;
 
+            // instance inputs carry no dequantize params, quantized geometry must be drawn with per draw cbuffers
+            hash_id vertex_class = scene->geometries[master].vertex_shader_class;
+            if (vertex_class == ID_VERTEX_CLASS_QUANTIZED || vertex_class == ID_VERTEX_CLASS_SKINNED_QUANTIZED)
+            {
+                dev_console_log_level(dev_ui::CONSOLE_WARNING, "[instance] %s has quantized vertices and can't be instanced",
+                                      scene->names[master].c_str());
+                return;
+            }
+
             scene->entities[master] |= CMP_MASTER_INSTANCE;
 
             scene->master_instances[master].num_instances = num_nodes;
@@ -436,9 +445,14 @@ namespace put
             scene->geometries[master].vertex_shader_class = ID_VERTEX_CLASS_INSTANCED;
 
             // vertex class has changed which changes shader technique
+            // sub instances are master_node + 1 .. master_node + num_nodes and are drawn through the master
             u32 flush = 0;
-            for (u32 i = master_node; i < master_node + num_nodes; ++i)
+            u32 end_node = std::min<u32>(master_node + num_nodes + 1, scene->num_entities);
+            for (u32 i = master_node; i < end_node; ++i)
             {
+                if (i != master_node)
+                    scene->entities[i] |= CMP_SUB_INSTANCE;
+
                 bake_material_handles(scene, i);
 
                 if (flush > 100)
@@ -589,6 +603,8 @@ namespace put
             scene->geometries[nn].index_type = index_type;
             scene->geometries[nn].num_vertices = num_vertices;
             scene->geometries[nn].num_indices = num_indices;
+            scene->geometries[nn].num_lods = 1;
+            scene->geometries[nn].lods[0] = {0, num_indices, 0.0f};
             scene->geometries[nn].vertex_size = vertex_size;
             scene->geometries[nn].vertex_shader_class = 0;
             scene->geometries[nn].p_skin = nullptr;
@@ -13,11 +13,14 @@ namespace
     hash_id ID_VERTEX_CLASS_INSTANCED = PEN_HASH("_instanced");
     hash_id ID_VERTEX_CLASS_SKINNED = PEN_HASH("_skinned");
     hash_id ID_VERTEX_CLASS_BASIC = PEN_HASH("");
+    hash_id ID_VERTEX_CLASS_QUANTIZED = PEN_HASH("_quantized");
+    hash_id ID_VERTEX_CLASS_SKINNED_QUANTIZED = PEN_HASH("_skinned_quantized");
 
     enum e_shader_permutation
     {
         PERMUTATION_SKINNED = 1 << 31,
-        PERMUTATION_INSTANCED = 1 << 30
+        PERMUTATION_INSTANCED = 1 << 30,
+        PERMUTATION_QUANTIZED = 1 << 29
     };
 } // namespace
 
@@ -9,12 +9,15 @@
 #include "file_system.h"
 #include "hash.h"
 #include "memory.h"
+#include "os.h"
 #include "pen.h"
 #include "pen_json.h"
 #include "pen_string.h"
 #include "renderer.h"
 #include "str/Str.h"
 #include "str_utilities.h"
+#include "threads.h"
+#include "timer.h"
 
 #include <fstream>
 #include <vector>
@@ -256,7 +259,30 @@ namespace
         return pf;
     }
 
-    u32 load_texture_internal(const c8* filename, hash_id hh, pen::texture_creation_params& tcp)
+    void dds_collection_type(const dds_header* ddsh, pen::texture_creation_params& tcp)
+    {
+        tcp.collection_type = pen::TEXTURE_COLLECTION_NONE;
+        tcp.num_arrays = 1;
+
+        if (ddsh->caps & DDSCAPS_COMPLEX)
+        {
+            if (ddsh->caps2 & DDS_CUBEMAP_ALLFACES)
+            {
+                tcp.collection_type = pen::TEXTURE_COLLECTION_CUBE;
+                tcp.num_arrays = 6;
+            }
+
+            if (ddsh->caps2 & DDSCAPS2_VOLUME)
+            {
+                tcp.collection_type = pen::TEXTURE_COLLECTION_VOLUME;
+                tcp.num_arrays = ddsh->depth;
+            }
+        }
+    }
+
+    // reads and parses a dds into tcp, tcp.data is allocated and owned by the caller. touches no shared state so it
+    // can run on the job workers
+    bool read_texture_file(const c8* filename, pen::texture_creation_params& tcp)
     {
         // load a texture file from disk.
         void* file_data = nullptr;
@@ -266,9 +292,8 @@ namespace
 
         if (pen_err != PEN_ERR_OK)
         {
-            dev_console_log_level(dev_ui::CONSOLE_ERROR, "[error] texture - unabled to find file: %s", filename);
             pen::memory_free(file_data);
-            return 0;
+            return false;
         }
 
         // parse dds header
@@ -304,22 +329,7 @@ namespace
         tcp.flags = 0;
         tcp.block_size = block_size;
         tcp.pixels_per_block = compressed ? 4 : 1;
-        tcp.collection_type = pen::TEXTURE_COLLECTION_NONE;
-
-        if (ddsh->caps & DDSCAPS_COMPLEX)
-        {
-            if (ddsh->caps2 & DDS_CUBEMAP_ALLFACES)
-            {
-                tcp.collection_type = pen::TEXTURE_COLLECTION_CUBE;
-                tcp.num_arrays = 6;
-            }
-
-            if (ddsh->caps2 & DDSCAPS2_VOLUME)
-            {
-                tcp.collection_type = pen::TEXTURE_COLLECTION_VOLUME;
-                tcp.num_arrays = ddsh->depth;
-            }
-        }
+        dds_collection_type(ddsh, tcp);
 
         // calculate total data size
         tcp.data_size = 0;
@@ -356,6 +366,17 @@ namespace
         // free the files contents
         pen::memory_free(file_data);
 
+        return true;
+    }
+
+    u32 load_texture_internal(const c8* filename, hash_id hh, pen::texture_creation_params& tcp)
+    {
+        if (!read_texture_file(filename, tcp))
+        {
+            dev_console_log_level(dev_ui::CONSOLE_ERROR, "[error] texture - unabled to find file: %s", filename);
+            return 0;
+        }
+
         u32 texture_index = pen::renderer_create_texture(tcp);
 
         pen::memory_free(tcp.data);
@@ -387,6 +408,165 @@ namespace
             }
         }
     }
+
+    // texture streaming, requests wait in priority order until there is room in the budget, a task on the job workers
+    // reads and parses the file and poll_streaming hands the data to the renderer on the user thread
+    enum stream_state : u32
+    {
+        STREAM_PENDING = 0,
+        STREAM_LOADING,
+        STREAM_DECODED,
+        STREAM_FAILED
+    };
+
+    struct stream_request
+    {
+        hash_id                      id_name;
+        Str                          filename;
+        u32                          handle; // placeholder, replaced by the loaded texture
+        u32                          priority;
+        u32                          order; // fifo within a priority
+        a_u32                        state = {STREAM_PENDING};
+        pen::texture_creation_params tcp;
+        u32                          reserved_bytes = 0; // counted against the budget from start until upload
+        f32                          request_time = 0.0f;
+        f32                          start_time = 0.0f;
+        f32                          decoded_time = 0.0f;
+    };
+
+    std::vector<stream_request*> k_stream_requests;
+    std::vector<stream_latency>  k_stream_latencies; // ring of the last k_max_stream_latencies
+
+    u32   s_stream_order = 0;
+    u32   s_stream_in_flight = 0;
+    a_u32 s_stream_in_flight_bytes = {0};
+    u32   s_stream_budget = 64 * 1024 * 1024;
+    u32   s_stream_latency_pos = 0;
+
+    // totals over every request, the latency ring only holds the most recent
+    u32 s_stream_completed = 0;
+    u32 s_stream_failed = 0;
+    u64 s_stream_completed_bytes = 0;
+    f32 s_stream_total_ms = 0.0f;
+    f32 s_stream_max_ms = 0.0f;
+
+    u32 stream_size_estimate()
+    {
+        // size is unknown until the header is parsed on the worker, assume the average so far (1k rgba8 with mips)
+        if (s_stream_completed == 0)
+            return (1024 * 1024 * 4 * 4) / 3;
+
+        return (u32)(s_stream_completed_bytes / s_stream_completed);
+    }
+
+    void stream_texture_task(void* user_data)
+    {
+        stream_request* req = (stream_request*)user_data;
+        req->start_time = pen::get_time_ms();
+
+        if (!read_texture_file(req->filename.c_str(), req->tcp))
+        {
+            req->state = STREAM_FAILED;
+            return;
+        }
+
+        // swap the reservation for the real size, wraps correctly when the estimate was too large
+        s_stream_in_flight_bytes += req->tcp.data_size - req->reserved_bytes;
+        req->reserved_bytes = req->tcp.data_size;
+
+        req->decoded_time = pen::get_time_ms();
+        req->state = STREAM_DECODED;
+    }
+
+    u32 create_placeholder_texture(const c8* filename, pen::texture_creation_params& tcp)
+    {
+        static u32 grey[6] = {0xff808080, 0xff808080, 0xff808080, 0xff808080, 0xff808080, 0xff808080};
+
+        // only the header is read here so the placeholder binds to the same cube or volume slot as the real texture,
+        // missing files get a 2d placeholder and fail on the worker
+        dds_header ddsh = {};
+        std::ifstream ifs(pen::os_path_for_resource(filename), std::ifstream::binary);
+        if (!ifs.read((c8*)&ddsh, sizeof(dds_header)))
+            ddsh = dds_header();
+
+        dds_collection_type(&ddsh, tcp);
+
+        // volumes are 1x1x1
+        if (tcp.collection_type == pen::TEXTURE_COLLECTION_VOLUME)
+            tcp.num_arrays = 1;
+
+        tcp.width = 1;
+        tcp.height = 1;
+        tcp.format = PEN_TEX_FORMAT_RGBA8_UNORM;
+        tcp.num_mips = 1;
+        tcp.sample_count = 1;
+        tcp.sample_quality = 0;
+        tcp.usage = PEN_USAGE_DEFAULT;
+        tcp.bind_flags = PEN_BIND_SHADER_RESOURCE;
+        tcp.cpu_access_flags = 0;
+        tcp.flags = 0;
+        tcp.block_size = 4;
+        tcp.pixels_per_block = 1;
+        tcp.data = &grey[0];
+        tcp.data_size = sizeof(u32) * tcp.num_arrays;
+
+        u32 handle = pen::renderer_create_texture(tcp);
+        tcp.data = nullptr;
+
+        return handle;
+    }
+
+    void complete_stream_request(stream_request* req)
+    {
+        f32 now = pen::get_time_ms();
+
+        if (req->state == STREAM_FAILED)
+        {
+            dev_console_log_level(dev_ui::CONSOLE_ERROR, "[error] texture - unabled to find file: %s",
+                                  req->filename.c_str());
+        }
+        else
+        {
+            u32 texture_index = pen::renderer_create_texture(req->tcp);
+            pen::renderer_replace_resource(req->handle, texture_index, pen::RESOURCE_TEXTURE);
+
+            pen::memory_free(req->tcp.data);
+            req->tcp.data = nullptr;
+
+            for (auto& t : k_texture_references)
+                if (t.handle == req->handle)
+                    t.tcp = req->tcp;
+        }
+
+        s_stream_in_flight_bytes -= req->reserved_bytes;
+
+        stream_latency sl;
+        sl.filename = req->filename;
+        sl.priority = req->priority;
+        sl.data_size = req->state == STREAM_FAILED ? 0 : req->tcp.data_size;
+        sl.failed = req->state == STREAM_FAILED;
+        sl.queue_ms = req->start_time - req->request_time;
+        sl.load_ms = sl.failed ? 0.0f : req->decoded_time - req->start_time;
+        sl.total_ms = now - req->request_time;
+
+        if (k_stream_latencies.size() < k_max_stream_latencies)
+            k_stream_latencies.push_back(sl);
+        else
+            k_stream_latencies[s_stream_latency_pos] = sl;
+
+        s_stream_latency_pos = (s_stream_latency_pos + 1) % k_max_stream_latencies;
+
+        if (sl.failed)
+        {
+            ++s_stream_failed;
+            return;
+        }
+
+        ++s_stream_completed;
+        s_stream_completed_bytes += sl.data_size;
+        s_stream_total_ms += sl.total_ms;
+        s_stream_max_ms = max<f32>(s_stream_max_ms, sl.total_ms);
+    }
 } // namespace
 
 namespace put
@@ -521,6 +701,168 @@ namespace put
         ImGui::Columns(1);
     }
 
+    u32 load_texture_async(const c8* filename, u32 priority)
+    {
+        // check for existing, a repeat request can raise the priority of one still waiting
+        hash_id hh = PEN_HASH(filename);
+        for (auto& t : k_texture_references)
+        {
+            if (t.id_name == hh)
+            {
+                for (auto* req : k_stream_requests)
+                    if (req->id_name == hh && req->state == STREAM_PENDING)
+                        req->priority = max<u32>(req->priority, priority);
+
+                return t.handle;
+            }
+        }
+
+        add_file_watcher(filename, texture_build, texture_hotload);
+
+        pen::texture_creation_params tcp;
+        u32                          texture_index = create_placeholder_texture(filename, tcp);
+
+        k_texture_references.push_back({hh, filename, texture_index, tcp});
+
+        stream_request* req = new stream_request();
+        req->id_name = hh;
+        req->filename = filename;
+        req->handle = texture_index;
+        req->priority = priority;
+        req->order = s_stream_order++;
+        req->request_time = pen::get_time_ms();
+        k_stream_requests.push_back(req);
+
+        return texture_index;
+    }
+
+    void poll_streaming()
+    {
+        // hand finished requests to the renderer
+        for (u32 i = 0; i < k_stream_requests.size();)
+        {
+            stream_request* req = k_stream_requests[i];
+            u32             state = req->state;
+
+            if (state != STREAM_DECODED && state != STREAM_FAILED)
+            {
+                ++i;
+                continue;
+            }
+
+            complete_stream_request(req);
+            --s_stream_in_flight;
+
+            delete req;
+            k_stream_requests[i] = k_stream_requests.back();
+            k_stream_requests.pop_back();
+        }
+
+        // start the highest priority requests, one worker is left free for other tasks. each start reserves an estimate
+        // so the budget holds before sizes are known, one request may always run so large files can't stall the queue
+        u32 num_workers = pen::jobs_get_num_workers();
+        u32 max_in_flight = num_workers > 1 ? num_workers - 1 : 1;
+        u32 estimate = stream_size_estimate();
+        while (s_stream_in_flight < max_in_flight &&
+               (s_stream_in_flight == 0 || s_stream_in_flight_bytes + estimate <= s_stream_budget))
+        {
+            stream_request* next = nullptr;
+            for (auto* req : k_stream_requests)
+            {
+                if (req->state != STREAM_PENDING)
+                    continue;
+
+                if (!next || req->priority > next->priority ||
+                    (req->priority == next->priority && req->order < next->order))
+                    next = req;
+            }
+
+            if (!next)
+                break;
+
+            next->state = STREAM_LOADING;
+            next->reserved_bytes = estimate;
+            s_stream_in_flight_bytes += estimate;
+            ++s_stream_in_flight;
+
+            pen::task_decl decl;
+            decl.func = stream_texture_task;
+            decl.user_data = next;
+            pen::jobs_run_tasks(&decl, 1);
+        }
+    }
+
+    void set_streaming_budget(u32 bytes)
+    {
+        s_stream_budget = bytes;
+    }
+
+    void get_streaming_stats(streaming_stats& stats)
+    {
+        stats = streaming_stats();
+        stats.in_flight = s_stream_in_flight;
+        stats.in_flight_bytes = s_stream_in_flight_bytes;
+        stats.budget_bytes = s_stream_budget;
+        stats.pending = k_stream_requests.size() - s_stream_in_flight;
+        stats.completed = s_stream_completed;
+        stats.failed = s_stream_failed;
+        stats.max_latency_ms = s_stream_max_ms;
+
+        if (stats.completed)
+            stats.avg_latency_ms = s_stream_total_ms / (f32)stats.completed;
+    }
+
+    const std::vector<stream_latency>& get_streaming_latencies()
+    {
+        return k_stream_latencies;
+    }
+
+    void streaming_ui()
+    {
+        streaming_stats stats;
+        get_streaming_stats(stats);
+
+        ImGui::Text("pending: %u, in flight: %u, %.2f / %.2f mb", stats.pending, stats.in_flight,
+                    (f32)stats.in_flight_bytes / (1024.0f * 1024.0f), (f32)stats.budget_bytes / (1024.0f * 1024.0f));
+        ImGui::Text("completed: %u, failed: %u, latency avg: %.2fms, max: %.2fms", stats.completed, stats.failed,
+                    stats.avg_latency_ms, stats.max_latency_ms);
+
+        ImGui::Separator();
+
+        ImGui::Columns(5);
+        ImGui::Text("file");
+        ImGui::NextColumn();
+        ImGui::Text("queue (ms)");
+        ImGui::NextColumn();
+        ImGui::Text("load (ms)");
+        ImGui::NextColumn();
+        ImGui::Text("total (ms)");
+        ImGui::NextColumn();
+        ImGui::Text("size (kb)");
+        ImGui::NextColumn();
+
+        // newest first
+        u32 num_latencies = k_stream_latencies.size();
+        for (u32 i = 0; i < num_latencies; ++i)
+        {
+            const stream_latency& sl =
+                k_stream_latencies[(s_stream_latency_pos + num_latencies - 1 - i) % num_latencies];
+
+            ImGui::Text("%s%s", sl.filename.c_str(), sl.failed ? " (failed)" : "");
+            ImGui::NextColumn();
+            ImGui::Text("%.2f", sl.queue_ms);
+            ImGui::NextColumn();
+            ImGui::Text("%.2f", sl.load_ms);
+            ImGui::NextColumn();
+            ImGui::Text("%.2f", sl.total_ms);
+            ImGui::NextColumn();
+            ImGui::Text("%.1f", (f32)sl.data_size / 1024.0f);
+            ImGui::NextColumn();
+        }
+
+        ImGui::Columns(1);
+    }
+
     void add_file_watcher(const c8* filename, void (*build_callback)(), void (*hotload_callback)(std::vector<hash_id>& dirty))
     {
         Str fn = filename;
@@ -25,6 +25,54 @@ namespace put
     Str  get_texture_filename(u32 handle);
     void texture_browser_ui();
 
+    // Streaming
+    // load_texture_async returns a 1x1 placeholder handle of the same collection type (2d, cube or volume) as the file
+    // straight away, only the file header is read on the calling thread. the file is read and parsed by a task on the
+    // job workers and poll_streaming (once per frame on the user thread) creates the texture and swaps it into the
+    // placeholder with renderer_replace_resource. requests start in priority order while the bytes in flight fit the
+    // budget, a request reserves the average size of completed requests when it starts and is trued up to its
+    // decoded size once parsed. get_texture_info returns the placeholder info until the swap. load_texture does not
+    // block on a pending stream of the same file, it returns the placeholder handle which is swapped in place later.
+    // get_streaming_latencies keeps the most recent k_max_stream_latencies requests in no particular order.
+    enum e_stream_priority
+    {
+        STREAM_PRIORITY_LOW = 0,
+        STREAM_PRIORITY_NORMAL,
+        STREAM_PRIORITY_HIGH
+    };
+
+    static const u32 k_max_stream_latencies = 256;
+
+    struct stream_latency
+    {
+        Str  filename;
+        u32  priority;
+        u32  data_size;
+        bool failed;
+        f32  queue_ms; // request until a worker starts the io
+        f32  load_ms;  // io and parse on the worker
+        f32  total_ms; // request until the texture is handed to the renderer
+    };
+
+    struct streaming_stats
+    {
+        u32 pending = 0;
+        u32 in_flight = 0;
+        u32 in_flight_bytes = 0;
+        u32 budget_bytes = 0;
+        u32 completed = 0;
+        u32 failed = 0;
+        f32 avg_latency_ms = 0.0f;
+        f32 max_latency_ms = 0.0f;
+    };
+
+    u32                                load_texture_async(const c8* filename, u32 priority = STREAM_PRIORITY_NORMAL);
+    void                               poll_streaming();
+    void                               set_streaming_budget(u32 bytes);
+    void                               get_streaming_stats(streaming_stats& stats);
+    const std::vector<stream_latency>& get_streaming_latencies();
+    void                               streaming_ui();
+
     // Hot loading
     Str  get_build_cmd();
     void add_file_watcher(const c8* filename, void (*build_callback)(),
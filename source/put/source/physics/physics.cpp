@@ -25,7 +25,7 @@ namespace physics
     static pen::slot_resources           s_physics_slot_resources;
     static pen::slot_resources           s_p2p_slot_resources;
 
-    void exec_cmd(const physics_cmd& cmd, f32 dt_ms)
+    void exec_cmd(const physics_cmd& cmd, physics_stats& stats)
     {
         switch (cmd.command_index)
         {
@@ -164,7 +164,15 @@ namespace physics
                 contact_test_internal(cmd.contact_test);
                 break;
             case CMD_STEP:
-                physics_update(dt_ms * 1000.0f);
+                physics_update(cmd.step_dt, stats);
+                break;
+
+            case CMD_SET_TIMESTEP:
+                set_timestep_internal(cmd.set_timestep);
+                break;
+
+            case CMD_QUERY_BATCH:
+                query_batch_internal(cmd.batch);
                 break;
 
             default:
@@ -185,6 +193,12 @@ namespace physics
     {
         pen::job_thread_params* job_params = (pen::job_thread_params*)params;
         pen::job*               p_thread_info = job_params->job_info;
+
+        // copy config before allowing the creating thread to continue
+        physics_config config;
+        if (job_params->user_data)
+            config = *(physics_config*)job_params->user_data;
+
         pen::semaphore_post(p_thread_info->p_sem_continue, 1);
 
         p_physics_job_thread_info = p_thread_info;
@@ -192,34 +206,35 @@ namespace physics
         pen::slot_resources_init(&s_physics_slot_resources, 1024);
         pen::slot_resources_init(&s_p2p_slot_resources, 16);
 
-        physics_initialise();
-
-        static pen::timer* physics_timer = pen::timer_create();
-        pen::timer_start(physics_timer);
+        physics_initialise(config);
 
         // space for 8192 commands
         s_cmd_buffer.create(8192);
 
+        physics_stats stats = {};
+
         for (;;)
         {
-            f32 dt_ms = pen::timer_elapsed_ms(physics_timer);
+            // sleep until the main thread kicks the command buffer, jobs_terminate_all also wakes us to exit
+            pen::semaphore_wait(p_physics_job_thread_info->p_sem_consume);
 
-            pen::timer_start(physics_timer);
+            if (pen::semaphore_try_wait(p_physics_job_thread_info->p_sem_exit))
+                break;
 
-            if (pen::semaphore_try_wait(p_physics_job_thread_info->p_sem_consume))
+            u32 cap = s_cmd_buffer._capacity;
+            stats.cmd_buffer_depth = (s_cmd_buffer.put_pos + cap - s_cmd_buffer.get_pos) % cap;
+
+            pen::semaphore_post(p_physics_job_thread_info->p_sem_continue, 1);
+
+            physics_cmd* cmd = s_cmd_buffer.get();
+            while (cmd)
             {
-                pen::semaphore_post(p_physics_job_thread_info->p_sem_continue, 1);
-
-                physics_cmd* cmd = s_cmd_buffer.get();
-                while (cmd)
-                {
-                    exec_cmd(*cmd, dt_ms);
-                    cmd = s_cmd_buffer.get();
-                }
+                exec_cmd(*cmd, stats);
+                cmd = s_cmd_buffer.get();
             }
 
-            if (pen::semaphore_try_wait(p_physics_job_thread_info->p_sem_exit))
-                break;
+            g_readable_data.stats.backbuffer() = stats;
+            g_readable_data.stats.swap_buffers();
         }
 
         pen::semaphore_post(p_physics_job_thread_info->p_sem_continue, 1);
@@ -259,26 +274,39 @@ namespace physics
         s_cmd_buffer.put(pc);
     }
 
+    const rb_output& get_rb_output()
+    {
+        return g_readable_data.output.frontbuffer();
+    }
+
     mat4 get_rb_matrix(const u32& entity_index)
     {
-        mat4* const& fb = g_readable_data.output_matrices.frontbuffer();
-        return fb[entity_index];
+        maths::transform t = get_rb_transform(entity_index);
+
+        mat4 rot_mat;
+        t.rotation.get_matrix(rot_mat);
+
+        return mat::create_translation(t.translation) * rot_mat;
     }
 
     maths::transform get_rb_transform(const u32& entity_index)
     {
-        maths::transform* const& fb = g_readable_data.output_transforms.frontbuffer();
-        return fb[entity_index];
+        const rb_output& output = get_rb_output();
+
+        maths::transform t;
+        t.translation = output.translations[entity_index];
+        t.rotation = output.rotations[entity_index];
+        t.scale = vec3f::one();
+        return t;
     }
 
     bool has_rb_matrix(const u32& entity_index)
     {
-        auto&        om = g_readable_data.output_matrices;
-        mat4* const& fb = om._data[om._fb];
-        if (entity_index >= sb_count(fb))
+        const rb_output& output = get_rb_output();
+        if (entity_index >= output.capacity)
             return false;
 
-        return true;
+        return output.frames[entity_index] != 0;
     }
 
     u32 add_rb(const rigid_body_params& rbp)
@@ -523,10 +551,41 @@ namespace physics
         s_cmd_buffer.put(pc);
     }
 
-    void step()
+    void submit_query_batch(query_batch* batch)
+    {
+        if (batch->count == 0)
+            return;
+
+        batch->pending = 1;
+
+        physics_cmd pc;
+        pc.command_index = CMD_QUERY_BATCH;
+        pc.batch = batch;
+        s_cmd_buffer.put(pc);
+    }
+
+    void step(f32 dt)
     {
         physics_cmd pc;
         pc.command_index = CMD_STEP;
+        pc.step_dt = dt;
         s_cmd_buffer.put(pc);
     }
+
+    void set_timestep(f32 fixed_step, u32 max_substeps)
+    {
+        if (fixed_step <= 0.0f)
+            return;
+
+        physics_cmd pc;
+        pc.command_index = CMD_SET_TIMESTEP;
+        pc.set_timestep.fixed_step = fixed_step;
+        pc.set_timestep.max_substeps = max_substeps;
+        s_cmd_buffer.put(pc);
+    }
+
+    physics_stats get_stats()
+    {
+        return g_readable_data.stats.frontbuffer();
+    }
 } // namespace physics
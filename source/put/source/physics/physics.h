@@ -46,7 +46,9 @@ namespace physics
         CMD_ADD_CENTRAL_FORCE,
         CMD_ADD_CENTRAL_IMPULSE,
         CMD_CONTACT_TEST,
-        CMD_STEP
+        CMD_STEP,
+        CMD_SET_TIMESTEP,
+        CMD_QUERY_BATCH
     };
 
     enum e_physics_shape : s32
@@ -82,6 +84,27 @@ namespace physics
         UP_Z = 2,
     };
 
+    enum e_broadphase : s32
+    {
+        BROADPHASE_SWEEP = 0, // btAxisSweep3, fast for a bounded world, bodies outside world_min / world_max degrade
+        BROADPHASE_DBVT       // dynamic aabb tree, unbounded
+    };
+
+    enum e_physics_config_flags
+    {
+        PHYSICS_MULTITHREADED = 1 << 0 // btDiscreteDynamicsWorldMt with islands solved on the pen job pool
+    };
+
+    // pass as user data to jobs_create_job(physics_thread_main, ...), a null user data uses the defaults
+    struct physics_config
+    {
+        u32   broadphase = BROADPHASE_SWEEP;
+        vec3f world_min = vec3f(-50.0f, -50.0f, -50.0f);
+        vec3f world_max = vec3f(50.0f, 50.0f, 50.0f);
+        u32   max_handles = 16384; // sweep only, above 65535 uses the 32 bit sweep
+        u32   flags = 0;
+    };
+
     struct collision_response
     {
         s32 hit_tag;
@@ -315,6 +338,70 @@ namespace physics
         void (*callback)(const contact_test_results& result);
     };
 
+    enum e_query_type : u32
+    {
+        QUERY_RAY = 0, // closest hit from -> to
+        QUERY_SPHERE,  // closest hit sweeping a sphere of radius from -> to
+        QUERY_CONTACT  // deepest contact between entity and the world
+    };
+
+    struct query
+    {
+        vec3f from;
+        vec3f to;
+        f32   radius;
+        u32   entity;
+        u32   mask;
+        u32   group;
+    };
+
+    struct query_result
+    {
+        vec3f point;
+        vec3f normal;
+        f32   fraction;       // along from -> to, or contact distance (negative when penetrating)
+        u32   physics_handle; // -1 when nothing was hit
+    };
+
+    // ray and sphere batches are executed in parallel from the physics thread, contact batches run serially on it.
+    // one result is written per query. the batch, queries and results must stay alive until pending is cleared,
+    // which is usually by the next frame
+    struct query_batch
+    {
+        u32           type = QUERY_RAY;
+        const query*  queries = nullptr;
+        query_result* results = nullptr;
+        u32           count = 0;
+        a_u32         pending = {0};
+    };
+
+    struct set_timestep_params
+    {
+        f32 fixed_step;
+        u32 max_substeps;
+    };
+
+    struct physics_stats
+    {
+        f32 step_ms;          // time spent stepping the world during the last step command
+        f32 interpolation;    // blend between the previous and latest fixed step applied to output transforms
+        u32 substeps;         // fixed steps taken by the last step command
+        u32 dropped_substeps; // fixed steps discarded because max_substeps was reached
+        u32 cmd_buffer_depth; // commands pending when the buffer was last consumed
+    };
+
+    // rigid body transforms published by the physics thread, indexed by physics handle. only bodies which bullet
+    // reports as active, were added or were teleported are written each frame and their handles listed in changed
+    struct rb_output
+    {
+        vec3f* translations = nullptr;
+        quat*  rotations = nullptr;
+        u32*   frames = nullptr;  // frame each body was last written, 0 if never
+        u32*   changed = nullptr; // stretchy buffer of handles written this frame
+        u32    capacity = 0;
+        u32    frame = 0;
+    };
+
     struct compound_rb_cmd
     {
         compound_rb_params params;
@@ -347,6 +434,9 @@ namespace physics
             ray_cast_params            ray_cast;
             sphere_cast_params         sphere_cast;
             contact_test_params        contact_test;
+            set_timestep_params        set_timestep;
+            f32                        step_dt;
+            query_batch*               batch;
         };
 
         physics_cmd(){};
@@ -371,8 +461,14 @@ namespace physics
     void cast_sphere(const sphere_cast_params& rcp,
                      bool                      immediate = false); // using non immediate may not be thread safe..
     void contact_test(const contact_test_params& ctp);
+    void submit_query_batch(query_batch* batch);
+
+    // simulation advances in fixed steps of fixed_step seconds, taking at most max_substeps per call to step
+    // the remainder is carried over and output transforms are interpolated between the last two fixed steps
+    void          step(f32 dt);
+    void          set_timestep(f32 fixed_step, u32 max_substeps);
+    physics_stats get_stats();
 
-    void step();
     void set_v3(const u32& entity_index, const vec3f& v3, u32 cmd);
     void set_float(const u32& entity_index, const f32& fval, u32 cmd);
     void set_transform(const u32& entity_index, const vec3f& position, const quat& quaternion);
@@ -382,6 +478,7 @@ namespace physics
     void sync_compound_multi(const u32& compound_index, const u32& multi_index);
     void sync_rigid_bodies(const u32& master, const u32& slave, const s32& link_index, u32 cmd);
 
+    const rb_output& get_rb_output();
     bool             has_rb_matrix(const u32& entity_index);
     mat4             get_rb_matrix(const u32& entity_index);
     maths::transform get_rb_transform(const u32& entity_index);
@@ -229,7 +229,10 @@ namespace physics
         }
 
         body->setContactProcessingThreshold(BT_LARGE_FLOAT);
-        body->setActivationState(DISABLE_DEACTIVATION);
+
+        // dynamic bodies may sleep so they drop out of the output copy, kinematic bodies are driven by their motion state
+        if (params.create_flags & CF_KINEMATIC)
+            body->setActivationState(DISABLE_DEACTIVATION);
 
         if (!ghost)
         {
@@ -239,131 +242,434 @@ namespace physics
         return body;
     }
 
-    void physics_initialise()
+    // routes bullet's btParallelFor through the pen job pool
+    class pen_task_scheduler : public btITaskScheduler
+    {
+      public:
+        pen_task_scheduler() : btITaskScheduler("pen")
+        {
+        }
+
+        int getMaxNumThreads() const BT_OVERRIDE
+        {
+            return min(pen::jobs_get_num_workers() + 1, BT_MAX_THREAD_COUNT);
+        }
+
+        int getNumThreads() const BT_OVERRIDE
+        {
+            return getMaxNumThreads();
+        }
+
+        void setNumThreads(int num_threads) BT_OVERRIDE
+        {
+            // worker count is owned by pen
+            PEN_UNUSED num_threads;
+        }
+
+        void parallelFor(int begin, int end, int grain, const btIParallelForBody& body) BT_OVERRIDE
+        {
+            if (end <= begin)
+                return;
+
+            parallel_for_body pfb = {&body, begin};
+            pen::parallel_for((u32)(end - begin), (u32)max(grain, 1), for_range, &pfb);
+        }
+
+      private:
+        struct parallel_for_body
+        {
+            const btIParallelForBody* body;
+            int                       begin;
+        };
+
+        static void for_range(u32 start, u32 end, void* user_data)
+        {
+            parallel_for_body* pfb = (parallel_for_body*)user_data;
+            pfb->body->forLoop(pfb->begin + (int)start, pfb->begin + (int)end);
+        }
+    };
+
+    void physics_initialise(const physics_config& config)
     {
         s_entities.init(1024);
 
-        g_readable_data.output_matrices._data[0] = nullptr;
-        g_readable_data.output_matrices._data[1] = nullptr;
-        g_readable_data.output_transforms._data[0] = nullptr;
-        g_readable_data.output_transforms._data[1] = nullptr;
+        bool mt = config.flags & PHYSICS_MULTITHREADED;
+
+        // bullet gives every thread which runs its tasks an index and asserts past BT_MAX_THREAD_COUNT, the physics
+        // thread takes one. pen_task_scheduler can't choose which workers run a range, so larger pools step serially
+        u32 num_workers = pen::jobs_get_num_workers();
+        if (mt && num_workers + 1 > BT_MAX_THREAD_COUNT)
+        {
+            PEN_LOG("[physics] %u job workers exceeds the bullet thread limit of %u, stepping single threaded\n",
+                    num_workers, BT_MAX_THREAD_COUNT);
+            mt = false;
+        }
+
+        // broadphase
+        if (config.broadphase == BROADPHASE_DBVT)
+        {
+            s_bullet_systems.olp_cache = new btDbvtBroadphase();
+        }
+        else
+        {
+            btVector3 world_min = from_vec3(config.world_min);
+            btVector3 world_max = from_vec3(config.world_max);
+
+            if (config.max_handles > 0xffff)
+                s_bullet_systems.olp_cache = new bt32BitAxisSweep3(world_min, world_max, config.max_handles);
+            else
+                s_bullet_systems.olp_cache = new btAxisSweep3(world_min, world_max, (u16)config.max_handles);
+        }
+
+        if (!mt)
+        {
+            s_bullet_systems.task_scheduler = nullptr;
+            s_bullet_systems.collision_config = new btDefaultCollisionConfiguration();
+            s_bullet_systems.dispatcher = new btCollisionDispatcher(s_bullet_systems.collision_config);
+            s_bullet_systems.solver = new btSequentialImpulseConstraintSolver;
+            s_bullet_systems.dynamics_world =
+                new btDiscreteDynamicsWorld(s_bullet_systems.dispatcher, s_bullet_systems.olp_cache,
+                                            s_bullet_systems.solver, s_bullet_systems.collision_config);
+        }
+        else
+        {
+            // must be set from this thread before any Mt objects are created, it becomes bullet's main thread
+            s_bullet_systems.task_scheduler = new pen_task_scheduler();
+            btSetTaskScheduler(s_bullet_systems.task_scheduler);
+
+            // pools are shared between threads so they need to be large enough not to fall back to the heap
+            btDefaultCollisionConstructionInfo cci;
+            cci.m_defaultMaxPersistentManifoldPoolSize = 80000;
+            cci.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
 
-        s_bullet_systems.collision_config = new btDefaultCollisionConfiguration();
-        s_bullet_systems.dispatcher = new btCollisionDispatcher(s_bullet_systems.collision_config);
-        s_bullet_systems.olp_cache = new btAxisSweep3(btVector3(-50.0f, -50.0f, -50.0f), btVector3(50.0f, 50.0f, 50.0f));
-        s_bullet_systems.solver = new btSequentialImpulseConstraintSolver;
-        s_bullet_systems.dynamics_world =
-            new btDiscreteDynamicsWorld(s_bullet_systems.dispatcher, s_bullet_systems.olp_cache, s_bullet_systems.solver,
-                                        s_bullet_systems.collision_config);
+            s_bullet_systems.collision_config = new btDefaultCollisionConfiguration(cci);
+            s_bullet_systems.dispatcher = new btCollisionDispatcherMt(s_bullet_systems.collision_config, 40);
+
+            btConstraintSolverPoolMt* solver_pool =
+                new btConstraintSolverPoolMt(s_bullet_systems.task_scheduler->getNumThreads());
+
+            s_bullet_systems.solver = solver_pool;
+            s_bullet_systems.dynamics_world = new btDiscreteDynamicsWorldMt(
+                s_bullet_systems.dispatcher, s_bullet_systems.olp_cache, solver_pool, s_bullet_systems.collision_config);
+        }
 
         s_bullet_systems.dynamics_world->setGravity(btVector3(0, -10, 0));
     }
 
-    void update_output_matrices()
+    enum e_body_flags : u8
+    {
+        BODY_PREV_VALID = 1 << 0, // prev_transforms holds the state before the last fixed step
+        BODY_WAS_ACTIVE = 1 << 1  // active at the last publish, sleeping bodies get one final write
+    };
+
+    struct fixed_step_state
+    {
+        f32 fixed_step = 1.0f / 60.0f;
+        u32 max_substeps = 4;
+        f32 accumulator = 0.0f;
+        u32 frame = 0;
+
+        u32* bodies = nullptr;  // dense list of rigid and compound body slots
+        u32* pending = nullptr; // slots to publish regardless of activity, adds and teleports
+
+        // per slot
+        maths::transform* prev_transforms = nullptr;
+        u32*              body_index = nullptr; // position in bodies
+        u32*              publish_frame = nullptr;
+        u8*               flags = nullptr; // e_body_flags
+        u32               capacity = 0;
+    };
+    static fixed_step_state s_step;
+
+    void reserve_body_state()
     {
-        mat4*&             bb_mats = g_readable_data.output_matrices.backbuffer();
-        maths::transform*& bb_transforms = g_readable_data.output_transforms.backbuffer();
+        u32 num = s_entities._capacity;
+        if (s_step.capacity >= num)
+            return;
+
+        u32 cap = s_step.capacity;
+        u32 grow = num - cap;
 
-        u32 num = sb_count(bb_mats);
+        s_step.prev_transforms = (maths::transform*)pen::memory_realloc(s_step.prev_transforms, sizeof(maths::transform) * num);
+        s_step.body_index = (u32*)pen::memory_realloc(s_step.body_index, sizeof(u32) * num);
+        s_step.publish_frame = (u32*)pen::memory_realloc(s_step.publish_frame, sizeof(u32) * num);
+        s_step.flags = (u8*)pen::memory_realloc(s_step.flags, num);
+
+        memset(&s_step.body_index[cap], 0xff, sizeof(u32) * grow);
+        memset(&s_step.publish_frame[cap], 0x0, sizeof(u32) * grow);
+        memset(&s_step.flags[cap], 0x0, grow);
+
+        s_step.capacity = num;
+    }
 
-        for (u32 i = 0; i < s_entities._capacity; i++)
+    void reserve_output(rb_output& output, u32 num)
+    {
+        if (output.capacity >= num)
+            return;
+
+        u32 cap = output.capacity;
+
+        output.translations = (vec3f*)pen::memory_realloc(output.translations, sizeof(vec3f) * num);
+        output.rotations = (quat*)pen::memory_realloc(output.rotations, sizeof(quat) * num);
+        output.frames = (u32*)pen::memory_realloc(output.frames, sizeof(u32) * num);
+
+        memset(&output.frames[cap], 0x0, sizeof(u32) * (num - cap));
+
+        output.capacity = num;
+    }
+
+    void reset_interpolation(u32 entity_index)
+    {
+        reserve_body_state();
+
+        s_step.flags[entity_index] &= ~BODY_PREV_VALID;
+        sb_push(s_step.pending, entity_index);
+
+        physics_entity&  entity = s_entities.get(entity_index);
+        btCompoundShape* p_compound = entity.compound_shape;
+        if (entity.type != ENTITY_COMPOUND_RIGID_BODY || !p_compound)
+            return;
+
+        u32 num_shapes = p_compound->getNumChildShapes();
+        for (u32 j = 0; j < num_shapes; ++j)
         {
-            if (i >= num)
+            u32 ph = p_compound->getChildShape(j)->getUserIndex();
+            if (ph < s_step.capacity)
+                s_step.flags[ph] &= ~BODY_PREV_VALID;
+        }
+    }
+
+    void add_body(u32 entity_index)
+    {
+        reserve_body_state();
+
+        if (!is_valid(s_step.body_index[entity_index]))
+        {
+            s_step.body_index[entity_index] = sb_count(s_step.bodies);
+            sb_push(s_step.bodies, entity_index);
+        }
+
+        s_step.flags[entity_index] = 0;
+        reset_interpolation(entity_index);
+    }
+
+    void remove_body(u32 entity_index)
+    {
+        if (entity_index >= s_step.capacity)
+            return;
+
+        u32 i = s_step.body_index[entity_index];
+        if (!is_valid(i))
+            return;
+
+        // swap with the last
+        u32 last = sb_last(s_step.bodies);
+        s_step.bodies[i] = last;
+        s_step.body_index[last] = i;
+        stb__sbn(s_step.bodies)--;
+
+        s_step.body_index[entity_index] = -1;
+    }
+
+    void store_previous_transforms()
+    {
+        u32 num_bodies = sb_count(s_step.bodies);
+        for (u32 i = 0; i < num_bodies; ++i)
+        {
+            u32             slot = s_step.bodies[i];
+            physics_entity& entity = s_entities.get(slot);
+            btRigidBody*    p_rb = entity.rb.rigid_body;
+
+            if (!p_rb || !p_rb->isActive())
             {
-                ++num;
-                sb_push(bb_mats, mat4::create_identity());
-                sb_push(bb_transforms, maths::transform());
+                // woken bodies start from their current transform
+                s_step.flags[slot] &= ~BODY_PREV_VALID;
+                continue;
             }
 
-            physics_entity& entity = s_entities.get(i);
+            btTransform rb_transform = p_rb->getWorldTransform();
+            s_step.prev_transforms[slot] = from_bttransform(rb_transform);
+            s_step.flags[slot] |= BODY_PREV_VALID;
+
+            btCompoundShape* p_compound = entity.compound_shape;
+            if (entity.type != ENTITY_COMPOUND_RIGID_BODY || !p_compound)
+                continue;
 
-            switch (entity.type)
+            u32 num_shapes = p_compound->getNumChildShapes();
+            for (u32 j = 0; j < num_shapes; ++j)
             {
-                case ENTITY_RIGID_BODY:
-                {
-                    btRigidBody* p_rb = entity.rb.rigid_body;
-                    if (!p_rb)
-                        continue;
+                u32 ph = p_compound->getChildShape(j)->getUserIndex();
+                if (ph >= s_step.capacity)
+                    continue;
 
-                    btTransform rb_transform = p_rb->getWorldTransform();
+                s_step.prev_transforms[ph] = from_bttransform(rb_transform * p_compound->getChildTransform(j));
+                s_step.flags[ph] |= BODY_PREV_VALID;
+            }
+        }
+    }
 
-                    btScalar _mm[16];
+    void write_output(rb_output& output, u32 slot, const btTransform& bt, f32 alpha)
+    {
+        if (slot >= output.capacity)
+            return;
 
-                    rb_transform.getOpenGLMatrix(_mm);
+        maths::transform t = from_bttransform(bt);
 
-                    for (s32 m = 0; m < 16; ++m)
-                        bb_mats[i].m[m] = _mm[m];
+        // blend from the previous fixed step by the time left in the accumulator
+        if (s_step.flags[slot] & BODY_PREV_VALID)
+        {
+            const maths::transform& pt = s_step.prev_transforms[slot];
+            t.translation = lerp(pt.translation, t.translation, alpha);
+            t.rotation = slerp2(pt.rotation, t.rotation, alpha);
+        }
 
-                    bb_mats[i].transpose();
-                    bb_transforms[i] = from_bttransform(rb_transform);
-                }
-                break;
+        output.translations[slot] = t.translation;
+        output.rotations[slot] = t.rotation;
+        output.frames[slot] = s_step.frame;
+        sb_push(output.changed, slot);
 
-                case ENTITY_COMPOUND_RIGID_BODY:
-                {
-                    btCompoundShape* p_compound = entity.compound_shape;
-                    btRigidBody*     p_rb = entity.rb.rigid_body;
+        s_step.publish_frame[slot] = s_step.frame;
+    }
 
-                    btTransform rb_transform = p_rb->getWorldTransform();
+    void publish_body(rb_output& output, u32 slot, f32 alpha)
+    {
+        physics_entity& entity = s_entities.get(slot);
+        if (entity.type != ENTITY_RIGID_BODY && entity.type != ENTITY_COMPOUND_RIGID_BODY)
+            return;
 
-                    btScalar _mm[16];
+        btRigidBody* p_rb = entity.rb.rigid_body;
+        if (!p_rb)
+            return;
 
-                    rb_transform.getOpenGLMatrix(_mm);
+        btTransform rb_transform = p_rb->getWorldTransform();
+        write_output(output, slot, rb_transform, alpha);
 
-                    for (s32 m = 0; m < 16; ++m)
-                        bb_mats[i].m[m] = _mm[m];
+        btCompoundShape* p_compound = entity.compound_shape;
+        if (entity.type != ENTITY_COMPOUND_RIGID_BODY || !p_compound)
+            return;
 
-                    bb_mats[i].transpose();
+        u32 num_shapes = p_compound->getNumChildShapes();
+        for (u32 j = 0; j < num_shapes; ++j)
+        {
+            u32 ph = p_compound->getChildShape(j)->getUserIndex();
+            if (!is_valid(ph))
+                continue;
 
-                    if (p_compound)
-                    {
-                        u32 num_shapes = p_compound->getNumChildShapes();
-                        for (u32 j = 0; j < num_shapes; ++j)
-                        {
-                            if (p_rb)
-                            {
-                                btTransform       base = p_rb->getWorldTransform();
-                                btTransform       child = p_compound->getChildTransform(j);
-                                btCollisionShape* shape = p_compound->getChildShape(j);
-                                u32               ph = shape->getUserIndex();
+            write_output(output, ph, rb_transform * p_compound->getChildTransform(j), alpha);
+        }
+    }
 
-                                if (!is_valid(ph))
-                                    continue;
+    void publish_output(f32 alpha)
+    {
+        rb_output&       bb = g_readable_data.output.backbuffer();
+        const rb_output& fb = g_readable_data.output.frontbuffer();
 
-                                btTransform child_world = base * child;
+        reserve_body_state();
+        reserve_output(bb, s_entities._capacity);
 
-                                btScalar _mm[16];
+        // the back buffer missed the last publish, bring it up to date with just those bodies
+        u32 num_changed = sb_count(fb.changed);
+        for (u32 i = 0; i < num_changed; ++i)
+        {
+            u32 slot = fb.changed[i];
+            bb.translations[slot] = fb.translations[slot];
+            bb.rotations[slot] = fb.rotations[slot];
+            bb.frames[slot] = fb.frames[slot];
+        }
 
-                                child_world.getOpenGLMatrix(_mm);
+        if (bb.changed)
+            stb__sbn(bb.changed) = 0;
 
-                                for (s32 m = 0; m < 16; ++m)
-                                    bb_mats[ph].m[m] = _mm[m];
+        ++s_step.frame;
 
-                                bb_mats[ph].transpose();
-                                bb_transforms[ph] = from_bttransform(child_world);
-                            }
-                        }
-                    }
-                }
-                break;
+        // sleeping bodies cost nothing here
+        u32 num_bodies = sb_count(s_step.bodies);
+        for (u32 i = 0; i < num_bodies; ++i)
+        {
+            u32          slot = s_step.bodies[i];
+            btRigidBody* p_rb = s_entities.get(slot).rb.rigid_body;
+            if (!p_rb)
+                continue;
 
-                default:
-                    break;
-            }
+            u8&  flags = s_step.flags[slot];
+            bool active = p_rb->isActive();
+
+            if (!active && !(flags & BODY_WAS_ACTIVE))
+                continue;
+
+            // a body falling asleep gets a final write at its resting transform
+            publish_body(bb, slot, active ? alpha : 1.0f);
+
+            if (active)
+                flags |= BODY_WAS_ACTIVE;
+            else
+                flags &= ~BODY_WAS_ACTIVE;
         }
 
-        g_readable_data.output_matrices.swap_buffers();
-        g_readable_data.output_transforms.swap_buffers();
+        u32 num_pending = sb_count(s_step.pending);
+        for (u32 i = 0; i < num_pending; ++i)
+        {
+            u32 slot = s_step.pending[i];
+            if (s_step.publish_frame[slot] != s_step.frame)
+                publish_body(bb, slot, alpha);
+        }
+
+        if (s_step.pending)
+            stb__sbn(s_step.pending) = 0;
+
+        bb.frame = s_step.frame;
+        g_readable_data.output.swap_buffers();
     }
 
-    void physics_update(f32 dt)
+    void physics_update(f32 dt, physics_stats& stats)
     {
-        // step
+        static pen::timer* step_timer = pen::timer_create();
+
+        f32 fixed_step = s_step.fixed_step;
+
+        stats.substeps = 0;
+        stats.dropped_substeps = 0;
+        stats.step_ms = 0.0f;
+
         if (!g_readable_data.b_paused)
-            s_bullet_systems.dynamics_world->stepSimulation(dt);
+        {
+            s_step.accumulator += dt;
 
-        // update mats
-        update_output_matrices();
+            u32 num_steps = (u32)(s_step.accumulator / fixed_step);
+            if (num_steps > s_step.max_substeps)
+            {
+                // drop time we cannot catch up on rather than spiral into ever longer frames
+                stats.dropped_substeps = num_steps - s_step.max_substeps;
+                num_steps = s_step.max_substeps;
+            }
+
+            pen::timer_start(step_timer);
+
+            for (u32 i = 0; i < num_steps; ++i)
+            {
+                // only the state before the final step is needed to interpolate from
+                if (i == num_steps - 1)
+                    store_previous_transforms();
+
+                s_bullet_systems.dynamics_world->stepSimulation(fixed_step, 0);
+            }
+
+            stats.step_ms = pen::timer_elapsed_ms(step_timer);
+            stats.substeps = num_steps;
+
+            s_step.accumulator = min(s_step.accumulator - (f32)num_steps * fixed_step, fixed_step);
+        }
+
+        stats.interpolation = s_step.accumulator / fixed_step;
+
+        publish_output(stats.interpolation);
+    }
+
+    void set_timestep_internal(const set_timestep_params& cmd)
+    {
+        s_step.fixed_step = cmd.fixed_step;
+        s_step.max_substeps = max(cmd.max_substeps, (u32)1);
+        s_step.accumulator = min(s_step.accumulator, s_step.fixed_step);
     }
 
     void add_rb_internal(const rigid_body_params& params, u32 resource_slot, bool ghost)
@@ -384,6 +690,8 @@ namespace physics
         PEN_ASSERT(rb);
 
         entity.type = ENTITY_RIGID_BODY;
+
+        add_body(resource_slot);
     }
 
     void add_compound_rb_internal(const compound_rb_cmd& cmd, u32 resource_slot)
@@ -413,6 +721,8 @@ namespace physics
         entity.mask = cmd.params.base.mask;
 
         entity.type = ENTITY_COMPOUND_RIGID_BODY;
+
+        add_body(resource_slot);
     }
 
     void add_compound_shape_internal(const compound_rb_params& params, u32 resource_slot)
@@ -598,7 +908,11 @@ namespace physics
             {
                 rb->getMotionState()->setWorldTransform(bt_trans);
                 rb->setCenterOfMassTransform(bt_trans);
+                rb->activate();
             }
+
+            // teleport, don't interpolate from the old position
+            reset_interpolation(cmd.object_index);
         }
     }
 
@@ -912,6 +1226,8 @@ namespace physics
 
     void release_entity_internal(u32 entity_index)
     {
+        remove_body(entity_index);
+
         if (s_entities.get(entity_index).type == ENTITY_RIGID_BODY)
         {
             remove_from_world_internal(entity_index);
@@ -943,65 +1259,89 @@ namespace physics
         s_bullet_systems.dynamics_world->addRigidBody(pe.rb.rigid_body, pe.group, pe.mask);
     }
 
-    void cast_ray_internal(const ray_cast_params& rcp)
+    void ray_test(const vec3f& start, const vec3f& end, u32 mask, u32 group, query_result& qr)
     {
-        btVector3 from = from_vec3(rcp.start);
-        btVector3 to = from_vec3(rcp.end);
+        btVector3 from = from_vec3(start);
+        btVector3 to = from_vec3(end);
 
         btCollisionWorld::ClosestRayResultCallback ray_callback(from, to);
-        ray_callback.m_collisionFilterMask = rcp.mask;
-        ray_callback.m_collisionFilterGroup = rcp.group;
+        ray_callback.m_collisionFilterMask = mask;
+        ray_callback.m_collisionFilterGroup = group;
 
-        ray_cast_result rcr;
-        rcr.user_data = rcp.user_data;
+        qr.physics_handle = -1;
+        qr.fraction = 1.0f;
 
-        rcr.physics_handle = -1;
         s_bullet_systems.dynamics_world->rayTest(from, to, ray_callback);
         if (ray_callback.hasHit())
         {
-            rcr.point = from_btvector(ray_callback.m_hitPointWorld);
-            rcr.normal = from_btvector(ray_callback.m_hitNormalWorld);
+            qr.point = from_btvector(ray_callback.m_hitPointWorld);
+            qr.normal = from_btvector(ray_callback.m_hitNormalWorld);
+            qr.fraction = ray_callback.m_closestHitFraction;
 
             btRigidBody* body = (btRigidBody*)btRigidBody::upcast(ray_callback.m_collisionObject);
 
             if (body)
-                rcr.physics_handle = body->getUserIndex();
+                qr.physics_handle = body->getUserIndex();
         }
-
-        rcp.callback(rcr);
     }
 
-    void cast_sphere_internal(const sphere_cast_params& scp)
+    void sphere_test(const vec3f& start, const vec3f& end, f32 radius, u32 mask, u32 group, query_result& qr)
     {
-        btTransform from = get_bttransform(scp.from, quat());
-        btTransform to = get_bttransform(scp.to, quat());
+        btTransform from = get_bttransform(start, quat());
+        btTransform to = get_bttransform(end, quat());
 
-        btVector3 vfrom = from_vec3(scp.from);
-        btVector3 vto = from_vec3(scp.to);
+        btVector3 vfrom = from_vec3(start);
+        btVector3 vto = from_vec3(end);
 
-        btSphereShape shape = btSphereShape(btScalar(scp.dimension.x));
+        btSphereShape shape = btSphereShape(btScalar(radius));
 
         btCollisionWorld::ClosestConvexResultCallback cast_callback =
             btCollisionWorld::ClosestConvexResultCallback(vfrom, vto);
-        cast_callback.m_collisionFilterMask = scp.mask;
-        cast_callback.m_collisionFilterGroup = scp.group;
+        cast_callback.m_collisionFilterMask = mask;
+        cast_callback.m_collisionFilterGroup = group;
 
-        s_bullet_systems.dynamics_world->convexSweepTest((btConvexShape*)&shape, from, to, cast_callback);
+        qr.physics_handle = -1;
+        qr.fraction = 1.0f;
 
-        sphere_cast_result sr;
-        sr.user_data = scp.user_data;
+        s_bullet_systems.dynamics_world->convexSweepTest((btConvexShape*)&shape, from, to, cast_callback);
 
-        sr.physics_handle = -1;
         if (cast_callback.hasHit())
         {
             btRigidBody* body = (btRigidBody*)btRigidBody::upcast(cast_callback.m_hitCollisionObject);
 
             if (body)
-                sr.physics_handle = body->getUserIndex();
+                qr.physics_handle = body->getUserIndex();
 
-            sr.point = from_btvector(cast_callback.m_hitPointWorld);
-            sr.normal = from_btvector(cast_callback.m_hitNormalWorld);
+            qr.point = from_btvector(cast_callback.m_hitPointWorld);
+            qr.normal = from_btvector(cast_callback.m_hitNormalWorld);
+            qr.fraction = cast_callback.m_closestHitFraction;
         }
+    }
+
+    void cast_ray_internal(const ray_cast_params& rcp)
+    {
+        query_result qr;
+        ray_test(rcp.start, rcp.end, rcp.mask, rcp.group, qr);
+
+        ray_cast_result rcr;
+        rcr.user_data = rcp.user_data;
+        rcr.physics_handle = qr.physics_handle;
+        rcr.point = qr.point;
+        rcr.normal = qr.normal;
+
+        rcp.callback(rcr);
+    }
+
+    void cast_sphere_internal(const sphere_cast_params& scp)
+    {
+        query_result qr;
+        sphere_test(scp.from, scp.to, scp.dimension.x, scp.mask, scp.group, qr);
+
+        sphere_cast_result sr;
+        sr.user_data = scp.user_data;
+        sr.physics_handle = qr.physics_handle;
+        sr.point = qr.point;
+        sr.normal = qr.normal;
 
         scp.callback(sr);
     }
@@ -1033,6 +1373,37 @@ namespace physics
         }
     };
 
+    // keeps only the deepest contact, used by batches so they don't allocate
+    class deepest_contact_processor : public btCollisionWorld::ContactResultCallback
+    {
+      public:
+        btRigidBody*  ref_rb;
+        query_result* qr;
+
+        btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0,
+                                 const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1)
+        {
+            if (is_valid(qr->physics_handle) && cp.getDistance() >= qr->fraction)
+                return 0.0f;
+
+            const btCollisionObject* other = colObj1Wrap->getCollisionObject();
+            if (ref_rb == colObj0Wrap->getCollisionObject())
+            {
+                qr->point = from_btvector(cp.m_positionWorldOnB);
+            }
+            else
+            {
+                qr->point = from_btvector(cp.m_positionWorldOnA);
+                other = colObj0Wrap->getCollisionObject();
+            }
+
+            qr->normal = from_btvector(cp.m_normalWorldOnB);
+            qr->fraction = cp.getDistance();
+            qr->physics_handle = other->getUserIndex();
+            return 0.0f;
+        }
+    };
+
     void contact_test_internal(const contact_test_params& ctp)
     {
         btRigidBody* rb = s_entities.get(ctp.entity).rb.rigid_body;
@@ -1048,6 +1419,64 @@ namespace physics
 
         ctp.callback(cb.ctr);
     }
+
+    void contact_test(u32 entity_index, query_result& qr)
+    {
+        qr.physics_handle = -1;
+        qr.fraction = 0.0f;
+
+        btRigidBody* rb = s_entities.get(entity_index).rb.rigid_body;
+        if (!rb)
+            return;
+
+        deepest_contact_processor cb;
+        cb.ref_rb = rb;
+        cb.qr = &qr;
+
+        s_bullet_systems.dynamics_world->contactTest((btCollisionObject*)rb, cb);
+    }
+
+    static const u32 k_query_grain = 64;
+
+    void query_batch_range(u32 start, u32 end, void* user_data)
+    {
+        query_batch* batch = (query_batch*)user_data;
+
+        for (u32 i = start; i < end; ++i)
+        {
+            const query&  q = batch->queries[i];
+            query_result& qr = batch->results[i];
+
+            switch (batch->type)
+            {
+                case QUERY_RAY:
+                    ray_test(q.from, q.to, q.mask, q.group, qr);
+                    break;
+                case QUERY_SPHERE:
+                    sphere_test(q.from, q.to, q.radius, q.mask, q.group, qr);
+                    break;
+                case QUERY_CONTACT:
+                    contact_test(q.entity, qr);
+                    break;
+                default:
+                    qr.physics_handle = -1;
+                    break;
+            }
+        }
+    }
+
+    void query_batch_internal(query_batch* batch)
+    {
+        // ray and sphere tests only read the world, which is not modified while commands execute, so they can run on
+        // many threads. contact tests create and release manifolds on the shared dispatcher which is not locked, so
+        // they run on the physics thread
+        if (batch->type == QUERY_CONTACT)
+            query_batch_range(0, batch->count, batch);
+        else
+            pen::parallel_for(batch->count, k_query_grain, query_batch_range, batch);
+
+        batch->pending = 0;
+    }
 } // namespace physics
 
 #if PICKING_REFERENCE // reference
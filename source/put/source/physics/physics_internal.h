@@ -17,6 +17,11 @@
 #include "BulletDynamics/Featherstone/btMultiBodyPoint2Point.h"
 #include "btBulletDynamicsCommon.h"
 
+// for multi threaded bullet
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
+
 namespace physics
 {
     enum e_entity_type
@@ -95,6 +100,7 @@ namespace physics
         btBroadphaseInterface*           olp_cache;
         btConstraintSolver*              solver;
         btDynamicsWorld*                 dynamics_world;
+        btITaskScheduler*                task_scheduler;
     };
 
     struct bullet_objects
@@ -118,15 +124,15 @@ namespace physics
             b_paused = 0;
         }
 
-        a_u32                                   b_paused;
-        pen::multi_buffer<mat4*, 2>             output_matrices;
-        pen::multi_buffer<maths::transform*, 2> output_transforms;
+        a_u32                               b_paused;
+        pen::multi_buffer<rb_output, 2>     output;
+        pen::multi_buffer<physics_stats, 2> stats;
     };
 
     extern readable_data g_readable_data;
 
-    void physics_update(f32 dt);
-    void physics_initialise();
+    void physics_update(f32 dt, physics_stats& stats);
+    void physics_initialise(const physics_config& config);
 
     btRigidBody* create_rb_internal(physics_entity& entity, const rigid_body_params& params, u32 ghost,
                                     btCollisionShape* p_existing_shape = NULL);
@@ -156,6 +162,7 @@ namespace physics
     void set_group_internal(const set_group_params& cmd);
     void set_damping_internal(const set_v3_params& cmd);
     void set_p2p_constraint_pos_internal(const set_v3_params& cmd);
+    void set_timestep_internal(const set_timestep_params& cmd);
 
     void sync_rigid_bodies_internal(const sync_rb_params& cmd);
     void sync_rigid_body_velocity_internal(const sync_rb_params& cmd);
@@ -171,6 +178,7 @@ namespace physics
     void cast_ray_internal(const ray_cast_params& rcp);
     void cast_sphere_internal(const sphere_cast_params& ccp);
     void contact_test_internal(const contact_test_params& ctp);
+    void query_batch_internal(query_batch* batch);
 
     void add_central_force(const set_v3_params& cmd);
     void add_central_impulse(const set_v3_params& cmd);
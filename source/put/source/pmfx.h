@@ -58,6 +58,9 @@ namespace put
         u32             permutation = 0;
         ecs::ecs_scene* scene = nullptr;
         bool            viewport_correction = false;
+        hash_id         id_name = 0;
+        const u32*      visible_entities = nullptr; // optional pre culled entity list, render_scene_view culls if null
+        u32             num_visible_entities = 0;
     };
 
     struct scene_view_renderer
@@ -2653,6 +2653,7 @@ namespace put
         {
             scene_view sv;
             sv.scene = v.scene;
+            sv.id_name = v.id_name;
             for (s32 rf = 0; rf < v.render_functions.size(); ++rf)
                 v.render_functions[rf](sv);
         }
@@ -2770,6 +2771,7 @@ namespace put
             sv.cb_2d_view = cb_2d;
             sv.pmfx_shader = v.pmfx_shader;
             sv.permutation = v.technique_permutation;
+            sv.id_name = v.id_name;
 
             // render passes.. multi pass for cubemaps or arrays
             for (u32 a = 0; a < v.num_arrays; ++a)
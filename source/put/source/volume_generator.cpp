@@ -272,27 +272,26 @@ namespace put
             current_slice++;
         }
 
-        PEN_TRV raster_voxel_combine(void* params)
+        struct vgt_combine_pass
         {
-            pen::job_thread_params* job_params = (pen::job_thread_params*)params;
-            vgt_rasteriser_job*     rasteriser_job = (vgt_rasteriser_job*)job_params->user_data;
-            pen::job*               p_thread_info = job_params->job_info;
-            pen::semaphore_post(p_thread_info->p_sem_continue, 1);
+            vgt_rasteriser_job* rasteriser_job;
+            u8*                 volume_data;
+            u32                 row_pitch;
+            u32                 slice_pitch;
+        };
+
+        void raster_combine_slices(u32 start, u32 end, void* user_data)
+        {
+            vgt_combine_pass*   pass = (vgt_combine_pass*)user_data;
+            vgt_rasteriser_job* rasteriser_job = pass->rasteriser_job;
 
             u32&    volume_dim = rasteriser_job->dimension;
             void*** volume_slices = rasteriser_job->volume_slices;
+            u8*     volume_data = pass->volume_data;
+            u32     row_pitch = pass->row_pitch;
+            u32     slice_pitch = pass->slice_pitch;
 
-            // create a simple 3d texture
-            rasteriser_job->block_size = 4;
-            rasteriser_job->data_size = volume_dim * volume_dim * volume_dim * rasteriser_job->block_size;
-
-            u8* volume_data = (u8*)pen::memory_alloc(rasteriser_job->data_size);
-            u32 row_pitch = volume_dim * rasteriser_job->block_size;
-            u32 slice_pitch = volume_dim * row_pitch;
-
-            rasteriser_job->combine_position = 0;
-
-            for (u32 z = 0; z < volume_dim; ++z)
+            for (u32 z = start; z < end; ++z)
             {
                 if (g_cancel_volume_job)
                     break;
@@ -305,10 +304,10 @@ namespace put
 
                 for (u32 y = 0; y < volume_dim; ++y)
                 {
+                    rasteriser_job->combine_position += volume_dim;
+
                     for (u32 x = 0; x < volume_dim; ++x)
                     {
-                        rasteriser_job->combine_position++;
-
                         u32 offset = z * slice_pitch + y * row_pitch + x * rasteriser_job->block_size;
 
                         u8 rgba[4] = {0};
@@ -332,15 +331,33 @@ namespace put
                     }
                 }
             }
+        }
+
+        void raster_voxel_combine(void* user_data)
+        {
+            vgt_rasteriser_job* rasteriser_job = (vgt_rasteriser_job*)user_data;
+
+            u32& volume_dim = rasteriser_job->dimension;
+
+            // create a simple 3d texture
+            rasteriser_job->block_size = 4;
+            rasteriser_job->data_size = volume_dim * volume_dim * volume_dim * rasteriser_job->block_size;
+
+            u8* volume_data = (u8*)pen::memory_alloc(rasteriser_job->data_size);
+            u32 row_pitch = volume_dim * rasteriser_job->block_size;
+            u32 slice_pitch = volume_dim * row_pitch;
+
+            rasteriser_job->combine_position = 0;
+
+            // slices are independent, combine them across the worker pool
+            vgt_combine_pass pass = {rasteriser_job, volume_data, row_pitch, slice_pitch};
+            pen::parallel_for(volume_dim, 1, raster_combine_slices, &pass);
 
             if (g_cancel_volume_job)
             {
                 pen::memory_free(volume_data);
                 g_cancel_handled = true;
-
-                pen::semaphore_post(p_thread_info->p_sem_continue, 1);
-                pen::semaphore_post(p_thread_info->p_sem_terminated, 1);
-                return PEN_THREAD_OK;
+                return;
             }
 
             // with the 3d texture now initialised, dilate colour edges so we can use bilinear
@@ -398,10 +415,6 @@ namespace put
 
             rasteriser_job->generated_volume_index = sb_count(s_generated_volumes) - 1;
             rasteriser_job->combine_in_progress = 2;
-
-            pen::semaphore_post(p_thread_info->p_sem_continue, 1);
-            pen::semaphore_post(p_thread_info->p_sem_terminated, 1);
-            return PEN_THREAD_OK;
         }
 
         void generate_mips_r32f_simd(pen::texture_creation_params& tcp)
@@ -937,7 +950,11 @@ namespace put
             if (s_rasteriser_job.combine_in_progress == 0)
             {
                 s_rasteriser_job.combine_in_progress = 1;
-                pen::jobs_create_job(raster_voxel_combine, 1024 * 1024 * 1024, &s_rasteriser_job, pen::THREAD_START_DETACHED);
+
+                pen::task_decl task;
+                task.func = raster_voxel_combine;
+                task.user_data = &s_rasteriser_job;
+                pen::jobs_run_tasks(&task, 1);
                 return;
             }
             else
@@ -1100,13 +1117,9 @@ namespace put
             current_requested_slice = current_slice;
         }
 
-        PEN_TRV sdf_generate(void* params)
+        void sdf_generate(void* user_data)
         {
-            pen::job_thread_params* job_params = (pen::job_thread_params*)params;
-            vgt_sdf_job*            sdf_job = (vgt_sdf_job*)job_params->user_data;
-
-            pen::job* p_thread_info = job_params->job_info;
-            pen::semaphore_post(p_thread_info->p_sem_continue, 1);
+            vgt_sdf_job* sdf_job = (vgt_sdf_job*)user_data;
 
             u32 volume_dim = 1 << sdf_job->options.volume_dimension;
 
@@ -1219,10 +1232,7 @@ namespace put
                     g_mls_progress.triangles = 0;
                     pen::memory_free(volume_data);
                     g_cancel_handled = true;
-
-                    pen::semaphore_post(p_thread_info->p_sem_continue, 1);
-                    pen::semaphore_post(p_thread_info->p_sem_terminated, 1);
-                    return PEN_THREAD_OK;
+                    return;
                 }
 
                 for (u32 z = 0; z < volume_dim; ++z)
@@ -1260,15 +1270,7 @@ namespace put
 
             sb_push(s_generated_volumes, gv);
             sdf_job->generated_volume_index = sb_count(s_generated_volumes) - 1;
-
-            if (p_thread_info->p_completion_callback)
-                p_thread_info->p_completion_callback(nullptr);
-
             sdf_job->generate_in_progress = 2;
-
-            pen::semaphore_post(p_thread_info->p_sem_continue, 1);
-            pen::semaphore_post(p_thread_info->p_sem_terminated, 1);
-            return PEN_THREAD_OK;
         }
 
         ecs::ecs_scene* s_main_scene;
@@ -1442,7 +1444,10 @@ namespace put
                     s_sdf_job.scene = s_main_scene;
                     s_sdf_job.options = s_options;
 
-                    pen::jobs_create_job(sdf_generate, 1024 * 1024 * 1024, &s_sdf_job, pen::THREAD_START_DETACHED);
+                    pen::task_decl task;
+                    task.func = sdf_generate;
+                    task.user_data = &s_sdf_job;
+                    pen::jobs_run_tasks(&task, 1);
                     return;
                 }
 
@@ -49,6 +49,9 @@ project "bullet_monolithic"
 	}
 	
 	includedirs { "include" }
+
+	-- required for btDiscreteDynamicsWorldMt, put defines this too
+	defines { "BT_THREADSAFE=1" }
 				
 	configuration "Debug"
 		defines { "DEBUG" }
@@ -10,6 +10,10 @@ import models.helpers as helpers
 import models.parse_meshes as parse_meshes
 import models.parse_materials as parse_materials
 import models.parse_animations as parse_animations
+import models.compress_animations as compress_animations
+import models.optimise_meshes as optimise_meshes
+import models.quantize_vertices as quantize_vertices
+import models.simplify_meshes as simplify_meshes
 import models.parse_obj as parse_obj
 
 stats_start = time.time()
@@ -25,6 +29,10 @@ config = open("build_config.json")
 build_config = json.loads(config.read())
 
 model_dir = util.correct_path(build_config["models_dir"])
+compress_anims = build_config.get("compress_animations", True)
+optimise_meshes.enabled = build_config.get("optimise_meshes", True)
+quantize_vertices.enabled = build_config.get("quantize_vertices", False)
+simplify_meshes.enabled = build_config.get("generate_lods", True)
 
 schema = "{http://www.collada.org/2005/11/COLLADASchema}"
 transform_types = ["translate", "rotate", "matrix"]
@@ -281,6 +289,9 @@ for root, dirs, files in os.walk(model_dir):
             main_file = os.path.realpath(__file__)
             dependency_inputs.append(os.path.realpath(__file__))
             dependency_inputs.append(main_file.replace("build_models.py", os.path.join("models", "parse_obj.py")))
+            dependency_inputs.append(main_file.replace("build_models.py", os.path.join("models", "optimise_meshes.py")))
+            dependency_inputs.append(main_file.replace("build_models.py", os.path.join("models", "quantize_vertices.py")))
+            dependency_inputs.append(main_file.replace("build_models.py", os.path.join("models", "simplify_meshes.py")))
 
             file_info = dependencies.create_dependency_info(dependency_inputs, dependency_outputs)
             dependencies_directory["files"].append(file_info)
@@ -312,6 +323,10 @@ for root, dirs, files in os.walk(model_dir):
             dependency_inputs.append(os.path.realpath(__file__))
             models_lib = ["parse_materials.py",
                           "parse_animations.py",
+                          "compress_animations.py",
+                          "optimise_meshes.py",
+                          "quantize_vertices.py",
+                          "simplify_meshes.py",
                           "parse_meshes.py",
                           "parse_scene.py"]
 
@@ -332,7 +347,7 @@ for root, dirs, files in os.walk(model_dir):
             print("building " + f)
             parse_dae()
             helpers.output_file.write(base_out_file + ".pmm")
-            parse_animations.write_animation_file(base_out_file + ".pma")
+            compress_animations.write_animation_file(base_out_file + ".pma", compress_anims)
 
     if len(dependencies_directory["files"]) > 0:
         dependencies.write_to_file(dependencies_directory)
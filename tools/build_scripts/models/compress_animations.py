@@ -0,0 +1,255 @@
+import struct
+import math
+import os
+import models.helpers as helpers
+import models.parse_animations as parse_animations
+
+# compressed pma, written in place of the float version when every channel is a baked transform
+compressed_version_number = 2
+
+# tracks present in a compressed channel, keys are packed translation, scale then rotation
+track_translation = 1 << 0
+track_rotation = 1 << 1
+track_scale = 1 << 2
+
+# keys which can be rebuilt by interpolating their neighbours within these tolerances are removed
+translation_tolerance = 0.0005
+scale_tolerance = 0.0005
+rotation_tolerance = 0.0005  # radians
+
+stats = {"source_keys": 0, "compressed_keys": 0}
+
+
+def mag3(v):
+    return math.sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2])
+
+
+def quat_dot(a, b):
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]
+
+
+def quat_normalise(q):
+    m = math.sqrt(quat_dot(q, q))
+    if m == 0.0:
+        return [0.0, 0.0, 0.0, 1.0]
+    return [q[0] / m, q[1] / m, q[2] / m, q[3] / m]
+
+
+# rotation part of a row major matrix with the scale removed, x, y, z, w
+def quat_from_matrix(m, scale):
+    r = []
+    for row in range(3):
+        s = scale[row] if scale[row] != 0.0 else 1.0
+        r.append([m[row * 4 + 0] / s, m[row * 4 + 1] / s, m[row * 4 + 2] / s])
+    trace = r[0][0] + r[1][1] + r[2][2]
+    if trace > 0.0:
+        s = math.sqrt(trace + 1.0) * 2.0
+        q = [(r[2][1] - r[1][2]) / s, (r[0][2] - r[2][0]) / s, (r[1][0] - r[0][1]) / s, 0.25 * s]
+    elif r[0][0] > r[1][1] and r[0][0] > r[2][2]:
+        s = math.sqrt(1.0 + r[0][0] - r[1][1] - r[2][2]) * 2.0
+        q = [0.25 * s, (r[0][1] + r[1][0]) / s, (r[0][2] + r[2][0]) / s, (r[2][1] - r[1][2]) / s]
+    elif r[1][1] > r[2][2]:
+        s = math.sqrt(1.0 + r[1][1] - r[0][0] - r[2][2]) * 2.0
+        q = [(r[0][1] + r[1][0]) / s, 0.25 * s, (r[1][2] + r[2][1]) / s, (r[0][2] - r[2][0]) / s]
+    else:
+        s = math.sqrt(1.0 + r[2][2] - r[0][0] - r[1][1]) * 2.0
+        q = [(r[0][2] + r[2][0]) / s, (r[1][2] + r[2][1]) / s, 0.25 * s, (r[1][0] - r[0][1]) / s]
+    return quat_normalise(q)
+
+
+def slerp(a, b, t):
+    d = quat_dot(a, b)
+    if d < 0.0:
+        b = [-b[0], -b[1], -b[2], -b[3]]
+        d = -d
+    if d > 0.9995:
+        return quat_normalise([a[i] + (b[i] - a[i]) * t for i in range(4)])
+    theta = math.acos(d)
+    sa = math.sin((1.0 - t) * theta) / math.sin(theta)
+    sb = math.sin(t * theta) / math.sin(theta)
+    return [a[i] * sa + b[i] * sb for i in range(4)]
+
+
+def quat_angle(a, b):
+    d = min(abs(quat_dot(a, b)), 1.0)
+    return 2.0 * math.acos(d)
+
+
+# same row swap as helpers.write_corrected_4x4matrix
+def corrected_matrix(matrix_array):
+    m = [float(f) for f in matrix_array]
+    if helpers.author == "Maxypad":
+        return m[0:4] + m[8:12] + [-f for f in m[4:8]] + m[12:16]
+    return m
+
+
+# decompose baked transforms into translation, scale and rotation keys
+def decompose_matrices(matrices):
+    keys = []
+    prev_q = None
+    for m in matrices:
+        translation = [m[3], m[7], m[11]]
+        scale = [mag3(m[0:3]), mag3(m[4:7]), mag3(m[8:11])]
+        q = quat_from_matrix(m, scale)
+        # keep neighbouring keys in the same hemisphere so interpolation takes the short path
+        if prev_q and quat_dot(prev_q, q) < 0.0:
+            q = [-q[0], -q[1], -q[2], -q[3]]
+        prev_q = q
+        keys.append({"t": translation, "s": scale, "q": q})
+    return keys
+
+
+def key_reconstructed(times, keys, first, last, k):
+    span = times[last] - times[first]
+    it = (times[k] - times[first]) / span if span > 0.0 else 0.0
+    a = keys[first]
+    b = keys[last]
+    for i in range(3):
+        if abs(a["t"][i] + (b["t"][i] - a["t"][i]) * it - keys[k]["t"][i]) > translation_tolerance:
+            return False
+        if abs(a["s"][i] + (b["s"][i] - a["s"][i]) * it - keys[k]["s"][i]) > scale_tolerance:
+            return False
+    if quat_angle(slerp(a["q"], b["q"], it), keys[k]["q"]) > rotation_tolerance:
+        return False
+    return True
+
+
+# greedily extend each segment from the last kept key while every key it spans can be rebuilt
+def reduce_keys(times, keys):
+    num_keys = len(keys)
+    if num_keys <= 2:
+        return list(range(num_keys))
+    kept = [0]
+    for candidate in range(2, num_keys):
+        first = kept[-1]
+        for k in range(first + 1, candidate):
+            if not key_reconstructed(times, keys, first, candidate, k):
+                kept.append(candidate - 1)
+                break
+    kept.append(num_keys - 1)
+    return kept
+
+
+def track_range(keys, kept, name):
+    range_min = [min(keys[k][name][i] for k in kept) for i in range(3)]
+    range_max = [max(keys[k][name][i] for k in kept) for i in range(3)]
+    return range_min, [range_max[i] - range_min[i] for i in range(3)]
+
+
+def quantize_range(v, range_min, extent):
+    if extent <= 0.0:
+        return 0
+    return int(round(min(max((v - range_min) / extent, 0.0), 1.0) * 65535.0))
+
+
+# smallest three, the largest component is dropped and rebuilt from the unit length, its index goes in the top bits
+def quantize_quat(q):
+    largest = 0
+    for i in range(1, 4):
+        if abs(q[i]) > abs(q[largest]):
+            largest = i
+    if q[largest] < 0.0:
+        q = [-q[0], -q[1], -q[2], -q[3]]
+    packed = []
+    for i in range(4):
+        if i == largest:
+            continue
+        c = min(max(q[i] * math.sqrt(2.0), -1.0), 1.0)
+        packed.append(int(round((c * 0.5 + 0.5) * 32767.0)))
+    packed[0] |= (largest & 1) << 15
+    packed[1] |= (largest >> 1) << 15
+    return packed
+
+
+def find_source(channel, semantic):
+    for src in channel.sampler.sources:
+        if src.semantic == semantic:
+            return src
+    return None
+
+
+def can_compress():
+    if len(parse_animations.animation_channels) == 0:
+        return False
+    for channel in parse_animations.animation_channels:
+        bone = channel.target_bone.split('/')
+        if len(bone) < 2 or bone[1] != "transform":
+            return False
+        if not find_source(channel, "TIME") or not find_source(channel, "TRANSFORM"):
+            return False
+    return True
+
+
+def write_compressed_channel(output, channel):
+    times_src = find_source(channel, "TIME")
+    matrix_src = find_source(channel, "TRANSFORM")
+    times = [float(t) for t in times_src.data]
+    matrices = []
+    for f in range(matrix_src.offset, len(matrix_src.data), int(matrix_src.stride)):
+        matrices.append(corrected_matrix(matrix_src.data[f:f + 16]))
+    num_source_keys = min(len(times), len(matrices))
+    keys = decompose_matrices(matrices[:num_source_keys])
+    kept = reduce_keys(times, keys)
+
+    t_min, t_extent = track_range(keys, kept, "t")
+    s_min, s_extent = track_range(keys, kept, "s")
+
+    bone = channel.target_bone.split('/')
+    helpers.write_parsable_string(output, bone[0])
+    output.write(struct.pack("i", len(kept)))
+    output.write(struct.pack("i", track_translation | track_scale | track_rotation))
+    for k in kept:
+        output.write(struct.pack("f", times[k]))
+    for v in t_min + t_extent + s_min + s_extent:
+        output.write(struct.pack("f", v))
+
+    packed = []
+    for k in kept:
+        for i in range(3):
+            packed.append(quantize_range(keys[k]["t"][i], t_min[i], t_extent[i]))
+        for i in range(3):
+            packed.append(quantize_range(keys[k]["s"][i], s_min[i], s_extent[i]))
+        packed.extend(quantize_quat(keys[k]["q"]))
+
+    # pad to keep the file u32 aligned
+    if len(packed) % 2:
+        packed.append(0)
+    output.write(struct.pack("i", len(packed) // 2))
+    for p in packed:
+        output.write(struct.pack("H", p))
+
+    stats["source_keys"] += num_source_keys
+    stats["compressed_keys"] += len(kept)
+
+
+def write_compressed_animation_file(filename):
+    stats["source_keys"] = 0
+    stats["compressed_keys"] = 0
+
+    # write the float version alongside to report the real file sizes
+    v1_filename = filename + ".v1"
+    parse_animations.write_animation_file(v1_filename)
+    v1_bytes = os.path.getsize(v1_filename)
+    os.remove(v1_filename)
+
+    print("writing compressed: " + filename)
+    output = open(filename, 'wb+')
+    output.write(struct.pack("i", compressed_version_number))
+    output.write(struct.pack("i", len(parse_animations.animation_channels)))
+    for channel in parse_animations.animation_channels:
+        write_compressed_channel(output, channel)
+    output.close()
+
+    v2_bytes = os.path.getsize(filename)
+    if v2_bytes > 0:
+        ratio = float(v1_bytes) / float(v2_bytes)
+        print("    keys: " + str(stats["compressed_keys"]) + " / " + str(stats["source_keys"]) +
+              ", file: " + str(v2_bytes) + " / " + str(v1_bytes) +
+              " bytes (" + "{:.2f}".format(ratio) + ":1)")
+
+
+def write_animation_file(filename, compress):
+    if compress and can_compress():
+        write_compressed_animation_file(filename)
+    else:
+        parse_animations.write_animation_file(filename)
@@ -6,6 +6,7 @@ import os
 import util as util
 
 version_number = 1
+geometry_version_number = 3  # 2 adds vertex format, 3 adds lods
 anim_version_number = 1
 current_filename = ""
 author = ""
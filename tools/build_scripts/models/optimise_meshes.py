@@ -0,0 +1,212 @@
+# welds duplicate vertices, reorders triangles for the post transform cache (tipsify) and then for overdraw and
+# finally reorders vertices into fetch order. positions are 4 floats per vertex, vertex data is interleaved floats
+
+enabled = True
+cache_size = 16
+
+
+def acmr(indices, cache=cache_size):
+    num_tris = len(indices) // 3
+    if num_tris == 0:
+        return 0.0
+    fifo = []
+    misses = 0
+    for i in indices:
+        if i in fifo:
+            continue
+        misses += 1
+        fifo.append(i)
+        if len(fifo) > cache:
+            fifo.pop(0)
+    return float(misses) / float(num_tris)
+
+
+# identical position and vertex data collapse into a single vertex
+def weld(positions, vertices, indices):
+    num_vertices = len(positions) // 4
+    stride = len(vertices) // num_vertices
+    unique = dict()
+    remap = []
+    welded_positions = []
+    welded_vertices = []
+    for v in range(num_vertices):
+        key = tuple(positions[v * 4:v * 4 + 4] + vertices[v * stride:v * stride + stride])
+        if key not in unique:
+            unique[key] = len(unique)
+            welded_positions.extend(positions[v * 4:v * 4 + 4])
+            welded_vertices.extend(vertices[v * stride:v * stride + stride])
+        remap.append(unique[key])
+    return welded_positions, welded_vertices, [remap[i] for i in indices]
+
+
+# Sander, Nehab and Barczak 2007, returns reordered indices and the triangle index each cluster starts at, clusters
+# begin wherever the fan breaks and the next vertex comes from the dead end stack or the input order
+def tipsify(indices, num_vertices, cache=cache_size):
+    num_tris = len(indices) // 3
+    adjacency = [[] for v in range(num_vertices)]
+    for t in range(num_tris):
+        for i in range(3):
+            adjacency[indices[t * 3 + i]].append(t)
+
+    live = [len(a) for a in adjacency]
+    time_stamp = [0] * num_vertices
+    emitted = [False] * num_tris
+    dead_end = []
+    output = []
+    clusters = [0]
+
+    fan = 0
+    stamp = cache + 1
+    cursor = 1
+    while fan >= 0:
+        candidates = []
+        for t in adjacency[fan]:
+            if emitted[t]:
+                continue
+            for i in range(3):
+                v = indices[t * 3 + i]
+                output.append(v)
+                dead_end.append(v)
+                candidates.append(v)
+                live[v] -= 1
+                if stamp - time_stamp[v] > cache:
+                    time_stamp[v] = stamp
+                    stamp += 1
+            emitted[t] = True
+
+        # best candidate that will still be in the cache once its remaining triangles are emitted
+        fan = -1
+        best = -1
+        for v in candidates:
+            if live[v] <= 0:
+                continue
+            priority = 0
+            if stamp - time_stamp[v] + 2 * live[v] <= cache:
+                priority = stamp - time_stamp[v]
+            if priority > best:
+                best = priority
+                fan = v
+
+        if fan == -1:
+            while len(dead_end) > 0:
+                v = dead_end.pop()
+                if live[v] > 0:
+                    fan = v
+                    break
+            while fan == -1 and cursor < num_vertices:
+                if live[cursor] > 0:
+                    fan = cursor
+                cursor += 1
+            if fan != -1 and len(output) // 3 != clusters[-1]:
+                clusters.append(len(output) // 3)
+
+    return output, clusters
+
+
+def sub3(a, b):
+    return [a[0] - b[0], a[1] - b[1], a[2] - b[2]]
+
+
+def cross3(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+
+def dot3(a, b):
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+
+# draw clusters which face away from the mesh centre first so they occlude the ones behind them, the sort is view
+# independent and keeps each cluster intact so the vertex cache order inside it is preserved
+def order_clusters(positions, indices, clusters):
+    num_tris = len(indices) // 3
+    if len(clusters) < 2:
+        return indices
+
+    def pos(i):
+        return positions[i * 4:i * 4 + 3]
+
+    mesh_centre = [0.0, 0.0, 0.0]
+    area_total = 0.0
+    cluster_info = []
+    clusters = clusters + [num_tris]
+    for c in range(len(clusters) - 1):
+        centre = [0.0, 0.0, 0.0]
+        normal = [0.0, 0.0, 0.0]
+        area = 0.0
+        for t in range(clusters[c], clusters[c + 1]):
+            p0 = pos(indices[t * 3 + 0])
+            p1 = pos(indices[t * 3 + 1])
+            p2 = pos(indices[t * 3 + 2])
+            n = cross3(sub3(p1, p0), sub3(p2, p0))
+            a = dot3(n, n) ** 0.5
+            for i in range(3):
+                tc = (p0[i] + p1[i] + p2[i]) / 3.0
+                centre[i] += tc * a
+                normal[i] += n[i]
+            area += a
+        if area > 0.0:
+            for i in range(3):
+                mesh_centre[i] += centre[i]
+                centre[i] /= area
+        area_total += area
+        cluster_info.append((centre, normal, clusters[c], clusters[c + 1]))
+
+    if area_total > 0.0:
+        mesh_centre = [mesh_centre[i] / area_total for i in range(3)]
+
+    # winding is unknown here, flip so outward facing clusters score positive over the whole mesh
+    scores = [dot3(sub3(c[0], mesh_centre), c[1]) for c in cluster_info]
+    if sum(scores) < 0.0:
+        scores = [-s for s in scores]
+
+    order = sorted(range(len(cluster_info)), key=lambda c: scores[c], reverse=True)
+    output = []
+    for c in order:
+        output.extend(indices[cluster_info[c][2] * 3:cluster_info[c][3] * 3])
+    return output
+
+
+# vertices are renumbered in the order the index buffer first touches them
+def reorder_vertex_fetch(positions, vertices, indices):
+    num_vertices = len(positions) // 4
+    stride = len(vertices) // num_vertices
+    remap = [-1] * num_vertices
+    fetch_positions = []
+    fetch_vertices = []
+    next_index = 0
+    for i in indices:
+        if remap[i] == -1:
+            remap[i] = next_index
+            next_index += 1
+            fetch_positions.extend(positions[i * 4:i * 4 + 4])
+            fetch_vertices.extend(vertices[i * stride:i * stride + stride])
+    return fetch_positions, fetch_vertices, [remap[i] for i in indices]
+
+
+def buffer_size(positions, vertices, indices):
+    index_size = 2 if len(indices) < 65535 else 4
+    return (len(positions) + len(vertices)) * 4 + len(indices) * index_size
+
+
+def optimise_mesh(name, positions, vertices, indices):
+    if not enabled or len(indices) < 3 or len(positions) == 0:
+        return positions, vertices, indices
+
+    positions = [float(p) for p in positions]
+    vertices = [float(v) for v in vertices]
+
+    before_vertices = len(positions) // 4
+    before_acmr = acmr(indices)
+    before_size = buffer_size(positions, vertices, indices)
+
+    positions, vertices, indices = weld(positions, vertices, indices)
+    indices, clusters = tipsify(indices, len(positions) // 4)
+    indices = order_clusters(positions, indices, clusters)
+    positions, vertices, indices = reorder_vertex_fetch(positions, vertices, indices)
+
+    print("optimised mesh: " + name +
+          ", vertices: " + str(before_vertices) + " -> " + str(len(positions) // 4) +
+          ", acmr: " + "{:.3f}".format(before_acmr) + " -> " + "{:.3f}".format(acmr(indices)) +
+          ", bytes: " + str(before_size) + " -> " + str(buffer_size(positions, vertices, indices)))
+
+    return positions, vertices, indices
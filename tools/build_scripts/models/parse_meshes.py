@@ -1,4 +1,7 @@
 import models.helpers as helpers
+import models.optimise_meshes as optimise_meshes
+import models.quantize_vertices as quantize_vertices
+import models.simplify_meshes as simplify_meshes
 import struct
 
 schema = "{http://www.collada.org/2005/11/COLLADASchema}"
@@ -57,6 +60,7 @@ class geometry_mesh:
     max_extents = []
     collision_vertices = []
     controller = None
+    lods = []
 
     semantic_ids = [
         "POSITION",
@@ -430,9 +434,30 @@ def parse_geometry(node, lib_controllers):
                 geom_container.meshes.append(parse_mesh(mesh, tris, geom_container.controller))
                 submesh = submesh + 1
 
+        for mesh in geom_container.meshes:
+            pb, vb, ib = optimise_meshes.optimise_mesh(geom_container.name, mesh.vertex_elements[0].float_values,
+                                                       mesh.vertex_buffer, mesh.index_buffer)
+            mesh.vertex_elements[0].float_values = pb
+            mesh.vertex_buffer = vb
+            mesh.index_buffer = ib
+            mesh.lods = simplify_meshes.generate_lods(geom_container.name, pb, ib)
+
         write_geometry_file(geom_container)
 
 
+# simplified index buffers into the vertex buffer of lod 0, returns the size in bytes
+def write_lods(mesh_data, lods, index_type):
+    mesh_data.append(struct.pack("i", len(lods)))
+    data_size = 4
+    for error, indices in lods:
+        mesh_data.append(struct.pack("f", float(error)))
+        mesh_data.append(struct.pack("i", len(indices)))
+        for index in indices:
+            mesh_data.append(struct.pack(index_type, int(index)))
+        data_size += 8 + len(indices) * struct.calcsize(index_type)
+    return data_size
+
+
 def write_geometry_file(geom_instance):
     # write out geometry
     num_meshes = len(geom_instance.meshes)
@@ -441,7 +466,7 @@ def write_geometry_file(geom_instance):
 
     print("packing geometry: " + geom_instance.name)
 
-    geometry_data = [struct.pack("i", (int(helpers.version_number))),
+    geometry_data = [struct.pack("i", (int(helpers.geometry_version_number))),
                      struct.pack("i", (int(num_meshes)))]
 
     for mat in geom_instance.materials:
@@ -460,9 +485,24 @@ def write_geometry_file(geom_instance):
             mesh_data.append(struct.pack("f", (float(mesh.min_extents[i]))))
         for i in range(0, 3, 1):
             mesh_data.append(struct.pack("f", (float(mesh.max_extents[i]))))
+        skinned = 0
+        if geom_instance.controller != None:
+            skinned = 1
+
+        num_floats = len(mesh.vertex_elements[0].float_values)
+        num_vertices = num_floats / 4
+
+        vertex_format = quantize_vertices.vertex_format_float
+        vertex_buffer = [struct.pack("f", (float(vertexfloat))) for vertexfloat in mesh.vertex_buffer]
+        if quantize_vertices.can_quantize(mesh.vertex_buffer, int(num_vertices), skinned):
+            vertex_format = quantize_vertices.vertex_format_quantized
+            vertex_buffer = quantize_vertices.quantize_vertex_buffer(geom_instance.name, mesh.vertex_buffer,
+                                                                     int(num_vertices), skinned,
+                                                                     mesh.min_extents, mesh.max_extents)
+
         # write vb and ib
         mesh_data.append(struct.pack("i", (len(mesh.vertex_elements[0].float_values))))
-        mesh_data.append(struct.pack("i", (len(mesh.vertex_buffer))))
+        mesh_data.append(struct.pack("i", (len(vertex_buffer))))
 
         mesh_data.append(struct.pack("i", (len(mesh.index_buffer))))
         mesh_data.append(struct.pack("i", (len(mesh.collision_vertices))))
@@ -471,14 +511,8 @@ def write_geometry_file(geom_instance):
         if len(mesh.index_buffer) < 65535:
             index_type = "H"
 
-        skinned = 0
-        if geom_instance.controller != None:
-            skinned = 1
-
-        num_floats = len(mesh.vertex_elements[0].float_values)
-        num_vertices = num_floats / 4
-
         mesh_data.append(struct.pack("i", int(skinned)))
+        mesh_data.append(struct.pack("i", int(vertex_format)))
 
         if skinned:
             helpers.pack_corrected_4x4matrix(mesh_data, geom_instance.controller.bind_shape_matrix)
@@ -487,8 +521,8 @@ def write_geometry_file(geom_instance):
         for vertexfloat in mesh.vertex_elements[0].float_values:
             # position only buffer
             mesh_data.append(struct.pack("f", (float(vertexfloat))))
-        for vertexfloat in mesh.vertex_buffer:
-            mesh_data.append(struct.pack("f", (float(vertexfloat))))
+        for packed in vertex_buffer:
+            mesh_data.append(packed)
 
         data_size += len(mesh_data)*4
 
@@ -502,6 +536,8 @@ def write_geometry_file(geom_instance):
 
         data_size += len(mesh.collision_vertices) * 4
 
+        data_size += write_lods(mesh_data, mesh.lods, index_type)
+
         for m in mesh_data:
             geometry_data.append(m)
 
@@ -1,4 +1,8 @@
 import models.helpers as helpers
+import models.optimise_meshes as optimise_meshes
+import models.quantize_vertices as quantize_vertices
+import models.simplify_meshes as simplify_meshes
+import models.parse_meshes as parse_meshes
 import os
 import struct
 import sys
@@ -248,7 +252,7 @@ def write_geometry(file, root):
     if cur_mesh:
         meshes.append(cur_mesh)
 
-    geometry_data = [struct.pack("i", (int(helpers.version_number))),
+    geometry_data = [struct.pack("i", (int(helpers.geometry_version_number))),
                      struct.pack("i", (int(len(meshes))))]
 
     for m in meshes:
@@ -262,6 +266,17 @@ def write_geometry(file, root):
             generated_vb = calc_normals(generated_vb)
             generated_vb = calc_tangents(generated_vb)
 
+        mesh_pb, generated_vb, mesh_ib = optimise_meshes.optimise_mesh(mesh[0], mesh[pb], generated_vb, mesh[ib])
+        mesh_lods = simplify_meshes.generate_lods(mesh[0], mesh_pb, mesh_ib)
+
+        num_vertices = len(mesh_pb) // 4
+        vertex_format = quantize_vertices.vertex_format_float
+        vertex_buffer = [struct.pack("f", (float(vf))) for vf in generated_vb]
+        if quantize_vertices.can_quantize(generated_vb, num_vertices, False):
+            vertex_format = quantize_vertices.vertex_format_quantized
+            vertex_buffer = quantize_vertices.quantize_vertex_buffer(mesh[0], generated_vb, num_vertices, False,
+                                                                     min_extents, max_extents)
+
         mesh_data = []
 
         # write min / max extents
@@ -271,36 +286,39 @@ def write_geometry(file, root):
             mesh_data.append(struct.pack("f", (float(max_extents[i]))))
 
         # write vb and ib
-        mesh_data.append(struct.pack("i", (len(mesh[pb]))))
-        mesh_data.append(struct.pack("i", (len(generated_vb))))
-        mesh_data.append(struct.pack("i", (len(mesh[ib]))))
+        mesh_data.append(struct.pack("i", (len(mesh_pb))))
+        mesh_data.append(struct.pack("i", (len(vertex_buffer))))
+        mesh_data.append(struct.pack("i", (len(mesh_ib))))
         mesh_data.append(struct.pack("i", (len(mesh[cb]))))
 
         index_type = "i"
-        if len(mesh[ib]) < 65535:
+        if len(mesh_ib) < 65535:
             index_type = "H"
 
         # obj always non-skinned
         mesh_data.append(struct.pack("i", int(0)))
+        mesh_data.append(struct.pack("i", int(vertex_format)))
 
-        for vf in mesh[pb]:
+        for vf in mesh_pb:
             # position only buffer
             mesh_data.append(struct.pack("f", (float(vf))))
-        for vf in generated_vb:
-            mesh_data.append(struct.pack("f", (float(vf))))
+        for packed in vertex_buffer:
+            mesh_data.append(packed)
 
         data_size += len(mesh_data)*4
 
-        for index in mesh[ib]:
+        for index in mesh_ib:
             mesh_data.append(struct.pack(index_type, (int(index))))
 
-        data_size += len(mesh[ib]) * 2
+        data_size += len(mesh_ib) * 2
 
         for vf in mesh[cb]:
             mesh_data.append(struct.pack("f", (float(vf))))
 
         data_size += len(mesh[cb]) * 4
 
+        data_size += parse_meshes.write_lods(mesh_data, mesh_lods, index_type)
+
         for m in mesh_data:
             geometry_data.append(m)
 
@@ -0,0 +1,97 @@
+import struct
+
+# packs the interleaved float4 vertex buffer written by generate_vertex_buffer (position, normal, texcoord 0 and 1,
+# tangent, bitangent and optionally blend indices and weights) into put::ecs::vertex_model_quantized.
+# positions are 16 bit unorms over the submesh extents, normals and tangents are 16 bit octahedral, the bitangent is
+# rebuilt in the shader from a sign. uvs stay f32, the renderer has no half vertex format.
+
+enabled = False
+
+vertex_format_float = 0
+vertex_format_quantized = 1
+
+float_stride = 20
+float_stride_skinned = 28
+
+stats = {"float_bytes": 0, "quantized_bytes": 0}
+
+
+def unorm16(v):
+    return int(round(min(max(v, 0.0), 1.0) * 65535.0))
+
+
+def sign_not_zero(v):
+    return 1.0 if v >= 0.0 else -1.0
+
+
+def oct_encode(v):
+    l = abs(v[0]) + abs(v[1]) + abs(v[2])
+    if l == 0.0:
+        return [unorm16(0.5), unorm16(0.5)]
+    x = v[0] / l
+    y = v[1] / l
+    if v[2] < 0.0:
+        x, y = (1.0 - abs(y)) * sign_not_zero(x), (1.0 - abs(x)) * sign_not_zero(y)
+    return [unorm16(x * 0.5 + 0.5), unorm16(y * 0.5 + 0.5)]
+
+
+def cross3(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+
+def dot3(a, b):
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+
+def pack_lo_hi(values):
+    return struct.pack("4B", values[0] & 0xff, values[0] >> 8, values[1] & 0xff, values[1] >> 8)
+
+
+# u8 weights which still sum to 1, rounding error goes on the largest weight
+def quantize_weights(weights):
+    q = [int(round(min(max(w, 0.0), 1.0) * 255.0)) for w in weights]
+    total = sum(q)
+    if total > 0:
+        largest = weights.index(max(weights))
+        q[largest] = min(max(q[largest] + 255 - total, 0), 255)
+    return q
+
+
+def can_quantize(vertices, num_vertices, skinned):
+    if not enabled or num_vertices == 0:
+        return False
+    stride = float_stride_skinned if skinned else float_stride
+    return len(vertices) == num_vertices * stride
+
+
+# returns a list of 4 byte packed values to match the float writer
+def quantize_vertex_buffer(name, vertices, num_vertices, skinned, min_extents, max_extents):
+    stride = float_stride_skinned if skinned else float_stride
+    extents = [float(max_extents[i]) - float(min_extents[i]) for i in range(3)]
+    packed = []
+    for v in range(num_vertices):
+        f = [float(x) for x in vertices[v * stride:v * stride + stride]]
+        pos = []
+        for i in range(3):
+            pos.append(unorm16((f[i] - float(min_extents[i])) / extents[i]) if extents[i] > 0.0 else 0)
+        normal = f[4:7]
+        tangent = f[12:15]
+        bitangent = f[16:19]
+        bitangent_sign = 255 if dot3(cross3(normal, tangent), bitangent) >= 0.0 else 0
+        packed.append(struct.pack("4B", pos[0] & 0xff, pos[1] & 0xff, pos[2] & 0xff, bitangent_sign))
+        packed.append(struct.pack("4B", pos[0] >> 8, pos[1] >> 8, pos[2] >> 8, 0))
+        packed.append(pack_lo_hi(oct_encode(normal)))
+        packed.append(pack_lo_hi(oct_encode(tangent)))
+        for i in range(8, 12):
+            packed.append(struct.pack("f", f[i]))
+        if skinned:
+            indices = [min(max(int(round(i)), 0), 255) for i in f[20:24]]
+            packed.append(struct.pack("4B", *indices))
+            packed.append(struct.pack("4B", *quantize_weights(f[24:28])))
+
+    float_bytes = len(vertices) * 4
+    quantized_bytes = len(packed) * 4
+    stats["float_bytes"] += float_bytes
+    stats["quantized_bytes"] += quantized_bytes
+    print("quantized vertices: " + name + ", bytes: " + str(float_bytes) + " -> " + str(quantized_bytes))
+    return packed
@@ -0,0 +1,198 @@
+import heapq
+import models.optimise_meshes as optimise_meshes
+
+# generates lod index buffers with quadric error edge collapse (garland and heckbert 1997). collapses are half edge,
+# a vertex moves onto one of its neighbours, so every lod indexes the vertex buffer of lod 0. vertices split on uv
+# or normal seams are open borders to the collapse and are held in place by border quadrics.
+
+enabled = True
+max_lods = 4  # including lod 0, must match put::ecs::k_max_lods
+lod_ratio = 0.5  # triangle count of each lod relative to the previous
+min_triangles = 64  # meshes with fewer triangles, or lods which would go below this are not generated
+border_weight = 10.0
+
+stats = {"source_triangles": 0, "lod_triangles": 0}
+
+
+def sub3(a, b):
+    return [a[0] - b[0], a[1] - b[1], a[2] - b[2]]
+
+
+def dot3(a, b):
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+
+def cross3(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+
+def normalize3(v):
+    l = dot3(v, v) ** 0.5
+    if l == 0.0:
+        return None
+    return [v[0] / l, v[1] / l, v[2] / l]
+
+
+# symmetric 4x4 stored as the upper triangle, a a, a b, a c, a d, b b, b c, b d, c c, c d, d d
+def plane_quadric(n, d, w):
+    a, b, c = n
+    return [w * a * a, w * a * b, w * a * c, w * a * d, w * b * b, w * b * c, w * b * d, w * c * c, w * c * d, w * d * d]
+
+
+def add_quadric(q, r):
+    for i in range(10):
+        q[i] += r[i]
+
+
+def quadric_error(q, p):
+    x, y, z = p
+    e = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x + \
+        q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y + \
+        q[7] * z * z + 2.0 * q[8] * z + q[9]
+    return max(e, 0.0)
+
+
+class simplifier:
+    def __init__(self, positions, indices):
+        self.num_vertices = len(positions) // 4
+        self.pos = [positions[v * 4:v * 4 + 3] for v in range(self.num_vertices)]
+        self.tris = [indices[t * 3:t * 3 + 3] for t in range(len(indices) // 3)]
+        self.live_tris = len(self.tris)
+        self.alive = [True] * len(self.tris)
+        self.removed = [False] * self.num_vertices
+        self.version = [0] * self.num_vertices
+        self.vertex_tris = [set() for v in range(self.num_vertices)]
+        self.quadrics = [[0.0] * 10 for v in range(self.num_vertices)]
+        self.max_error = 0.0
+        self.heap = []
+
+        edge_count = dict()
+        for t, tri in enumerate(self.tris):
+            for v in tri:
+                self.vertex_tris[v].add(t)
+            p0, p1, p2 = self.pos[tri[0]], self.pos[tri[1]], self.pos[tri[2]]
+            n = normalize3(cross3(sub3(p1, p0), sub3(p2, p0)))
+            if not n:
+                continue
+            q = plane_quadric(n, -dot3(n, p0), 1.0)
+            for v in tri:
+                add_quadric(self.quadrics[v], q)
+            for i in range(3):
+                e = (min(tri[i], tri[(i + 1) % 3]), max(tri[i], tri[(i + 1) % 3]))
+                edge_count[e] = edge_count.get(e, 0) + 1
+
+        # planes perpendicular to border edges keep open borders and seams from collapsing inward
+        for t, tri in enumerate(self.tris):
+            p0, p1, p2 = self.pos[tri[0]], self.pos[tri[1]], self.pos[tri[2]]
+            face_n = cross3(sub3(p1, p0), sub3(p2, p0))
+            for i in range(3):
+                a = tri[i]
+                b = tri[(i + 1) % 3]
+                if edge_count.get((min(a, b), max(a, b)), 0) != 1:
+                    continue
+                n = normalize3(cross3(sub3(self.pos[b], self.pos[a]), face_n))
+                if not n:
+                    continue
+                q = plane_quadric(n, -dot3(n, self.pos[a]), border_weight)
+                add_quadric(self.quadrics[a], q)
+                add_quadric(self.quadrics[b], q)
+
+        for v in range(self.num_vertices):
+            self.push_candidates(v)
+
+    def neighbours(self, v):
+        n = set()
+        for t in self.vertex_tris[v]:
+            n.update(self.tris[t])
+        n.discard(v)
+        return n
+
+    def collapse_cost(self, u, v):
+        q = list(self.quadrics[u])
+        add_quadric(q, self.quadrics[v])
+        return quadric_error(q, self.pos[v])
+
+    def push_candidates(self, u):
+        for v in self.neighbours(u):
+            heapq.heappush(self.heap, (self.collapse_cost(u, v), u, v, self.version[u], self.version[v]))
+            heapq.heappush(self.heap, (self.collapse_cost(v, u), v, u, self.version[v], self.version[u]))
+
+    # moving u onto v must not flip or collapse any triangle which survives
+    def valid_collapse(self, u, v):
+        for t in self.vertex_tris[u]:
+            tri = self.tris[t]
+            if v in tri:
+                continue
+            p = [self.pos[i] for i in tri]
+            before = cross3(sub3(p[1], p[0]), sub3(p[2], p[0]))
+            p = [self.pos[v] if tri[i] == u else p[i] for i in range(3)]
+            after = cross3(sub3(p[1], p[0]), sub3(p[2], p[0]))
+            if dot3(before, after) <= 0.0:
+                return False
+        return True
+
+    def collapse(self, u, v):
+        for t in list(self.vertex_tris[u]):
+            tri = self.tris[t]
+            if v in tri:
+                self.alive[t] = False
+                self.live_tris -= 1
+                for i in tri:
+                    self.vertex_tris[i].discard(t)
+            else:
+                self.tris[t] = [v if i == u else i for i in tri]
+                self.vertex_tris[v].add(t)
+        self.vertex_tris[u] = set()
+        self.removed[u] = True
+        add_quadric(self.quadrics[v], self.quadrics[u])
+        # only collapses touching v change cost, they are pushed again with the new version
+        self.version[v] += 1
+        self.push_candidates(v)
+
+    def reduce(self, target_tris):
+        while self.live_tris > target_tris and len(self.heap) > 0:
+            cost, u, v, version_u, version_v = heapq.heappop(self.heap)
+            if self.removed[u] or self.removed[v]:
+                continue
+            if version_u != self.version[u] or version_v != self.version[v]:
+                continue
+            if not self.valid_collapse(u, v):
+                continue
+            self.max_error = max(self.max_error, cost)
+            self.collapse(u, v)
+
+    def indices(self):
+        output = []
+        for t, tri in enumerate(self.tris):
+            if self.alive[t]:
+                output.extend(tri)
+        return output
+
+
+# returns a list of (error, indices) for lod 1 onwards, error is an object space distance
+def generate_lods(name, positions, indices):
+    num_tris = len(indices) // 3
+    if not enabled or num_tris < min_triangles or len(positions) == 0:
+        return []
+
+    s = simplifier([float(p) for p in positions], indices)
+    lods = []
+    prev_tris = num_tris
+    while len(lods) + 1 < max_lods:
+        target = int(prev_tris * lod_ratio)
+        if target < min_triangles:
+            break
+        s.reduce(target)
+        # stop when collapses run out before getting near the target
+        if s.live_tris > prev_tris * (lod_ratio + 1.0) * 0.5:
+            break
+        lod_indices, clusters = optimise_meshes.tipsify(s.indices(), s.num_vertices)
+        lods.append((s.max_error ** 0.5, lod_indices))
+        prev_tris = s.live_tris
+
+    stats["source_triangles"] += num_tris
+    stats["lod_triangles"] += sum(len(l[1]) // 3 for l in lods)
+    if len(lods) > 0:
+        print("lods: " + name + ", triangles: " + str(num_tris) + " -> " +
+              ", ".join(str(len(l[1]) // 3) + " ({:.4f})".format(l[0]) for l in lods))
+    return lods